@@ -40,5 +40,6 @@
  * Open "include/lwjson/lwjson_opt.h" and
  * copy & replace here settings you want to change values
  */
+#define LWJSON_CFG_TOKEN_SPAN               1
 
 #endif /* LWJSON_HDR_OPTS_H */
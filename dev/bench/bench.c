@@ -0,0 +1,459 @@
+/*
+ * Throughput benchmark of parsing and path lookup
+ *
+ * Build with CMake, target `lwjson_bench`, or on any POSIX system together with
+ * all library sources from "lwjson/src/lwjson" directory.
+ *
+ * Run with list of JSON files, checked-in corpus is in "test/json/corpus":
+ *
+ *  ./lwjson_bench [-w warmup] [-r repetitions] [-t rep_time_ms] [-p 1] [-o results.json] file.json...
+ *
+ * Every file is parsed for `warmup` repetitions first, then for `repetitions` measured repetitions.
+ * Each repetition runs as many iterations as fit into `rep_time_ms`, and every iteration is timed separately.
+ * Iterations shorter than `1 us` are timed in groups of `batch` iterations, to keep clock overhead small,
+ * and sample is then mean of the group. Median and 99th percentile of samples are reported as table,
+ * and written as JSON document to `results.json` for regression tracking, together with number of samples
+ * and group size. 99th percentile needs at least `100` samples and is reported as `null` otherwise.
+ *
+ * Option `-p 1` measures \ref lwjson_parse_pipelined too, with its median time and gain over \ref lwjson_parse_ex.
+ * It needs library built with parallel threads, and at least \ref LWJSON_CFG_PIPELINE_MIN_CPUS online processors
+ * to start scanner thread. With less processors it measures single thread fallback.
+ */
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "lwjson/lwjson.h"
+
+#define BENCH_MAX_PATHS                     256
+#define BENCH_MAX_PATH_LEN                  256
+#define BENCH_MAX_REPS                      1000
+#define BENCH_MAX_SAMPLES                   (1 << 20)
+#define BENCH_MIN_SAMPLE_NS                 1000.0
+#define BENCH_MIN_P99_SAMPLES               100
+
+/**
+ * \brief           Result of one measured operation
+ */
+typedef struct {
+    double median_ns;                           /*!< Median time of one iteration */
+    double p99_ns;                              /*!< 99th percentile time of one iteration, negative when not enough samples */
+    size_t samples;                             /*!< Number of samples */
+    size_t batch;                               /*!< Number of iterations timed together in one sample */
+} bench_stat_t;
+
+/**
+ * \brief           Result for one input file
+ */
+typedef struct {
+    const char* path;                           /*!< File path */
+    size_t len;                                 /*!< File length in units of bytes */
+    size_t tokens;                              /*!< Number of parsed tokens */
+    size_t lookups;                             /*!< Number of paths looked up in one iteration */
+    bench_stat_t parse;                         /*!< Parse time */
+    bench_stat_t find;                          /*!< Time of all lookups */
+    bench_stat_t pipelined;                     /*!< Pipelined parse time, measured with `-p 1` only */
+} bench_result_t;
+
+static size_t warmup = 3, reps = 21, pipelined;
+static double rep_time_ns = 20e6;
+static double samples[BENCH_MAX_SAMPLES];
+
+static char paths[BENCH_MAX_PATHS][BENCH_MAX_PATH_LEN];
+static size_t paths_len;
+static char** all_paths;
+static size_t all_paths_len, all_paths_cap;
+
+static double
+now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int
+bench_cmp(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * \brief           Sort samples and get median and 99th percentile
+ * \param[in]       n: Number of samples
+ */
+static bench_stat_t
+bench_stat(size_t n) {
+    bench_stat_t st;
+
+    qsort(samples, n, sizeof(samples[0]), bench_cmp);
+    st.median_ns = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    st.p99_ns = n >= BENCH_MIN_P99_SAMPLES ? samples[(n * 99 + 99) / 100 - 1] : -1;
+    st.samples = n;
+    st.batch = 1;
+    return st;
+}
+
+/**
+ * \brief           Collect paths of all named tokens, usable with \ref lwjson_find
+ * \param[in]       parent: Object or array token
+ * \param[in]       path: Path of parent, with trailing dot
+ * \param[in]       path_len: Length of parent path
+ */
+static void
+bench_collect(const lwjson_token_t* parent, char* path, size_t path_len) {
+    for (const lwjson_token_t* t = lwjson_get_first_child(parent); t != NULL; t = t->next) {
+        size_t len = path_len;
+
+        if (parent->type == LWJSON_TYPE_ARRAY) {
+            /* Wildcard matches first element, other elements cannot be addressed */
+            if (t != lwjson_get_first_child(parent) || len + 2 >= BENCH_MAX_PATH_LEN) {
+                break;
+            }
+            memcpy(&path[len], "#.", 2);
+            len += 2;
+        } else {
+            if (len + t->token_name_len + 1 >= BENCH_MAX_PATH_LEN
+                || memchr(t->token_name, '.', t->token_name_len) != NULL
+                || (t->token_name_len > 0 && t->token_name[0] == '#')) {
+                continue;
+            }
+            memcpy(&path[len], t->token_name, t->token_name_len);
+            len += t->token_name_len;
+            path[len] = '\0';
+            if (all_paths_len == all_paths_cap) {
+                all_paths_cap = all_paths_cap > 0 ? 2 * all_paths_cap : 1024;
+                all_paths = realloc(all_paths, all_paths_cap * sizeof(*all_paths));
+            }
+            all_paths[all_paths_len] = malloc(len + 1);
+            memcpy(all_paths[all_paths_len++], path, len + 1);
+            path[len++] = '.';
+        }
+        if (t->type == LWJSON_TYPE_OBJECT || t->type == LWJSON_TYPE_ARRAY) {
+            bench_collect(t, path, len);
+        }
+    }
+}
+
+/**
+ * \brief           Select lookup paths evenly spread over all paths of the document
+ * \return          `1` when all selected paths are found, `0` otherwise
+ */
+static int
+bench_select_paths(const lwjson_t* lw) {
+    char path[BENCH_MAX_PATH_LEN];
+    int ok = 1;
+
+    all_paths_len = 0;
+    bench_collect(lwjson_get_first_token(lw), path, 0);
+    paths_len = all_paths_len < BENCH_MAX_PATHS ? all_paths_len : BENCH_MAX_PATHS;
+    for (size_t i = 0; i < paths_len; ++i) {
+        strcpy(paths[i], all_paths[i * all_paths_len / paths_len]);
+        if (lwjson_find(lw, paths[i]) == NULL) {
+            ok = 0;
+        }
+    }
+    for (size_t i = 0; i < all_paths_len; ++i) {
+        free(all_paths[i]);
+    }
+    return ok;
+}
+
+static void
+bench_parse_iter(lwjson_t* lw, const char* text, size_t len) {
+    lwjson_parse_ex(lw, text, len);
+}
+
+#if LWJSON_CFG_PARALLEL_THREADS
+static void
+bench_pipelined_iter(lwjson_t* lw, const char* text, size_t len) {
+    lwjson_parse_pipelined(lw, text, len);
+}
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+
+static size_t bench_sink;
+
+static void
+bench_find_iter(lwjson_t* lw, const char* text, size_t len) {
+    (void)text;
+    (void)len;
+    for (size_t i = 0; i < paths_len; ++i) {
+        bench_sink += (size_t)lwjson_find(lw, paths[i]);
+    }
+}
+
+/**
+ * \brief           Run warmup and measured repetitions of one operation
+ * \param[in]       fn: Operation of one iteration
+ * \return          Median and 99th percentile time of one iteration
+ */
+static bench_stat_t
+bench_run(void (*fn)(lwjson_t*, const char*, size_t), lwjson_t* lw, const char* text, size_t len) {
+    size_t batch = 1, samples_per_rep, n = 0;
+    double t, t_min = 0;
+    bench_stat_t st;
+
+    /* Calibrate shortest iteration time, then group size and number of samples per repetition */
+    for (size_t i = 0; i < 3; ++i) {
+        t = now_ns();
+        fn(lw, text, len);
+        t = now_ns() - t;
+        t_min = i == 0 || t < t_min ? t : t_min;
+    }
+    t_min = t_min > 1 ? t_min : 1;
+    if (t_min < BENCH_MIN_SAMPLE_NS) {
+        batch = (size_t)(BENCH_MIN_SAMPLE_NS / t_min) + 1;
+    }
+    samples_per_rep = (size_t)(rep_time_ns / (t_min * (double)batch));
+    if (samples_per_rep < 1) {
+        samples_per_rep = 1;
+    } else if (samples_per_rep * reps > BENCH_MAX_SAMPLES) {
+        samples_per_rep = BENCH_MAX_SAMPLES / reps;
+    }
+
+    for (size_t r = 0; r < warmup + reps; ++r) {
+        for (size_t s = 0; s < samples_per_rep; ++s) {
+            t = now_ns();
+            for (size_t i = 0; i < batch; ++i) {
+                fn(lw, text, len);
+            }
+            t = now_ns() - t;
+            if (r >= warmup) {
+                samples[n++] = t / (double)batch;
+            }
+        }
+    }
+    st = bench_stat(n);
+    st.batch = batch;
+    return st;
+}
+
+/**
+ * \brief           Read whole file to memory
+ */
+static char*
+bench_read(const char* path, size_t* len) {
+    FILE* f = fopen(path, "rb");
+    char* text = NULL;
+    long file_size;
+
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (file_size > 0 && (text = malloc((size_t)file_size + 1)) != NULL) {
+        if (fread(text, 1, (size_t)file_size, f) == (size_t)file_size) {
+            text[file_size] = '\0';
+            *len = (size_t)file_size;
+        } else {
+            free(text);
+            text = NULL;
+        }
+    }
+    fclose(f);
+    return text;
+}
+
+static int
+bench_file(const char* path, bench_result_t* res) {
+    lwjson_token_t* tokens;
+    lwjson_t lwjson;
+    char* text;
+    size_t len;
+    int ok = 0;
+
+    memset(res, 0x00, sizeof(*res));
+    res->path = path;
+    if ((text = bench_read(path, &len)) == NULL) {
+        printf("Cannot read %s\r\n", path);
+        return 0;
+    }
+
+    /* Every token takes at least one character of input */
+    if ((tokens = calloc(len + 1, sizeof(*tokens))) != NULL) {
+        lwjson_init(&lwjson, tokens, len + 1);
+        if (lwjson_parse_ex(&lwjson, text, len) != lwjsonOK) {
+            printf("Cannot parse %s\r\n", path);
+        } else if (!bench_select_paths(&lwjson)) {
+            printf("Lookup failed on %s\r\n", path);
+        } else {
+            res->len = len;
+            res->tokens = lwjson.next_free_token_pos;
+            res->lookups = paths_len;
+            res->parse = bench_run(bench_parse_iter, &lwjson, text, len);
+            if (paths_len > 0) {
+                res->find = bench_run(bench_find_iter, &lwjson, text, len);
+            }
+#if LWJSON_CFG_PARALLEL_THREADS
+            if (pipelined) {
+                res->pipelined = bench_run(bench_pipelined_iter, &lwjson, text, len);
+            }
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+            ok = 1;
+        }
+        free(tokens);
+    }
+    free(text);
+    return ok;
+}
+
+static lwjsonr_t
+bench_write_file(lwjson_writer_t* w, const char* data, size_t len) {
+    return fwrite(data, 1, len, w->arg) == len ? lwjsonOK : lwjsonERR;
+}
+
+static void
+bench_write_stat(lwjson_writer_t* w, const char* key, const bench_stat_t* st, double per, const char* per_key) {
+    lwjson_writer_key(w, key, strlen(key));
+    lwjson_writer_begin_object(w);
+    lwjson_writer_key(w, "median_ns", 9);
+    lwjson_writer_int(w, (lwjson_int_t)(st->median_ns + 0.5));
+    lwjson_writer_key(w, "p99_ns", 6);
+    if (st->p99_ns >= 0) {
+        lwjson_writer_int(w, (lwjson_int_t)(st->p99_ns + 0.5));
+    } else {
+        lwjson_writer_null(w);
+    }
+    lwjson_writer_key(w, "samples", 7);
+    lwjson_writer_int(w, (lwjson_int_t)st->samples);
+    lwjson_writer_key(w, "batch", 5);
+    lwjson_writer_int(w, (lwjson_int_t)st->batch);
+    lwjson_writer_key(w, per_key, strlen(per_key));
+    lwjson_writer_real(w, (lwjson_real_t)per);
+    lwjson_writer_end(w);
+}
+
+/**
+ * \brief           Write results as JSON document
+ */
+static int
+bench_write_results(const char* out, const bench_result_t* results, size_t results_len) {
+    lwjson_writer_t w;
+    char buf[256];
+    int ok;
+    FILE* f;
+
+    if ((f = fopen(out, "wb")) == NULL) {
+        return 0;
+    }
+    lwjson_writer_init(&w, buf, sizeof(buf), bench_write_file, f);
+    lwjson_writer_begin_object(&w);
+    lwjson_writer_key(&w, "warmup", 6);
+    lwjson_writer_int(&w, (lwjson_int_t)warmup);
+    lwjson_writer_key(&w, "repetitions", 11);
+    lwjson_writer_int(&w, (lwjson_int_t)reps);
+    lwjson_writer_key(&w, "token_size", 10);
+    lwjson_writer_int(&w, (lwjson_int_t)sizeof(lwjson_token_t));
+    lwjson_writer_key(&w, "cpus", 4);
+    lwjson_writer_int(&w, (lwjson_int_t)sysconf(_SC_NPROCESSORS_ONLN));
+    lwjson_writer_key(&w, "files", 5);
+    lwjson_writer_begin_array(&w);
+    for (size_t i = 0; i < results_len; ++i) {
+        const bench_result_t* r = &results[i];
+
+        lwjson_writer_begin_object(&w);
+        lwjson_writer_key(&w, "file", 4);
+        lwjson_writer_string(&w, r->path, strlen(r->path));
+        lwjson_writer_key(&w, "bytes", 5);
+        lwjson_writer_int(&w, (lwjson_int_t)r->len);
+        lwjson_writer_key(&w, "tokens", 6);
+        lwjson_writer_int(&w, (lwjson_int_t)r->tokens);
+        lwjson_writer_key(&w, "lookups", 7);
+        lwjson_writer_int(&w, (lwjson_int_t)r->lookups);
+        bench_write_stat(&w, "parse", &r->parse, r->tokens > 0 ? r->parse.median_ns / (double)r->tokens : 0,
+                         "ns_token");
+        lwjson_writer_key(&w, "mb_s", 4);
+        lwjson_writer_real(&w, (lwjson_real_t)((double)r->len * 1e3 / r->parse.median_ns));
+        bench_write_stat(&w, "find", &r->find, r->lookups > 0 ? r->find.median_ns / (double)r->lookups : 0,
+                         "ns_lookup");
+        if (pipelined) {
+            bench_write_stat(&w, "pipelined", &r->pipelined, r->parse.median_ns / r->pipelined.median_ns, "speedup");
+        }
+        lwjson_writer_end(&w);
+    }
+    lwjson_writer_end(&w);
+    lwjson_writer_end(&w);
+    ok = lwjson_writer_flush(&w) == lwjsonOK && w.err == lwjsonOK && fputc('\n', f) != EOF;
+    return fclose(f) == 0 && ok;
+}
+
+int
+main(int argc, char** argv) {
+    bench_result_t* results;
+    size_t results_len = 0;
+    const char* out = NULL;
+    int i, ok = 1;
+
+    for (i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        if (strcmp(argv[i], "-w") == 0) {
+            warmup = (size_t)atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-r") == 0) {
+            reps = (size_t)atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-t") == 0) {
+            rep_time_ns = atof(argv[i + 1]) * 1e6;
+        } else if (strcmp(argv[i], "-p") == 0) {
+            pipelined = (size_t)atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-o") == 0) {
+            out = argv[i + 1];
+        } else {
+            break;
+        }
+    }
+    if (i >= argc || reps < 1 || reps > BENCH_MAX_REPS) {
+        printf("Usage: %s [-w warmup] [-r repetitions] [-t rep_time_ms] [-p 1] [-o results.json] file.json...\r\n",
+               argv[0]);
+        return 1;
+    }
+#if LWJSON_CFG_PARALLEL_THREADS
+    if (pipelined && sysconf(_SC_NPROCESSORS_ONLN) < LWJSON_CFG_PIPELINE_MIN_CPUS) {
+        printf("Only %ld online processors, pipelined parse runs in single thread\r\n", sysconf(_SC_NPROCESSORS_ONLN));
+    }
+#else
+    if (pipelined) {
+        printf("Pipelined parse needs LWJSON_CFG_PARALLEL_THREADS\r\n");
+        return 1;
+    }
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+    if ((results = calloc((size_t)(argc - i), sizeof(*results))) == NULL) {
+        return 1;
+    }
+
+    printf("%-32s %9s %8s %10s %10s %9s %9s %10s %10s", "File", "Bytes", "Tokens", "Parse med", "Parse p99",
+           "MB/s", "ns/token", "Find med", "ns/lookup");
+    printf(pipelined ? " %10s %7s\r\n" : "\r\n", "Pipe med", "Gain");
+    for (; i < argc; ++i) {
+        const char* name = strrchr(argv[i], '/') != NULL ? strrchr(argv[i], '/') + 1 : argv[i];
+        bench_result_t* r = &results[results_len];
+        char p99[32];
+
+        if (!bench_file(argv[i], r)) {
+            ok = 0;
+            continue;
+        }
+        ++results_len;
+        if (r->parse.p99_ns >= 0) {
+            sprintf(p99, "%.1fus", r->parse.p99_ns / 1e3);
+        } else {
+            strcpy(p99, "-");
+        }
+        printf("%-32s %9u %8u %8.1fus %10s %9.1f %9.2f %8.1fus %10.1f", name, (unsigned)r->len,
+               (unsigned)r->tokens, r->parse.median_ns / 1e3, p99,
+               (double)r->len * 1e3 / r->parse.median_ns, r->parse.median_ns / (double)r->tokens, r->find.median_ns / 1e3,
+               r->lookups > 0 ? r->find.median_ns / (double)r->lookups : 0);
+        if (pipelined) {
+            printf(" %8.1fus %6.2fx", r->pipelined.median_ns / 1e3, r->parse.median_ns / r->pipelined.median_ns);
+        }
+        printf("\r\n");
+    }
+    if (out != NULL && !bench_write_results(out, results, results_len)) {
+        printf("Cannot write %s\r\n", out);
+        ok = 0;
+    }
+    free(results);
+    free(all_paths);
+    return ok ? 0 : 1;
+}
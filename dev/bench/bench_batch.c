@@ -0,0 +1,145 @@
+/*
+ * Benchmark of batch file parsing against serial read-then-parse loop
+ *
+ * Build on POSIX system together with all library sources from "lwjson/src/lwjson" directory,
+ * with `LWJSON_CFG_PARALLEL_THREADS` enabled and linked with `pthread` library.
+ *
+ * Run with directory of JSON files, number of threads and mode, one of `serial`, `batch` or `both`:
+ *
+ *  ./bench_batch ../../test/json 8 both
+ *
+ * Before every timed run, pages of all files are dropped from page cache with `posix_fadvise`,
+ * so that run does not read files cached by the previous one. Only clean pages of files are dropped.
+ * To measure cold storage reads of the whole system, drop all caches and run one mode per process.
+ */
+#define _XOPEN_SOURCE 700
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "lwjson/lwjson.h"
+
+#define BENCH_MAX_FILES                     4096
+
+static char* paths[BENCH_MAX_FILES];
+static size_t paths_len;
+static lwjson_token_t tokens[LWJSON_CFG_BATCH_TOKENS];
+static lwjson_t lwjson;
+
+static double
+now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * \brief           Serial loop, same as development application: read whole file, then parse it
+ */
+static size_t
+bench_serial(void) {
+    size_t ok = 0;
+
+    for (size_t i = 0; i < paths_len; ++i) {
+        FILE* f = fopen(paths[i], "rb");
+        char* json_text;
+        long file_size;
+
+        if (f == NULL) {
+            continue;
+        }
+        fseek(f, 0, SEEK_END);
+        file_size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        if (file_size > 0 && (json_text = calloc((size_t)file_size + 1, 1)) != NULL) {
+            if (fread(json_text, 1, (size_t)file_size, f) == (size_t)file_size
+                && lwjson_parse(&lwjson, json_text) == lwjsonOK) {
+                ++ok;
+            }
+            free(json_text);
+        }
+        fclose(f);
+    }
+    return ok;
+}
+
+/**
+ * \brief           Drop cached pages of all files, so next run reads them again
+ */
+static void
+bench_drop_cache(void) {
+    for (size_t i = 0; i < paths_len; ++i) {
+        int fd = open(paths[i], O_RDONLY);
+
+        if (fd >= 0) {
+            (void)posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+}
+
+static lwjsonr_t
+bench_batch_count(size_t index, lwjsonr_t res, const lwjson_doc_t* doc, void* arg) {
+    (void)index;
+    (void)doc;
+    if (res == lwjsonOK) {
+        __atomic_add_fetch((size_t*)arg, 1, __ATOMIC_RELAXED);
+    }
+    return lwjsonOK;
+}
+
+int
+main(int argc, char** argv) {
+    size_t nthreads = argc > 2 ? (size_t)atoi(argv[2]) : 4, ok_serial = 0, ok_batch = 0;
+    const char* dir = argc > 1 ? argv[1] : ".";
+    const char* mode = argc > 3 ? argv[3] : "both";
+    int run_serial = strcmp(mode, "batch") != 0, run_batch = strcmp(mode, "serial") != 0;
+    struct dirent* de;
+    double t;
+    DIR* d;
+
+    if (strcmp(mode, "serial") != 0 && strcmp(mode, "batch") != 0 && strcmp(mode, "both") != 0) {
+        printf("Unknown mode %s, use serial, batch or both\r\n", mode);
+        return 1;
+    }
+    if ((d = opendir(dir)) == NULL) {
+        printf("Cannot open directory %s\r\n", dir);
+        return 1;
+    }
+    while ((de = readdir(d)) != NULL && paths_len < BENCH_MAX_FILES) {
+        size_t len = strlen(de->d_name);
+
+        if (len > 5 && strcmp(&de->d_name[len - 5], ".json") == 0) {
+            paths[paths_len] = malloc(strlen(dir) + len + 2);
+            sprintf(paths[paths_len], "%s/%s", dir, de->d_name);
+            ++paths_len;
+        }
+    }
+    closedir(d);
+
+    lwjson_init(&lwjson, tokens, LWJSON_ARRAYSIZE(tokens));
+    printf("Files: %u\r\n", (unsigned)paths_len);
+    if (run_serial) {
+        bench_drop_cache();
+        t = now();
+        ok_serial = bench_serial();
+        t = now() - t;
+        printf("Serial:  %u parsed in %.3f ms\r\n", (unsigned)ok_serial, t * 1000.0);
+    }
+    if (run_batch) {
+        bench_drop_cache();
+        t = now();
+        lwjson_batch_files((const char* const*)paths, paths_len, nthreads, bench_batch_count, &ok_batch);
+        t = now() - t;
+        printf("Batch:   %u parsed in %.3f ms with %u threads\r\n", (unsigned)ok_batch, t * 1000.0,
+               (unsigned)nthreads);
+    }
+    for (size_t i = 0; i < paths_len; ++i) {
+        free(paths[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+/*
+ * Test application for CMake build, runs all tests of "test/test.c"
+ *
+ * Every test prints its result, CTest marks run as failed when any line reports failure.
+ */
+extern void test_run(void);
+
+int
+main(void) {
+    test_run();
+    return 0;
+}
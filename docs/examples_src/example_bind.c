@@ -0,0 +1,51 @@
+#include "lwjson/lwjson.h"
+
+/* Application structures */
+typedef struct {
+    int32_t x;
+    int32_t y;
+} point_t;
+
+typedef struct {
+    int32_t id;
+    float temp;
+    char name[16];
+    point_t pos;
+    int16_t samples[8];
+} sensor_t;
+
+/* Binding tables */
+static const lwjson_binding_t
+point_bind[] = {
+    LWJSON_BIND(point_t, x, "x", LWJSON_BIND_INT, NULL),
+    LWJSON_BIND(point_t, y, "y", LWJSON_BIND_INT, NULL),
+    LWJSON_BIND_END,
+};
+static const lwjson_binding_t sample_bind = LWJSON_BIND_ELEM(int16_t, LWJSON_BIND_INT, NULL);
+static const lwjson_binding_t
+sensor_bind[] = {
+    LWJSON_BIND(sensor_t, id, "id", LWJSON_BIND_INT, NULL),
+    LWJSON_BIND(sensor_t, temp, "temp", LWJSON_BIND_REAL, NULL),
+    LWJSON_BIND(sensor_t, name, "name", LWJSON_BIND_STRING, NULL),
+    LWJSON_BIND(sensor_t, pos, "pos", LWJSON_BIND_OBJECT, point_bind),
+    LWJSON_BIND(sensor_t, samples, "samples", LWJSON_BIND_ARRAY, &sample_bind),
+    LWJSON_BIND_END,
+};
+
+/* LwJSON instance and tokens */
+static lwjson_token_t tokens[128];
+static lwjson_t lwjson;
+static lwjson_doc_t doc;
+
+/* Parse JSON and bind it to structure */
+static void
+parse_json(void) {
+    sensor_t sensor = {0};
+
+    lwjson_init(&lwjson, tokens, LWJSON_ARRAYSIZE(tokens));
+    if (lwjson_parse(&lwjson, "{\"id\":1,\"temp\":21.5,\"name\":\"kitchen\",\"pos\":{\"x\":3,\"y\":4},\"samples\":[1,2,3]}") == lwjsonOK
+        && lwjson_get_doc(&lwjson, &doc) == lwjsonOK
+        && lwjson_bind(&doc, sensor_bind, &sensor) == lwjsonOK) {
+        printf("Sensor %d: %s\r\n", (int)sensor.id, sensor.name);
+    }
+}
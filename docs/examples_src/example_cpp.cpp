@@ -0,0 +1,19 @@
+#include <cstdio>
+#include "lwjson/lwjson.hpp"
+
+/* Document with static pool of 128 tokens */
+static lwjson::document<128> doc;
+
+/* Parse JSON function */
+static void
+parse_json() {
+    if (doc.parse("{\"name\":\"sensor\",\"values\":[1,2,3]}") == lwjsonOK) {
+        std::string_view name = doc["name"].str();
+        std::printf("Name: %.*s\r\n", (int)name.size(), name.data());
+
+        /* Iterate over array elements */
+        for (lwjson::token t : doc["values"]) {
+            std::printf("Value: %d\r\n", t.get<int>());
+        }
+    }
+}
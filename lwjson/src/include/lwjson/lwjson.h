@@ -35,6 +35,7 @@
 #define LWJSON_HDR_H
 
 #include <string.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "lwjson/lwjson_opt.h"
 
@@ -84,10 +85,15 @@ typedef LWJSON_CFG_INT_TYPE lwjson_int_t;
  */
 typedef struct lwjson_token {
     struct lwjson_token* next;                  /*!< Next token on a list */
-    struct lwjson_token* parent;                /*!< Parent token (think about optimization and remove this one?) */
+    struct lwjson_token* parent;                /*!< Parent token, `NULL` for top token */
     lwjson_type_t type;                         /*!< Token type */
     const char* token_name;                     /*!< Token name (if exists) */
     size_t token_name_len;                      /*!< Length of token name (this is needed to support const input strings to parse) */
+#if LWJSON_CFG_TOKEN_SPAN || __DOXYGEN__
+    const char* token_raw;                      /*!< Start of token value text in input, including quotes and brackets.
+                                                    `NULL` for CBOR and MessagePack input */
+    size_t token_raw_len;                       /*!< Length of token value text in input */
+#endif /* LWJSON_CFG_TOKEN_SPAN || __DOXYGEN__ */
     union {
         struct {
             const char* token_value;            /*!< Value if type is not \ref LWJSON_TYPE_OBJECT or \ref LWJSON_TYPE_ARRAY */
@@ -107,6 +113,7 @@ typedef enum {
     lwjsonERR,
     lwjsonERRJSON,                              /*!< Error JSON format */
     lwjsonERRMEM,                               /*!< Memory error */
+    lwjsonEND,                                  /*!< No more records in input */
 } lwjsonr_t;
 
 /**
@@ -119,14 +126,388 @@ typedef struct {
     lwjson_token_t first_token;                 /*!< First token on a list */
     struct {
         uint8_t parsed : 1;                     /*!< Flag indicating JSON parsing has finished successfully */
+        uint8_t split : 1;                      /*!< Flag indicating used tokens are not contiguous, after parallel parsing */
     } flags;                                    /*!< List of flags */
 } lwjson_t;
 
+/**
+ * \brief           Immutable view of parsed JSON
+ *
+ * Document is created from parser instance with \ref lwjson_get_doc and only references its tokens.
+ * Functions taking `const lwjson_doc_t*` never modify the tokens, so one document can be shared
+ * by any number of threads without locking, as long as parser instance is not parsed again, reset
+ * or freed while document is in use.
+ */
+typedef struct {
+    const lwjson_token_t* root;                 /*!< Top token, `NULL` if document is not valid */
+    size_t tokens_used;                         /*!< Number of tokens used by the tree */
+} lwjson_doc_t;
+
+/**
+ * \brief           Align structure member, and so the structure, to `x` bytes
+ *
+ * Define it in compiler flags or options file for compiler not listed here.
+ * Empty definition only gives up cache line separation, code stays correct.
+ */
+#ifndef LWJSON_ALIGNED
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define LWJSON_ALIGNED(x)                   alignas(x)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define LWJSON_ALIGNED(x)                   _Alignas(x)
+#elif defined(__GNUC__) || defined(__clang__)
+#define LWJSON_ALIGNED(x)                   __attribute__((aligned(x)))
+#elif defined(_MSC_VER)
+#define LWJSON_ALIGNED(x)                   __declspec(align(x))
+#else
+#define LWJSON_ALIGNED(x)
+#endif
+#endif /* LWJSON_ALIGNED */
+
+#if LWJSON_CFG_POOL || __DOXYGEN__
+
+/**
+ * \brief           Parser instance in \ref lwjson_pool_t, aligned to cache line
+ */
+typedef struct {
+    LWJSON_ALIGNED(LWJSON_CFG_CACHE_LINE) lwjson_t lw; /*!< Parser instance, must be first member */
+    uint32_t next;                              /*!< Index of next free item plus one, `0` at the end */
+} lwjson_pool_item_t;
+
+/**
+ * \brief           Pool of preallocated parser instances for concurrent use
+ */
+typedef struct {
+    LWJSON_ALIGNED(LWJSON_CFG_CACHE_LINE) uint64_t head; /*!< Top of free stack, index plus one in lower half
+                                                        and change counter in upper half */
+    lwjson_pool_item_t* items;                  /*!< Array of items */
+    size_t items_len;                           /*!< Number of items */
+} lwjson_pool_t;
+
+#endif /* LWJSON_CFG_POOL || __DOXYGEN__ */
+
+#if LWJSON_CFG_TAPE || __DOXYGEN__
+
+/**
+ * \brief           Index or offset of missing entry in \ref lwjson_tape_token_t
+ */
+#define LWJSON_TAPE_NONE                    0xFFFFFFFFUL
+
+/**
+ * \brief           Token of relocatable token tree
+ *
+ * Tokens reference each other by index in tape and strings by offset in string area,
+ * so that tape can be stored to file or shared memory and used at any address.
+ * Tokens are in depth-first order and root token has index `0`.
+ */
+typedef struct {
+    uint32_t type;                              /*!< Token type, member of \ref lwjson_type_t */
+    uint32_t parent;                            /*!< Index of parent token, \ref LWJSON_TAPE_NONE for root */
+    uint32_t next;                              /*!< Index of next token on a list, \ref LWJSON_TAPE_NONE for last */
+    uint32_t name;                              /*!< Offset of token name, \ref LWJSON_TAPE_NONE if token has no name */
+    uint32_t name_len;                          /*!< Length of token name */
+    uint32_t reserved;                          /*!< Reserved, set to `0` */
+    union {
+        struct {
+            uint32_t off;                       /*!< Offset of string value */
+            uint32_t len;                       /*!< Length of string value */
+        } str;                                  /*!< String data */
+        int64_t num_int;                        /*!< Int number value */
+        double num_real;                        /*!< Real number value */
+        uint32_t first_child;                   /*!< Index of first child, \ref LWJSON_TAPE_NONE if empty */
+    } u;                                        /*!< Union with different data types */
+} lwjson_tape_token_t;
+
+/**
+ * \brief           Read-only view of relocatable token tree
+ */
+typedef struct {
+    const lwjson_tape_token_t* tokens;          /*!< Array of tokens, `NULL` if tape is not valid */
+    size_t tokens_len;                          /*!< Number of tokens */
+    const char* strings;                        /*!< String area, strings are not `NULL` terminated */
+    size_t strings_len;                         /*!< Length of string area */
+    void* map;                                  /*!< Memory mapped by \ref lwjson_tape_load, `NULL` otherwise */
+    size_t map_len;                             /*!< Length of mapped memory */
+} lwjson_tape_t;
+
+#endif /* LWJSON_CFG_TAPE || __DOXYGEN__ */
+
+/**
+ * \brief           Member type for struct binding with \ref lwjson_bind
+ */
+typedef enum {
+    LWJSON_BIND_INT,                            /*!< Signed integer member of `1`, `2`, `4` or `8` bytes. Accepts \ref LWJSON_TYPE_NUM_INT in member range */
+    LWJSON_BIND_REAL,                           /*!< `float` or `double` member. Accepts \ref LWJSON_TYPE_NUM_INT and \ref LWJSON_TYPE_NUM_REAL */
+    LWJSON_BIND_BOOL,                           /*!< Integer member set to `1` or `0`. Accepts \ref LWJSON_TYPE_TRUE and \ref LWJSON_TYPE_FALSE */
+    LWJSON_BIND_STRING,                         /*!< `char` array member. Raw string is copied and `NULL` terminated */
+    LWJSON_BIND_OBJECT,                         /*!< Nested structure, described by `sub` binding table */
+    LWJSON_BIND_ARRAY,                          /*!< Fixed size array member, element is described by first entry of `sub` */
+} lwjson_bind_type_t;
+
+/**
+ * \brief           Struct binding descriptor entry
+ *
+ * Table of entries describes one structure and is terminated with \ref LWJSON_BIND_END entry.
+ * Use \ref LWJSON_BIND and \ref LWJSON_BIND_ELEM macros to create entries,
+ * so key length is calculated at compile time.
+ */
+typedef struct lwjson_binding {
+    const char* name;                           /*!< Object key name. Set to `NULL` for last entry */
+    size_t name_len;                            /*!< Length of key name */
+    lwjson_bind_type_t type;                    /*!< Member type */
+    size_t offset;                              /*!< Member offset in the structure */
+    size_t size;                                /*!< Member size in units of bytes */
+    const struct lwjson_binding* sub;           /*!< Nested table for \ref LWJSON_BIND_OBJECT or element entry for \ref LWJSON_BIND_ARRAY */
+} lwjson_binding_t;
+
+/**
+ * \brief           Create binding entry for structure member
+ * \param[in]       stype: Structure type
+ * \param[in]       member: Member name in the structure
+ * \param[in]       key: JSON key as string literal
+ * \param[in]       btype: Member type, member of \ref lwjson_bind_type_t
+ * \param[in]       sub: Nested binding table or array element entry. Set to `NULL` if not used
+ */
+#define LWJSON_BIND(stype, member, key, btype, sub)     { (key), sizeof(key) - 1, (btype), offsetof(stype, member), sizeof(((stype *)0)->member), (sub) }
+
+/**
+ * \brief           Create array element binding entry
+ * \param[in]       etype: Element C type
+ * \param[in]       btype: Element type, member of \ref lwjson_bind_type_t
+ * \param[in]       sub: Nested binding table or array element entry. Set to `NULL` if not used
+ */
+#define LWJSON_BIND_ELEM(etype, btype, sub)             { NULL, 0, (btype), 0, sizeof(etype), (sub) }
+
+/**
+ * \brief           Last entry in binding table
+ */
+#define LWJSON_BIND_END                                 { NULL, 0, LWJSON_BIND_INT, 0, 0, NULL }
+
+/**
+ * \brief           Maximal nesting level of objects and arrays for \ref lwjson_writer_t
+ * \sa              LWJSON_CFG_WRITER_MAX_DEPTH
+ */
+#define LWJSON_WRITER_MAX_DEPTH             LWJSON_CFG_WRITER_MAX_DEPTH
+
+struct lwjson_writer;
+
+/**
+ * \brief           Writer flush function prototype
+ * \param[in]       w: Writer instance
+ * \param[in]       data: Data to output
+ * \param[in]       len: Length of data in units of bytes
+ * \return          \ref lwjsonOK when all data were consumed, member of \ref lwjsonr_t otherwise
+ */
+typedef lwjsonr_t (*lwjson_writer_flush_fn)(struct lwjson_writer* w, const char* data, size_t len);
+
+/**
+ * \brief           JSON writer instance
+ */
+typedef struct lwjson_writer {
+    char* buf;                                  /*!< Output buffer */
+    size_t cap;                                 /*!< Size of output buffer */
+    size_t len;                                 /*!< Number of bytes currently in output buffer */
+    lwjson_writer_flush_fn flush_fn;            /*!< Flush function, called when buffer is full */
+    void* arg;                                  /*!< Custom user argument */
+    uint32_t has_items[(LWJSON_WRITER_MAX_DEPTH + 31) / 32]; /*!< Bit per nesting level, set when container has at least one value */
+    uint32_t is_array[(LWJSON_WRITER_MAX_DEPTH + 31) / 32];  /*!< Bit per nesting level, set when container is array */
+    uint16_t depth;                             /*!< Current nesting level */
+    uint8_t after_key;                          /*!< Set when key was written and value is expected */
+    lwjsonr_t err;                              /*!< First error during write, all later writes are ignored */
+} lwjson_writer_t;
+
+/**
+ * \brief           Patch operation type
+ */
+typedef enum {
+    LWJSON_PATCH_SET,                           /*!< Replace value of token */
+    LWJSON_PATCH_REMOVE,                        /*!< Remove token with its name */
+    LWJSON_PATCH_INSERT,                        /*!< Add new member at the end of object or array */
+} lwjson_patch_op_t;
+
+/**
+ * \brief           Single modification of parsed JSON
+ */
+typedef struct {
+    lwjson_patch_op_t op;                       /*!< Operation type */
+    const lwjson_token_t* token;                /*!< Target token, parent token for insert operation */
+    const char* name;                           /*!< Member name for insert operation, `NULL` for arrays */
+    size_t name_len;                            /*!< Length of member name */
+    const lwjson_token_t* before;               /*!< Existing member to insert before, `NULL` to add at the end */
+    const char* value;                          /*!< New value JSON text */
+    size_t value_len;                           /*!< Length of new value text */
+    const char* start;                          /*!< Start of replaced input range, calculated on emit */
+    const char* end;                            /*!< End of replaced input range, calculated on emit */
+    uint8_t comma;                              /*!< Set when inserted member needs separator, calculated on emit */
+    size_t seq;                                 /*!< Order in which entry was added, keeps insertions on the same position in order */
+} lwjson_patch_entry_t;
+
+/**
+ * \brief           List of modifications of parsed JSON
+ */
+typedef struct {
+    const lwjson_t* lw;                         /*!< Parsed JSON instance */
+    lwjson_patch_entry_t* entries;              /*!< Array of entries */
+    size_t entries_len;                         /*!< Number of entries in array */
+    size_t entries_used;                        /*!< Number of used entries */
+} lwjson_patch_t;
+
+/**
+ * \brief           Difference type reported by \ref lwjson_diff
+ */
+typedef enum {
+    LWJSON_DIFF_ADDED,                          /*!< Value exists only in second document */
+    LWJSON_DIFF_REMOVED,                        /*!< Value exists only in first document */
+    LWJSON_DIFF_CHANGED,                        /*!< Value exists in both documents with different content */
+} lwjson_diff_op_t;
+
+/**
+ * \brief           Callback function for every difference found by \ref lwjson_diff
+ * \param[in]       op: Difference type
+ * \param[in]       path: JSON pointer of the value as per RFC 6901, not `NULL` terminated
+ * \param[in]       path_len: Length of path
+ * \param[in]       a: Value in first document, `NULL` for \ref LWJSON_DIFF_ADDED
+ * \param[in]       b: Value in second document, `NULL` for \ref LWJSON_DIFF_REMOVED
+ * \param[in]       arg: User argument
+ * \return          \ref lwjsonOK to continue, any other value stops the diff and is returned
+ */
+typedef lwjsonr_t (*lwjson_diff_fn)(lwjson_diff_op_t op, const char* path, size_t path_len, const lwjson_token_t* a,
+                                    const lwjson_token_t* b, void* arg);
+
+/**
+ * \brief           Callback function for every record of newline delimited JSON
+ * \param[in]       res: Result of record parsing, \ref lwjsonOK when `doc` is valid
+ * \param[in]       doc: Parsed record, valid only during the callback
+ * \param[in]       rec: Record text, not `NULL` terminated
+ * \param[in]       rec_len: Length of record text
+ * \param[in]       arg: User argument
+ * \return          \ref lwjsonOK to continue, any other value stops parsing and is returned
+ */
+typedef lwjsonr_t (*lwjson_ndjson_fn)(lwjsonr_t res, const lwjson_doc_t* doc, const char* rec, size_t rec_len,
+                                      void* arg);
+
+/**
+ * \brief           Iterator over records of newline delimited JSON
+ */
+typedef struct {
+    const char* p;                              /*!< Start of next line */
+    const char* end;                            /*!< End of input text */
+    const char* rec;                            /*!< Text of last returned record, not `NULL` terminated */
+    size_t rec_len;                             /*!< Length of last returned record */
+    size_t line;                                /*!< Line number of last returned record, starting with `1` */
+    size_t errors;                              /*!< Number of skipped malformed records */
+    uint8_t skip_errors;                        /*!< Set to `1` to skip malformed records */
+} lwjson_lines_t;
+
+/**
+ * \brief           Splitter of concatenated JSON values and RFC 7464 JSON text sequences
+ */
+typedef struct {
+    const char* p;                              /*!< Current position in input text */
+    const char* end;                            /*!< End of input text */
+} lwjson_split_t;
+
+/**
+ * \brief           Callback function for every file of batch parse
+ * \param[in]       index: Index of file in array of paths
+ * \param[in]       res: Result of reading and parsing, \ref lwjsonOK when `doc` is valid
+ * \param[in]       doc: Parsed file, valid only during the callback
+ * \param[in]       arg: User argument
+ * \return          \ref lwjsonOK to continue, any other value stops parsing and is returned
+ */
+typedef lwjsonr_t (*lwjson_batch_fn)(size_t index, lwjsonr_t res, const lwjson_doc_t* doc, void* arg);
+
 lwjsonr_t       lwjson_init(lwjson_t* lw, lwjson_token_t* tokens, size_t tokens_len);
 lwjsonr_t       lwjson_parse(lwjson_t* lw, const char* json_str);
+lwjsonr_t       lwjson_parse_ex(lwjson_t* lw, const char* json_data, size_t len);
 lwjsonr_t       lwjson_reset(lwjson_t* lw);
-const lwjson_token_t* lwjson_find(lwjson_t* lw, const char* path);
+const lwjson_token_t* lwjson_find(const lwjson_t* lw, const char* path);
 lwjsonr_t       lwjson_free(lwjson_t* lw);
+lwjsonr_t       lwjson_get_doc(const lwjson_t* lw, lwjson_doc_t* doc);
+const lwjson_token_t* lwjson_doc_find(const lwjson_doc_t* doc, const char* path);
+
+lwjsonr_t       lwjson_array_to_i64(const lwjson_token_t* token, int64_t* out, size_t cap, size_t* len);
+lwjsonr_t       lwjson_array_to_f64(const lwjson_token_t* token, double* out, size_t cap, size_t* len);
+lwjsonr_t       lwjson_array_to_f32(const lwjson_token_t* token, float* out, size_t cap, size_t* len);
+lwjsonr_t       lwjson_bind(const lwjson_doc_t* doc, const lwjson_binding_t* bindings, void* out);
+
+lwjsonr_t       lwjson_writer_init(lwjson_writer_t* w, char* buf, size_t cap, lwjson_writer_flush_fn flush_fn, void* arg);
+lwjsonr_t       lwjson_writer_flush(lwjson_writer_t* w);
+lwjsonr_t       lwjson_writer_begin_object(lwjson_writer_t* w);
+lwjsonr_t       lwjson_writer_begin_array(lwjson_writer_t* w);
+lwjsonr_t       lwjson_writer_end(lwjson_writer_t* w);
+lwjsonr_t       lwjson_writer_key(lwjson_writer_t* w, const char* key, size_t len);
+lwjsonr_t       lwjson_writer_key_raw(lwjson_writer_t* w, const char* key, size_t len);
+lwjsonr_t       lwjson_writer_string(lwjson_writer_t* w, const char* str, size_t len);
+lwjsonr_t       lwjson_writer_int(lwjson_writer_t* w, lwjson_int_t num);
+lwjsonr_t       lwjson_writer_real(lwjson_writer_t* w, lwjson_real_t num);
+lwjsonr_t       lwjson_writer_bool(lwjson_writer_t* w, uint8_t val);
+lwjsonr_t       lwjson_writer_null(lwjson_writer_t* w);
+lwjsonr_t       lwjson_writer_raw(lwjson_writer_t* w, const char* json, size_t len);
+lwjsonr_t       lwjson_writer_bytes(lwjson_writer_t* w, const void* data, size_t len);
+lwjsonr_t       lwjson_writer_token(lwjson_writer_t* w, const lwjson_token_t* token);
+lwjsonr_t       lwjson_serialize(const lwjson_doc_t* doc, const lwjson_token_t* token, char* out, size_t cap, size_t* len);
+lwjsonr_t       lwjson_minify(const char* in, size_t len, char* out, size_t* out_len);
+lwjsonr_t       lwjson_prettify(const char* in, size_t len, lwjson_writer_t* w, size_t indent);
+
+lwjsonr_t       lwjson_to_cbor(const lwjson_doc_t* doc, const lwjson_token_t* token, lwjson_writer_t* w, size_t* len);
+lwjsonr_t       lwjson_to_msgpack(const lwjson_doc_t* doc, const lwjson_token_t* token, lwjson_writer_t* w, size_t* len);
+lwjsonr_t       lwjson_json_to_cbor(const char* in, size_t len, lwjson_writer_t* w);
+lwjsonr_t       lwjson_parse_cbor(lwjson_t* lw, const void* data, size_t len, char* buf, size_t buf_len);
+lwjsonr_t       lwjson_parse_msgpack(lwjson_t* lw, const void* data, size_t len, char* buf, size_t buf_len);
+
+#if LWJSON_CFG_TOKEN_SPAN || __DOXYGEN__
+lwjsonr_t       lwjson_patch_init(lwjson_patch_t* patch, const lwjson_t* lw, lwjson_patch_entry_t* entries, size_t entries_len);
+lwjsonr_t       lwjson_patch_set(lwjson_patch_t* patch, const lwjson_token_t* token, const char* value, size_t value_len);
+lwjsonr_t       lwjson_patch_remove(lwjson_patch_t* patch, const lwjson_token_t* token);
+lwjsonr_t       lwjson_patch_insert(lwjson_patch_t* patch, const lwjson_token_t* parent, const char* name, size_t name_len,
+                                    const char* value, size_t value_len);
+lwjsonr_t       lwjson_patch_insert_before(lwjson_patch_t* patch, const lwjson_token_t* before, const char* name, size_t name_len,
+                                           const char* value, size_t value_len);
+lwjsonr_t       lwjson_patch_emit(lwjson_patch_t* patch, lwjson_writer_t* w);
+lwjsonr_t       lwjson_json_patch_apply(const lwjson_t* lw, const lwjson_doc_t* ops, lwjson_t* scratch, char* buf,
+                                        size_t buf_len, lwjson_writer_t* w);
+#endif /* LWJSON_CFG_TOKEN_SPAN || __DOXYGEN__ */
+
+lwjsonr_t       lwjson_merge_patch(const lwjson_doc_t* base, const lwjson_doc_t* patch, lwjson_writer_t* w);
+lwjsonr_t       lwjson_diff(const lwjson_doc_t* a, const lwjson_doc_t* b, lwjson_diff_fn fn, void* arg);
+lwjsonr_t       lwjson_diff_write_patch(const lwjson_doc_t* a, const lwjson_doc_t* b, lwjson_writer_t* w);
+
+#if LWJSON_CFG_POOL || __DOXYGEN__
+lwjsonr_t       lwjson_pool_init(lwjson_pool_t* pool, lwjson_pool_item_t* items, size_t items_len, lwjson_token_t* tokens,
+                                 size_t tokens_per_item);
+lwjson_t*       lwjson_pool_acquire(lwjson_pool_t* pool);
+lwjsonr_t       lwjson_pool_release(lwjson_pool_t* pool, lwjson_t* lw);
+lwjsonr_t       lwjson_pool_flush(lwjson_pool_t* pool);
+#endif /* LWJSON_CFG_POOL || __DOXYGEN__ */
+
+lwjsonr_t       lwjson_ndjson_parse(lwjson_t* lw, const char* data, size_t len, lwjson_ndjson_fn fn, void* arg);
+lwjsonr_t       lwjson_lines_init(lwjson_lines_t* it, const char* data, size_t len, uint8_t skip_errors);
+lwjsonr_t       lwjson_lines_next(lwjson_lines_t* it, lwjson_t* lw);
+lwjsonr_t       lwjson_split_init(lwjson_split_t* sp, const char* data, size_t len);
+lwjsonr_t       lwjson_split_next(lwjson_split_t* sp, const char** value, size_t* value_len);
+#if LWJSON_CFG_ZLIB || __DOXYGEN__
+lwjsonr_t       lwjson_gz_ndjson_parse(lwjson_t* lw, int fd, lwjson_ndjson_fn fn, void* arg);
+#endif /* LWJSON_CFG_ZLIB || __DOXYGEN__ */
+#if LWJSON_CFG_TAPE || __DOXYGEN__
+lwjsonr_t       lwjson_tape_export(const lwjson_doc_t* doc, void* buf, size_t buf_len, size_t* len);
+lwjsonr_t       lwjson_tape_save(const lwjson_doc_t* doc, int fd);
+#if defined(__linux__) || __DOXYGEN__
+lwjsonr_t       lwjson_tape_share(const lwjson_doc_t* doc, const char* name, int* fd);
+#endif /* defined(__linux__) || __DOXYGEN__ */
+lwjsonr_t       lwjson_tape_load(lwjson_tape_t* tape, int fd);
+lwjsonr_t       lwjson_tape_open(lwjson_tape_t* tape, const void* data, size_t len);
+lwjsonr_t       lwjson_tape_close(lwjson_tape_t* tape);
+const lwjson_tape_token_t* lwjson_tape_find(const lwjson_tape_t* tape, const char* path);
+const lwjson_tape_token_t* lwjson_tape_find_ex(const lwjson_tape_t* tape, const lwjson_tape_token_t* token,
+                                               const char* path);
+#endif /* LWJSON_CFG_TAPE || __DOXYGEN__ */
+#if LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__
+lwjsonr_t       lwjson_parse_pipelined(lwjson_t* lw, const char* json_data, size_t len);
+lwjsonr_t       lwjson_parse_parallel(lwjson_t* lw, const char* json_data, size_t len, size_t nthreads);
+lwjsonr_t       lwjson_ndjson_parse_parallel(const char* data, size_t len, size_t nthreads, lwjson_ndjson_fn fn, void* arg);
+lwjsonr_t       lwjson_batch_files(const char* const* paths, size_t paths_len, size_t nthreads, lwjson_batch_fn fn,
+                                   void* arg);
+#endif /* LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__ */
 
 /**
  * \brief           Get number of tokens used to parse JSON
@@ -157,11 +538,11 @@ lwjsonr_t       lwjson_free(lwjson_t* lw);
 #define         lwjson_get_val_real(token)      (((token) != NULL && (token)->type == LWJSON_TYPE_NUM_REAL) ? (token)->u.num_real : 0)
 
 /**
- * \brief           Get for child token for \ref LWJSON_TYPE_NUM_OBJECT or \ref LWJSON_TYPE_NUM_ARRAY types
+ * \brief           Get for child token for \ref LWJSON_TYPE_OBJECT or \ref LWJSON_TYPE_ARRAY types
  * \param[in]       token: token with integer type
  * \return          Pointer to first child
  */
-#define         lwjson_get_first_child(token)   (const void *)(((token) != NULL && ((token)->type == LWJSON_TYPE_NUM_OBJECT || (token)->type == LWJSON_TYPE_NUM_ARRAY)) ? (token)->u.first_child : NULL)
+#define         lwjson_get_first_child(token)   (const void *)(((token) != NULL && ((token)->type == LWJSON_TYPE_OBJECT || (token)->type == LWJSON_TYPE_ARRAY)) ? (token)->u.first_child : NULL)
 
 /**
  * \brief           Get string value from JSON token
@@ -170,7 +551,7 @@ lwjsonr_t       lwjson_free(lwjson_t* lw);
  * \return          Pointer to string
  */
 static inline const char*
-lwjson_get_val_string(lwjson_token_t* token, size_t* str_len) {
+lwjson_get_val_string(const lwjson_token_t* token, size_t* str_len) {
     if (token != NULL && token->type == LWJSON_TYPE_STRING) {
         if (str_len != NULL) {
             *str_len = token->u.str.token_value_len;
@@ -180,6 +561,141 @@ lwjson_get_val_string(lwjson_token_t* token, size_t* str_len) {
     return NULL;
 }
 
+#if LWJSON_CFG_TOKEN_SPAN || __DOXYGEN__
+
+/**
+ * \brief           Get token value text as it is in the input JSON
+ *
+ * Text covers complete value, with quotes for strings and with all children for objects and arrays.
+ * It does not include token name.
+ *
+ * \note            Available only when \ref LWJSON_CFG_TOKEN_SPAN is enabled
+ * \param[in]       token: Token to get text for
+ * \param[out]      len: Pointer to variable holding length of text
+ * \return          Pointer to first character of value in input JSON, `NULL` if token is `NULL`
+ *                      or was parsed from CBOR or MessagePack
+ */
+static inline const char*
+lwjson_get_raw(const lwjson_token_t* token, size_t* len) {
+    if (token != NULL) {
+        if (len != NULL) {
+            *len = token->token_raw_len;
+        }
+        return token->token_raw;
+    }
+    return NULL;
+}
+
+#endif /* LWJSON_CFG_TOKEN_SPAN || __DOXYGEN__ */
+
+#if LWJSON_CFG_TAPE || __DOXYGEN__
+
+/**
+ * \brief           Get tape token by index
+ * \param[in]       tape: Tape to get token from
+ * \param[in]       idx: Token index
+ * \return          Pointer to token, `NULL` if index is out of range
+ */
+static inline const lwjson_tape_token_t*
+lwjson_tape_get_token(const lwjson_tape_t* tape, uint32_t idx) {
+    return (tape != NULL && idx < tape->tokens_len) ? &tape->tokens[idx] : NULL;
+}
+
+/**
+ * \brief           Get top token of tape
+ * \param[in]       tape: Tape to get token from
+ * \return          Pointer to top token, `NULL` if tape is empty
+ */
+#define         lwjson_tape_get_first_token(tape)           lwjson_tape_get_token((tape), 0)
+
+/**
+ * \brief           Get first child of \ref LWJSON_TYPE_OBJECT or \ref LWJSON_TYPE_ARRAY tape token
+ * \param[in]       tape: Tape token belongs to
+ * \param[in]       token: Tape token
+ * \return          Pointer to first child, `NULL` if token has no children
+ */
+#define         lwjson_tape_get_first_child(tape, token)    (((token) != NULL && ((token)->type == LWJSON_TYPE_OBJECT || (token)->type == LWJSON_TYPE_ARRAY)) ? lwjson_tape_get_token((tape), (token)->u.first_child) : NULL)
+
+/**
+ * \brief           Get next tape token on a list
+ * \param[in]       tape: Tape token belongs to
+ * \param[in]       token: Tape token
+ * \return          Pointer to next token, `NULL` for last token
+ */
+#define         lwjson_tape_get_next(tape, token)           (((token) != NULL) ? lwjson_tape_get_token((tape), (token)->next) : NULL)
+
+/**
+ * \brief           Get tape token value for \ref LWJSON_TYPE_NUM_INT type
+ * \param[in]       token: Tape token with integer type
+ * \return          Int number if type is integer, `0` otherwise
+ */
+#define         lwjson_tape_get_val_int(token)              (((token) != NULL && (token)->type == LWJSON_TYPE_NUM_INT) ? (token)->u.num_int : 0)
+
+/**
+ * \brief           Get tape token value for \ref LWJSON_TYPE_NUM_REAL type
+ * \param[in]       token: Tape token with real type
+ * \return          Real number if type is real, `0` otherwise
+ */
+#define         lwjson_tape_get_val_real(token)             (((token) != NULL && (token)->type == LWJSON_TYPE_NUM_REAL) ? (token)->u.num_real : 0)
+
+/**
+ * \brief           Get string from tape string area
+ * \param[in]       tape: Tape string belongs to
+ * \param[in]       off: String offset
+ * \param[in]       len: String length
+ * \return          Pointer to string, `NULL` if string is out of range
+ */
+static inline const char*
+lwjson_tape_get_string(const lwjson_tape_t* tape, uint32_t off, uint32_t len) {
+    if (tape != NULL && off <= tape->strings_len && len <= tape->strings_len - off) {
+        return &tape->strings[off];
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Get name of tape token
+ * \param[in]       tape: Tape token belongs to
+ * \param[in]       token: Tape token
+ * \param[out]      name_len: Pointer to variable holding length of name
+ * \return          Pointer to name, `NULL` if token has no name
+ */
+static inline const char*
+lwjson_tape_get_name(const lwjson_tape_t* tape, const lwjson_tape_token_t* token, size_t* name_len) {
+    const char* name;
+
+    if (token != NULL && (name = lwjson_tape_get_string(tape, token->name, token->name_len)) != NULL) {
+        if (name_len != NULL) {
+            *name_len = token->name_len;
+        }
+        return name;
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Get string value of tape token
+ * \param[in]       tape: Tape token belongs to
+ * \param[in]       token: Tape token with string type
+ * \param[out]      str_len: Pointer to variable holding length of string
+ * \return          Pointer to string, `NULL` if token is not string
+ */
+static inline const char*
+lwjson_tape_get_val_string(const lwjson_tape_t* tape, const lwjson_tape_token_t* token, size_t* str_len) {
+    const char* str;
+
+    if (token != NULL && token->type == LWJSON_TYPE_STRING
+        && (str = lwjson_tape_get_string(tape, token->u.str.off, token->u.str.len)) != NULL) {
+        if (str_len != NULL) {
+            *str_len = token->u.str.len;
+        }
+        return str;
+    }
+    return NULL;
+}
+
+#endif /* LWJSON_CFG_TAPE || __DOXYGEN__ */
+
 /**
  * \}
  */
@@ -0,0 +1,623 @@
+/**
+ * \file            lwjson.hpp
+ * \brief           LwJSON - C++ wrapper
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwJSON - Lightweight JSON format parser.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef LWJSON_HDR_HPP
+#define LWJSON_HDR_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include "lwjson/lwjson.h"
+
+/**
+ * \brief           Compile-time path support, requires C++20 class-type template parameters
+ */
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+#define LWJSON_CPP_STATIC_PATH              1
+#include <array>
+#else
+#define LWJSON_CPP_STATIC_PATH              0
+#endif
+
+/**
+ * \defgroup        LWJSON_CPP C++ wrapper
+ * \brief           Header-only C++17 wrapper with no heap allocation
+ * \{
+ */
+
+namespace lwjson {
+
+#if LWJSON_CPP_STATIC_PATH || __DOXYGEN__
+namespace detail {
+
+/**
+ * \brief           String literal usable as template parameter
+ * \tparam          N: Size of literal including `NULL` termination
+ */
+template<std::size_t N>
+struct fixed_string {
+    char data[N] = {};
+
+    constexpr fixed_string(const char (&str)[N]) noexcept {
+        for (std::size_t i = 0; i < N; ++i) {
+            data[i] = str[i];
+        }
+    }
+
+    static constexpr std::size_t length() noexcept { return N - 1; }
+};
+
+/**
+ * \brief           One path segment, resolved at compile time
+ */
+struct path_segment {
+    std::size_t pos;                            /*!< Segment start position in path string */
+    std::size_t len;                            /*!< Segment length */
+    bool any;                                   /*!< Segment is `#` and matches any array element */
+};
+
+/**
+ * \brief           Path split to segments with the same rules as \ref lwjson_find
+ * \tparam          P: Dot-separated path
+ */
+template<fixed_string P>
+struct static_path {
+    static constexpr std::size_t count = [] {
+        std::size_t cnt = 1;
+        for (std::size_t i = 0; i < P.length(); ++i) {
+            cnt += P.data[i] == '.';
+        }
+        return cnt;
+    }();
+
+    static constexpr std::array<path_segment, count> segments = [] {
+        std::array<path_segment, count> segs = {};
+        for (std::size_t i = 0, start = 0, idx = 0; i <= P.length(); ++i) {
+            if (i == P.length() || P.data[i] == '.') {
+                segs[idx].pos = start;
+                segs[idx].len = i - start;
+                segs[idx].any = segs[idx].len == 1 && P.data[start] == '#';
+                ++idx;
+                start = i + 1;
+            }
+        }
+        return segs;
+    }();
+
+    static constexpr bool valid = [] {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (segments[i].len == 0 || (P.data[segments[i].pos] == '#' && (!segments[i].any || i + 1 == count))) {
+                return false;
+            }
+        }
+        return true;
+    }();
+    static_assert(valid, "Invalid LwJSON path: empty segment or misplaced '#'");
+
+    /**
+     * \brief           Find token for segment `I` and all following segments
+     * \param[in]       parent: Parent token to search in
+     * \return          Found token on success, `nullptr` otherwise
+     */
+    template<std::size_t I>
+    static const lwjson_token_t* find(const lwjson_token_t* parent) noexcept {
+        constexpr path_segment seg = segments[I];
+
+        if constexpr (seg.any) {
+            if (parent->type != LWJSON_TYPE_ARRAY) {
+                return nullptr;
+            }
+            for (const lwjson_token_t* t = parent->u.first_child; t != nullptr; t = t->next) {
+                if (const lwjson_token_t* r = find<I + 1>(t); r != nullptr) {
+                    return r;
+                }
+            }
+        } else {
+            if (parent->type != LWJSON_TYPE_OBJECT) {
+                return nullptr;
+            }
+            for (const lwjson_token_t* t = parent->u.first_child; t != nullptr; t = t->next) {
+                /* Length and first character are compile-time constants */
+                if (t->token_name_len == seg.len && t->token_name[0] == P.data[seg.pos]
+                    && std::char_traits<char>::compare(t->token_name, P.data + seg.pos, seg.len) == 0) {
+                    if constexpr (I + 1 == count) {
+                        return t;
+                    } else if (const lwjson_token_t* r = find<I + 1>(t); r != nullptr) {
+                        return r;
+                    }
+                }
+            }
+        }
+        return nullptr;
+    }
+};
+
+} /* namespace detail */
+#endif /* LWJSON_CPP_STATIC_PATH || __DOXYGEN__ */
+
+/**
+ * \brief           Read-only view to one JSON token
+ *
+ * View is a single pointer and is valid as long as parsed document is not modified.
+ */
+class token {
+  public:
+    /**
+     * \brief           Forward iterator over children of object or array token
+     */
+    class iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = token;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = token;
+
+        constexpr iterator() noexcept = default;
+        constexpr explicit iterator(const lwjson_token_t* t) noexcept : t_(t) {}
+
+        constexpr token operator*() const noexcept { return token(t_); }
+        iterator& operator++() noexcept { t_ = t_->next; return *this; }
+        iterator operator++(int) noexcept { iterator i = *this; t_ = t_->next; return i; }
+        constexpr bool operator==(const iterator& o) const noexcept { return t_ == o.t_; }
+        constexpr bool operator!=(const iterator& o) const noexcept { return t_ != o.t_; }
+
+      private:
+        const lwjson_token_t* t_ = nullptr;
+    };
+
+    constexpr token() noexcept = default;
+    constexpr explicit token(const lwjson_token_t* t) noexcept : t_(t) {}
+
+    /** \brief Check if view points to a token */
+    constexpr explicit operator bool() const noexcept { return t_ != nullptr; }
+    /** \brief Get raw C token, may be `nullptr` */
+    constexpr const lwjson_token_t* get() const noexcept { return t_; }
+    /** \brief Get token type, \ref LWJSON_TYPE_NULL for empty view */
+    lwjson_type_t type() const noexcept { return t_ != nullptr ? t_->type : LWJSON_TYPE_NULL; }
+
+    bool is_object() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_OBJECT; }
+    bool is_array() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_ARRAY; }
+    bool is_string() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_STRING; }
+    bool is_int() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_NUM_INT; }
+    bool is_real() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_NUM_REAL; }
+    bool is_bool() const noexcept { return t_ != nullptr && (t_->type == LWJSON_TYPE_TRUE || t_->type == LWJSON_TYPE_FALSE); }
+    bool is_null() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_NULL; }
+
+    /**
+     * \brief           Get token name (object key), empty for array elements and top token
+     * \note            Name is raw text from input, escape sequences are not decoded
+     */
+    std::string_view name() const noexcept {
+        return (t_ != nullptr && t_->token_name != nullptr) ? std::string_view(t_->token_name, t_->token_name_len) : std::string_view();
+    }
+
+    /**
+     * \brief           Get string value, empty if token is not \ref LWJSON_TYPE_STRING
+     * \note            Value is raw text from input, escape sequences are not decoded
+     */
+    std::string_view str() const noexcept {
+        return is_string() ? std::string_view(t_->u.str.token_value, t_->u.str.token_value_len) : std::string_view();
+    }
+
+#if LWJSON_CFG_TOKEN_SPAN || __DOXYGEN__
+    /**
+     * \brief           Get token value text as it is in input, see \ref lwjson_get_raw
+     * \note            Available only when \ref LWJSON_CFG_TOKEN_SPAN is enabled
+     */
+    std::string_view raw() const noexcept {
+        return t_ != nullptr ? std::string_view(t_->token_raw, t_->token_raw_len) : std::string_view();
+    }
+#endif /* LWJSON_CFG_TOKEN_SPAN || __DOXYGEN__ */
+
+    /**
+     * \brief           Get typed value with the same rules as C accessor macros
+     *
+     * - Integral types use \ref lwjson_get_val_int
+     * - Floating point types use \ref lwjson_get_val_real
+     * - `bool` is `true` only for \ref LWJSON_TYPE_TRUE
+     * - `std::string_view` uses \ref lwjson_get_val_string
+     *
+     * \tparam          T: Output type
+     * \return          Token value or value-initialized `T` if type does not match
+     */
+    template<typename T>
+    T get() const noexcept {
+        if constexpr (std::is_same_v<T, bool>) {
+            return t_ != nullptr && t_->type == LWJSON_TYPE_TRUE;
+        } else if constexpr (std::is_integral_v<T>) {
+            return static_cast<T>(lwjson_get_val_int(t_));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            return static_cast<T>(lwjson_get_val_real(t_));
+        } else {
+            static_assert(std::is_same_v<T, std::string_view>, "Unsupported type for lwjson::token::get");
+            return str();
+        }
+    }
+
+    /** \brief Iterator to first child, or end iterator if token has no children */
+    iterator begin() const noexcept { return iterator((is_object() || is_array()) ? t_->u.first_child : nullptr); }
+    /** \brief End iterator */
+    constexpr iterator end() const noexcept { return iterator(); }
+
+    /** \brief Check if object or array has no children */
+    bool empty() const noexcept { return begin() == end(); }
+
+    /** \brief Get number of children, walks children list */
+    std::size_t size() const noexcept {
+        std::size_t cnt = 0;
+        for (iterator it = begin(); it != end(); ++it, ++cnt) {}
+        return cnt;
+    }
+
+    /**
+     * \brief           Get first object member with given key
+     * \param[in]       key: Key to search for
+     * \return          Member view, empty view if not found or token is not object
+     */
+    token operator[](std::string_view key) const noexcept {
+        if (is_object()) {
+            for (const lwjson_token_t* t = t_->u.first_child; t != nullptr; t = t->next) {
+                if (t->token_name_len == key.size() && std::string_view(t->token_name, t->token_name_len) == key) {
+                    return token(t);
+                }
+            }
+        }
+        return token();
+    }
+
+#if LWJSON_CPP_STATIC_PATH || __DOXYGEN__
+    /**
+     * \brief           Find token relative to this token with path resolved at compile time
+     *
+     * Path follows \ref lwjson_find rules. It is split to segments during compilation
+     * and lookup is generated as one nested loop per segment, with no path parsing at run time.
+     *
+     * \tparam          P: Dot-separated path literal
+     * \return          Token view, empty view if not found
+     * \note            Requires C++20
+     */
+    template<detail::fixed_string P>
+    token find() const noexcept {
+        return token(t_ != nullptr ? detail::static_path<P>::template find<0>(t_) : nullptr);
+    }
+#endif /* LWJSON_CPP_STATIC_PATH || __DOXYGEN__ */
+
+    /**
+     * \brief           Get array element at given index
+     * \param[in]       idx: Element index
+     * \return          Element view, empty view if out of range or token is not array
+     */
+    token operator[](std::size_t idx) const noexcept {
+        if (is_array()) {
+            for (const lwjson_token_t* t = t_->u.first_child; t != nullptr; t = t->next, --idx) {
+                if (idx == 0) {
+                    return token(t);
+                }
+            }
+        }
+        return token();
+    }
+
+  private:
+    const lwjson_token_t* t_ = nullptr;
+};
+
+/**
+ * \brief           Parsed JSON document with statically sized token pool
+ * \tparam          N: Number of tokens available for parsing
+ *
+ * Document holds pointers to its own storage, therefore it cannot be copied or moved.
+ */
+template<std::size_t N>
+class document {
+  public:
+    document() noexcept { lwjson_init(&lw_, tokens_, N); }
+    document(const document&) = delete;
+    document& operator=(const document&) = delete;
+
+    /**
+     * \brief           Parse input JSON string
+     * \param[in]       json_str: `NULL` terminated JSON string, must stay valid while document is used
+     * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+     */
+    lwjsonr_t parse(const char* json_str) noexcept { return lwjson_parse(&lw_, json_str); }
+
+    /** \brief Check if last parse operation was successful */
+    bool parsed() const noexcept { return lw_.flags.parsed; }
+    /** \brief Top token view, empty view if document is not parsed */
+    token root() const noexcept { return parsed() ? token(&lw_.first_token) : token(); }
+    /** \brief Number of tokens used by last parse operation */
+    std::size_t tokens_used() const noexcept { return lwjson_get_tokens_used(&lw_); }
+    /** \brief Token pool capacity */
+    static constexpr std::size_t capacity() noexcept { return N; }
+
+    /** \brief Top object member with given key */
+    token operator[](std::string_view key) const noexcept { return root()[key]; }
+    /** \brief Top array element at given index */
+    token operator[](std::size_t idx) const noexcept { return root()[idx]; }
+
+    /**
+     * \brief           Find token with \ref lwjson_find path rules
+     * \param[in]       path: Dot-separated path
+     * \return          Token view, empty view if not found
+     */
+    token find(const char* path) const noexcept { return token(lwjson_find(&lw_, path)); }
+
+#if LWJSON_CPP_STATIC_PATH || __DOXYGEN__
+    /**
+     * \brief           Find token with path resolved at compile time, see \ref token::find
+     * \tparam          P: Dot-separated path literal
+     * \return          Token view, empty view if not found
+     * \note            Requires C++20
+     */
+    template<detail::fixed_string P>
+    token find() const noexcept { return root().template find<P>(); }
+#endif /* LWJSON_CPP_STATIC_PATH || __DOXYGEN__ */
+
+    /**
+     * \brief           Immutable document for read access from many threads
+     * \return          Document, with `NULL` root if not parsed
+     */
+    lwjson_doc_t doc() const noexcept {
+        lwjson_doc_t d;
+        lwjson_get_doc(&lw_, &d);
+        return d;
+    }
+
+    /** \brief Get underlying C instance */
+    lwjson_t* get() noexcept { return &lw_; }
+    /** \brief Get underlying C instance */
+    const lwjson_t* get() const noexcept { return &lw_; }
+
+  private:
+    lwjson_token_t tokens_[N];
+    lwjson_t lw_;
+};
+
+#if LWJSON_CFG_TAPE || __DOXYGEN__
+
+/**
+ * \brief           Read-only view to one token of relocatable token tree
+ *
+ * View holds tape and token pointers and is valid as long as tape stays open.
+ * \note            Available only when \ref LWJSON_CFG_TAPE is enabled
+ */
+class tape_token {
+  public:
+    /**
+     * \brief           Forward iterator over children of object or array tape token
+     */
+    class iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = tape_token;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = tape_token;
+
+        constexpr iterator() noexcept = default;
+        constexpr iterator(const lwjson_tape_t* tape, const lwjson_tape_token_t* t) noexcept : tape_(tape), t_(t) {}
+
+        constexpr tape_token operator*() const noexcept { return tape_token(tape_, t_); }
+        iterator& operator++() noexcept { t_ = lwjson_tape_get_next(tape_, t_); return *this; }
+        iterator operator++(int) noexcept { iterator i = *this; ++*this; return i; }
+        constexpr bool operator==(const iterator& o) const noexcept { return t_ == o.t_; }
+        constexpr bool operator!=(const iterator& o) const noexcept { return t_ != o.t_; }
+
+      private:
+        const lwjson_tape_t* tape_ = nullptr;
+        const lwjson_tape_token_t* t_ = nullptr;
+    };
+
+    constexpr tape_token() noexcept = default;
+    constexpr tape_token(const lwjson_tape_t* tape, const lwjson_tape_token_t* t) noexcept : tape_(tape), t_(t) {}
+
+    /** \brief Check if view points to a token */
+    constexpr explicit operator bool() const noexcept { return t_ != nullptr; }
+    /** \brief Get raw C tape token, may be `nullptr` */
+    constexpr const lwjson_tape_token_t* get() const noexcept { return t_; }
+    /** \brief Get token type, \ref LWJSON_TYPE_NULL for empty view */
+    lwjson_type_t type() const noexcept { return t_ != nullptr ? static_cast<lwjson_type_t>(t_->type) : LWJSON_TYPE_NULL; }
+
+    bool is_object() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_OBJECT; }
+    bool is_array() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_ARRAY; }
+    bool is_string() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_STRING; }
+    bool is_int() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_NUM_INT; }
+    bool is_real() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_NUM_REAL; }
+    bool is_bool() const noexcept { return t_ != nullptr && (t_->type == LWJSON_TYPE_TRUE || t_->type == LWJSON_TYPE_FALSE); }
+    bool is_null() const noexcept { return t_ != nullptr && t_->type == LWJSON_TYPE_NULL; }
+
+    /** \brief Get token name, empty for array elements and top token, see \ref token::name */
+    std::string_view name() const noexcept {
+        std::size_t len = 0;
+        const char* n = lwjson_tape_get_name(tape_, t_, &len);
+        return n != nullptr ? std::string_view(n, len) : std::string_view();
+    }
+
+    /** \brief Get string value, empty if token is not \ref LWJSON_TYPE_STRING, see \ref token::str */
+    std::string_view str() const noexcept {
+        std::size_t len = 0;
+        const char* s = lwjson_tape_get_val_string(tape_, t_, &len);
+        return s != nullptr ? std::string_view(s, len) : std::string_view();
+    }
+
+    /**
+     * \brief           Get typed value with the same rules as \ref token::get
+     * \tparam          T: Output type
+     * \return          Token value or value-initialized `T` if type does not match
+     */
+    template<typename T>
+    T get() const noexcept {
+        if constexpr (std::is_same_v<T, bool>) {
+            return t_ != nullptr && t_->type == LWJSON_TYPE_TRUE;
+        } else if constexpr (std::is_integral_v<T>) {
+            return static_cast<T>(lwjson_tape_get_val_int(t_));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            return static_cast<T>(lwjson_tape_get_val_real(t_));
+        } else {
+            static_assert(std::is_same_v<T, std::string_view>, "Unsupported type for lwjson::tape_token::get");
+            return str();
+        }
+    }
+
+    /** \brief Iterator to first child, or end iterator if token has no children */
+    iterator begin() const noexcept { return iterator(tape_, lwjson_tape_get_first_child(tape_, t_)); }
+    /** \brief End iterator */
+    constexpr iterator end() const noexcept { return iterator(); }
+
+    /** \brief Check if object or array has no children */
+    bool empty() const noexcept { return begin() == end(); }
+
+    /** \brief Get number of children, walks children list */
+    std::size_t size() const noexcept {
+        std::size_t cnt = 0;
+        for (iterator it = begin(); it != end(); ++it, ++cnt) {}
+        return cnt;
+    }
+
+    /**
+     * \brief           Get first object member with given key
+     * \param[in]       key: Key to search for
+     * \return          Member view, empty view if not found or token is not object
+     */
+    tape_token operator[](std::string_view key) const noexcept {
+        if (is_object()) {
+            for (tape_token t : *this) {
+                if (t.name() == key) {
+                    return t;
+                }
+            }
+        }
+        return tape_token();
+    }
+
+    /**
+     * \brief           Get array element at given index
+     * \param[in]       idx: Element index
+     * \return          Element view, empty view if out of range or token is not array
+     */
+    tape_token operator[](std::size_t idx) const noexcept {
+        if (is_array()) {
+            for (tape_token t : *this) {
+                if (idx-- == 0) {
+                    return t;
+                }
+            }
+        }
+        return tape_token();
+    }
+
+    /**
+     * \brief           Find token relative to this token, see \ref lwjson_tape_find_ex
+     * \param[in]       path: Dot-separated path
+     * \return          Token view, empty view if not found
+     */
+    tape_token find(const char* path) const noexcept { return tape_token(tape_, lwjson_tape_find_ex(tape_, t_, path)); }
+
+  private:
+    const lwjson_tape_t* tape_ = nullptr;
+    const lwjson_tape_token_t* t_ = nullptr;
+};
+
+/**
+ * \brief           Relocatable token tree, closed when object is destroyed
+ *
+ * Tape holds memory map of loaded file, therefore it cannot be copied or moved.
+ * \note            Available only when \ref LWJSON_CFG_TAPE is enabled
+ */
+class tape {
+  public:
+    tape() noexcept = default;
+    tape(const tape&) = delete;
+    tape& operator=(const tape&) = delete;
+    ~tape() { close(); }
+
+    /**
+     * \brief           Open tape in memory, see \ref lwjson_tape_open
+     * \param[in]       data: Tape data, must stay valid while tape is used
+     * \param[in]       len: Length of data in units of bytes
+     * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+     */
+    lwjsonr_t open(const void* data, std::size_t len) noexcept {
+        close();
+        return lwjson_tape_open(&tape_, data, len);
+    }
+
+    /**
+     * \brief           Map tape from file descriptor, see \ref lwjson_tape_load
+     * \param[in]       fd: File descriptor, may be closed after function returns
+     * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+     */
+    lwjsonr_t load(int fd) noexcept {
+        close();
+        return lwjson_tape_load(&tape_, fd);
+    }
+
+    /** \brief Close tape and unmap loaded memory */
+    void close() noexcept { lwjson_tape_close(&tape_); }
+
+    /** \brief Check if tape is open */
+    bool opened() const noexcept { return tape_.tokens != nullptr; }
+    /** \brief Top token view, empty view if tape is not open */
+    tape_token root() const noexcept { return tape_token(&tape_, lwjson_tape_get_first_token(&tape_)); }
+
+    /** \brief Top object member with given key */
+    tape_token operator[](std::string_view key) const noexcept { return root()[key]; }
+    /** \brief Top array element at given index */
+    tape_token operator[](std::size_t idx) const noexcept { return root()[idx]; }
+
+    /**
+     * \brief           Find token with \ref lwjson_find path rules
+     * \param[in]       path: Dot-separated path
+     * \return          Token view, empty view if not found
+     */
+    tape_token find(const char* path) const noexcept { return tape_token(&tape_, lwjson_tape_find(&tape_, path)); }
+
+    /** \brief Get underlying C tape */
+    const lwjson_tape_t* get() const noexcept { return &tape_; }
+
+  private:
+    lwjson_tape_t tape_ = {};
+};
+
+#endif /* LWJSON_CFG_TAPE || __DOXYGEN__ */
+
+} /* namespace lwjson */
+
+/**
+ * \}
+ */
+
+#endif /* LWJSON_HDR_HPP */
@@ -72,6 +72,173 @@ extern "C" {
 #define LWJSON_CFG_INT_TYPE                 long long
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` source text span for every token
+ *
+ * When enabled, every token keeps pointer to and length of its value text in the input,
+ * including objects, arrays and numbers. Use \ref lwjson_get_raw to access it.
+ *
+ * \note            It increases size of every token by pointer and `size_t` variable
+ */
+#ifndef LWJSON_CFG_TOKEN_SPAN
+#define LWJSON_CFG_TOKEN_SPAN               0
+#endif
+
+/**
+ * \brief           Number of slots for hash tables of object members
+ *
+ * Merge, diff and JSON patch `test` operation keep one array of slots on stack,
+ * shared by tables of all objects on current nesting path, so that key lookup does not walk all members.
+ * Object with `n` members takes smallest power of `2` slots not less than `2 * n`.
+ * Objects that do not fit to remaining slots use linear lookup, that is quadratic to number of members.
+ *
+ * Every slot takes pointer and one byte of stack memory.
+ */
+#ifndef LWJSON_CFG_HASH_SLOTS
+#define LWJSON_CFG_HASH_SLOTS               256
+#endif
+
+/**
+ * \brief           Number of modifications \ref lwjson_json_patch_apply records in one pass over document
+ *
+ * Entries are created on stack. Patch with more modifications is applied in more passes,
+ * every pass writes and parses intermediate document.
+ */
+#ifndef LWJSON_CFG_JSON_PATCH_ENTRIES
+#define LWJSON_CFG_JSON_PATCH_ENTRIES       16
+#endif
+
+/**
+ * \brief           Maximal length of JSON pointer built by \ref lwjson_diff
+ *
+ * Buffer is created on stack. Diff fails with \ref lwjsonERRMEM for deeper paths.
+ */
+#ifndef LWJSON_CFG_DIFF_PATH_LEN
+#define LWJSON_CFG_DIFF_PATH_LEN            128
+#endif
+
+/**
+ * \brief           Maximal number of threads for parallel parsers
+ *
+ * Set to `0` to disable \ref lwjson_ndjson_parse_parallel, \ref lwjson_parse_parallel
+ * and \ref lwjson_parse_pipelined. Any other value enables them and requires POSIX threads
+ * and atomic extensions of GCC compatible compilers.
+ */
+#ifndef LWJSON_CFG_PARALLEL_THREADS
+#define LWJSON_CFG_PARALLEL_THREADS         0
+#endif
+
+/**
+ * \brief           Number of tokens of every parallel parser worker
+ *
+ * Tokens are allocated on worker stack. Records that need more tokens are reported
+ * to callback with \ref lwjsonERRMEM result.
+ */
+#ifndef LWJSON_CFG_NDJSON_TOKENS
+#define LWJSON_CFG_NDJSON_TOKENS            256
+#endif
+
+/**
+ * \brief           Number of tokens of every batch file parser worker
+ *
+ * Tokens are allocated on worker stack. Files that need more tokens are reported
+ * to callback with \ref lwjsonERRMEM result.
+ */
+#ifndef LWJSON_CFG_BATCH_TOKENS
+#define LWJSON_CFG_BATCH_TOKENS             1024
+#endif
+
+/**
+ * \brief           Size of input block claimed by parallel parser worker in units of bytes
+ *
+ * It is also minimal size of array part parsed by one thread in \ref lwjson_parse_parallel.
+ */
+#ifndef LWJSON_CFG_PARALLEL_BLOCK
+#define LWJSON_CFG_PARALLEL_BLOCK           65536
+#endif
+
+/**
+ * \brief           Number of quote positions in ring between scanner and parser thread
+ *
+ * Ring is used by \ref lwjson_parse_pipelined and is allocated on stack of calling thread.
+ * \note            Value must be multiple of `64`
+ */
+#ifndef LWJSON_CFG_PIPELINE_RING
+#define LWJSON_CFG_PIPELINE_RING            4096
+#endif
+
+/**
+ * \brief           Minimal number of online processors for \ref lwjson_parse_pipelined to start scanner thread
+ *
+ * With less processors, scanner and parser threads take turns on one processor
+ * and input is parsed by calling thread only, same as with \ref lwjson_parse_ex.
+ */
+#ifndef LWJSON_CFG_PIPELINE_MIN_CPUS
+#define LWJSON_CFG_PIPELINE_MIN_CPUS        2
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` pool of parser instances for concurrent use
+ *
+ * Pool uses atomic and thread-local storage extensions of GCC compatible compilers.
+ */
+#ifndef LWJSON_CFG_POOL
+#define LWJSON_CFG_POOL                     0
+#endif
+
+/**
+ * \brief           Number of released parser instances cached by every thread
+ */
+#ifndef LWJSON_CFG_POOL_CACHE
+#define LWJSON_CFG_POOL_CACHE               4
+#endif
+
+/**
+ * \brief           Cache line size in units of bytes, used to align pool items
+ */
+#ifndef LWJSON_CFG_CACHE_LINE
+#define LWJSON_CFG_CACHE_LINE               64
+#endif
+
+/**
+ * \brief           Maximal nesting level of objects and arrays written by \ref lwjson_writer_t
+ *
+ * Parser has no nesting limit, documents nested deeper than this
+ * cannot be written with \ref lwjson_writer_token or \ref lwjson_serialize and return \ref lwjsonERRMEM.
+ * Every level takes `2` bits of writer instance, maximal value is `65535`.
+ */
+#ifndef LWJSON_CFG_WRITER_MAX_DEPTH
+#define LWJSON_CFG_WRITER_MAX_DEPTH         32
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` relocatable token tree, stored to files or shared memory
+ *
+ * Tape files are read with `mmap` and require POSIX system.
+ */
+#ifndef LWJSON_CFG_TAPE
+#define LWJSON_CFG_TAPE                     0
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` parsing of gzip compressed newline delimited JSON
+ *
+ * Requires zlib library, application must link with `-lz`.
+ */
+#ifndef LWJSON_CFG_ZLIB
+#define LWJSON_CFG_ZLIB                     0
+#endif
+
+/**
+ * \brief           Number of bytes decompressed at once, when \ref LWJSON_CFG_ZLIB is enabled
+ *
+ * Every record of compressed input must fit into window.
+ * Parser allocates `4` times this size, for two windows with space for records crossing window end.
+ */
+#ifndef LWJSON_CFG_INFLATE_WINDOW
+#define LWJSON_CFG_INFLATE_WINDOW           65536
+#endif
+
 /**
  * \}
  */
@@ -31,8 +31,15 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         $_version_$
  */
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 700                       /* sysconf with strict C standard */
+#endif
 #include <string.h>
 #include "lwjson/lwjson.h"
+#if LWJSON_CFG_PARALLEL_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
 
 /**
  * \brief           Allocate new token for JSON block
@@ -51,66 +58,222 @@ prv_alloc_token(lwjson_t* lw) {
 /**
  * \brief           Skip all characters that are considered *blank* as per RFC4627
  * \param[in,out]   p: Pointer to text that is modified on success
+ * \param[in]       end: End of input text
  * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
  */
 static lwjsonr_t
-prv_skip_blank(const char** p) {
+prv_skip_blank(const char** p, const char* end) {
     const char* s = *p;
-    while (s != NULL && *s != '\0') {
-        if (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n' || *s == '\f') {
-            ++s;
-            continue;
+
+    if (s == NULL) {
+        return lwjsonERR;
+    }
+    for (; s < end && (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n' || *s == '\f'); ++s) {}
+    *p = s;
+    return lwjsonOK;
+}
+
+#if LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__
+
+/**
+ * \brief           Number of polls of the other thread's index before waiting thread sleeps
+ */
+#define LWJSON_PIPELINE_SPIN                1024
+
+/**
+ * \brief           Single producer single consumer ring of quote positions
+ *
+ * Scanner thread writes positions of all unescaped quote characters, in input order,
+ * and `NULL` at the end of input. Parser thread takes two positions for every string.
+ * Thread that cannot continue polls the other thread's index for a short time, then sleeps on condition variable.
+ */
+typedef struct {
+    const char* pos[LWJSON_CFG_PIPELINE_RING];  /*!< Quote positions */
+    const char* data;                           /*!< Start of input text */
+    const char* end;                            /*!< End of input text */
+    pthread_mutex_t mutex;                      /*!< Protects sleeping threads */
+    pthread_cond_t cond;                        /*!< Signalled when index is published while thread sleeps */
+    LWJSON_ALIGNED(LWJSON_CFG_CACHE_LINE) size_t head; /*!< Number of published positions */
+    uint8_t stop;                               /*!< Set by parser to stop the scanner */
+    uint8_t sleeping;                           /*!< Number of threads sleeping on condition variable */
+    LWJSON_ALIGNED(LWJSON_CFG_CACHE_LINE) size_t tail; /*!< Number of consumed positions, published */
+    size_t c_head;                              /*!< Consumer copy of head */
+    size_t c_tail;                              /*!< Consumer count of consumed positions */
+} lwjson_quote_ring_t;
+
+/**
+ * \brief           Publish index to the other thread and wake it up if it sleeps
+ * \param[in,out]   ring: Quote ring
+ * \param[out]      idx: Index to publish, `head` or `tail` of the ring
+ * \param[in]       val: New index value
+ */
+static void
+prv_ring_publish(lwjson_quote_ring_t* ring, size_t* idx, size_t val) {
+    /* Sequentially consistent store and load pair with the ones in prv_ring_wait, no wakeup is lost */
+    __atomic_store_n(idx, val, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->sleeping, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&ring->mutex);
+        pthread_cond_broadcast(&ring->cond);
+        pthread_mutex_unlock(&ring->mutex);
+    }
+}
+
+/**
+ * \brief           Wait until the other thread changes index or parser stops
+ * \param[in,out]   ring: Quote ring
+ * \param[in]       idx: Index published by the other thread
+ * \param[in]       val: Current index value to wait to change
+ */
+static void
+prv_ring_wait(lwjson_quote_ring_t* ring, const size_t* idx, size_t val) {
+    for (size_t i = 0; i < LWJSON_PIPELINE_SPIN; ++i) {
+        if (__atomic_load_n(idx, __ATOMIC_ACQUIRE) != val || __atomic_load_n(&ring->stop, __ATOMIC_ACQUIRE)) {
+            return;
         }
-        *p = s;
-        return lwjsonOK;
     }
-    if (s != NULL && *s == '\0') {
-        return lwjsonOK;
+    pthread_mutex_lock(&ring->mutex);
+    __atomic_add_fetch(&ring->sleeping, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(idx, __ATOMIC_SEQ_CST) == val && !__atomic_load_n(&ring->stop, __ATOMIC_SEQ_CST)) {
+        pthread_cond_wait(&ring->cond, &ring->mutex);
+    }
+    __atomic_sub_fetch(&ring->sleeping, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&ring->mutex);
+}
+
+/**
+ * \brief           Take next quote position from the ring, wait until available
+ * \param[in,out]   ring: Quote ring
+ * \return          Quote position, `NULL` at the end of input
+ */
+static const char*
+prv_ring_next(lwjson_quote_ring_t* ring) {
+    const char* pos;
+
+    while (ring->c_tail == ring->c_head) {
+        prv_ring_publish(ring, &ring->tail, ring->c_tail);
+        if ((ring->c_head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) == ring->c_tail) {
+            prv_ring_wait(ring, &ring->head, ring->c_tail);
+            ring->c_head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        }
+    }
+    pos = ring->pos[ring->c_tail++ % LWJSON_CFG_PIPELINE_RING];
+    if (ring->c_tail % 64 == 0) {
+        prv_ring_publish(ring, &ring->tail, ring->c_tail);
+    }
+    return pos;
+}
+
+/**
+ * \brief           Find closing quote of string using positions from scanner thread
+ * \param[in,out]   ring: Quote ring
+ * \param[in]       s: First character after opening quote
+ * \return          Position of closing quote, `NULL` if not found
+ */
+static const char*
+prv_ring_string_end(lwjson_quote_ring_t* ring, const char* s) {
+    if (prv_ring_next(ring) != s - 1) {
+        return NULL;                            /* Parser and scanner disagree, input is not valid */
+    }
+    return prv_ring_next(ring);
+}
+
+/**
+ * \brief           Scanner thread, publishes positions of unescaped quotes
+ * \param[in,out]   arg: Quote ring
+ * \return          Always `NULL`
+ */
+static void*
+prv_ring_scan(void* arg) {
+    lwjson_quote_ring_t* ring = arg;
+    const char* p = ring->data, *q;
+    size_t head = 0, tail = 0;
+
+    do {
+        /* Quote preceded by odd number of backslashes is part of string */
+        q = p < ring->end ? memchr(p, '"', (size_t)(ring->end - p)) : NULL;
+        if (q != NULL) {
+            const char* b = q;
+            for (; b > ring->data && b[-1] == '\\'; --b) {}
+            if ((q - b) % 2 != 0) {
+                p = q + 1;
+                continue;
+            }
+        }
+        while (head - tail == LWJSON_CFG_PIPELINE_RING) {
+            prv_ring_publish(ring, &ring->head, head);
+            if (__atomic_load_n(&ring->stop, __ATOMIC_ACQUIRE)) {
+                return NULL;
+            }
+            if ((tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) + LWJSON_CFG_PIPELINE_RING == head) {
+                prv_ring_wait(ring, &ring->tail, tail);
+                tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+            }
+        }
+        ring->pos[head++ % LWJSON_CFG_PIPELINE_RING] = q;
+        if (q == NULL || head % 64 == 0) {
+            prv_ring_publish(ring, &ring->head, head);
+        }
+        p = q + 1;
+    } while (q != NULL);
+    return NULL;
+}
+
+#else
+typedef struct lwjson_quote_ring lwjson_quote_ring_t;   /* Never created without threads */
+#define prv_ring_string_end(ring, s)        NULL
+#endif /* LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__ */
+
+/**
+ * \brief           Find closing quote of string
+ * \param[in]       s: First character after opening quote
+ * \param[in]       end: End of input text
+ * \return          Position of closing quote, `NULL` if not found
+ */
+static const char*
+prv_string_end(const char* s, const char* end) {
+    for (; s < end && *s != '\0'; ++s) {
+        /* Character after backslash is always part of string, also when it is another backslash */
+        if (*s == '\\') {
+            if (s + 1 >= end || *(s + 1) == '\0') {
+                return NULL;
+            }
+            ++s;
+        } else if (*s == '"') {
+            return s;
+        }
     }
-    return lwjsonERR;
+    return NULL;
 }
 
 /**
  * \brief           Parse JSON string that must start end end with double quotes `"` character
  * It just parses length of characters and does not perform any decode operation
  * \param[in,out]   p: Pointer to text that is modified on success
+ * \param[in]       end: End of input text
+ * \param[in,out]   ring: Quote positions from scanner thread, `NULL` to scan the string here
  * \param[out]      pout: Pointer to pointer to string that is set where string starts
  * \param[out]      poutlen: Length of string in units of characters is stored here
  * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
  */
 static lwjsonr_t
-prv_parse_string(const char** p, const char** pout, size_t* poutlen) {
+prv_parse_string(const char** p, const char* end, lwjson_quote_ring_t* ring, const char** pout, size_t* poutlen) {
     const char* s;
     lwjsonr_t res;
-    size_t len = 0;
 
-    if ((res = prv_skip_blank(p)) != lwjsonOK) {
+    if ((res = prv_skip_blank(p, end)) != lwjsonOK) {
         return res;
     }
     s = *p;
-    if (*s++ != '"') {
+    if (s >= end || *s++ != '"') {
         return lwjsonERRJSON;
     }
     *pout = s;
-    /* Parse string but take care of escape characters */
-    for (char prev_ch = '\0';; ++s, ++len) {
-        if (s == NULL || *s == '\0') {
-            return lwjsonERRJSON;
-        }
-        /* Check end of string */
-        if (*s == '"') {
-            if (prev_ch != '\\') {
-                ++s;
-                break;
-            }
-        }
-        prev_ch = *s;
-    }
-    *poutlen = len;
-    if (*s == '"') {
-        ++s;
+    if ((s = ring != NULL ? prv_ring_string_end(ring, s) : prv_string_end(s, end)) == NULL) {
+        return lwjsonERRJSON;
     }
-    if ((res = prv_skip_blank(&s)) != lwjsonOK) {
+    *poutlen = (size_t)(s - *pout);
+    ++s;
+    if ((res = prv_skip_blank(&s, end)) != lwjsonOK) {
         return res;
     }
     *p = s;
@@ -121,90 +284,103 @@ prv_parse_string(const char** p, const char** pout, size_t* poutlen) {
  * \brief           Parse property name that must comply with JSON string format as in RFC4627
  * Property string must be followed by colon character ":"
  * \param[in,out]   p: Pointer to text that is modified on success
+ * \param[in]       end: End of input text
+ * \param[in,out]   ring: Quote positions from scanner thread, `NULL` if not used
  * \param[out]      t: Token instance to write property name to
  * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
  */
 static lwjsonr_t
-prv_parse_property_name(const char** p, lwjson_token_t* t) {
+prv_parse_property_name(const char** p, const char* end, lwjson_quote_ring_t* ring, lwjson_token_t* t) {
     const char* s = *p;
     lwjsonr_t res;
 
-    if ((res = prv_parse_string(p, &t->token_name, &t->token_name_len)) != lwjsonOK) {
+    if ((res = prv_parse_string(p, end, ring, &t->token_name, &t->token_name_len)) != lwjsonOK) {
         return res;
     }
     s = *p;
-    if (*s != ':') {
+    if (s >= end || *s != ':') {
         return lwjsonERRJSON;
     }
     ++s;
-    prv_skip_blank(&s);
+    prv_skip_blank(&s, end);
     *p = s;
     return lwjsonOK;
 }
 
+/**
+ * \brief           Get character at position or `0` at the end of input text
+ * \param[in]       s: Position in input text
+ * \param[in]       end: End of input text
+ * \return          Character at position
+ */
+static char
+prv_char(const char* s, const char* end) {
+    return s < end ? *s : '\0';
+}
+
 /**
  * \brief           Parse number as described in RFC4627
  * \param[in,out]   p: Pointer to text that is modified on success
+ * \param[in]       end: End of input text
  * \param[out]      tout: Pointer to output number format
  * \param[out]      fout: Pointer to output real-type variable. Used if type is REAL.
  * \param[out]      iout: Pointer to output int-type variable. Used if type is INT.
  * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
  */
 static lwjsonr_t
-prv_parse_number(const char** p, lwjson_type_t* tout, lwjson_real_t* fout, lwjson_int_t* iout) {
+prv_parse_number(const char** p, const char* end, lwjson_type_t* tout, lwjson_real_t* fout, lwjson_int_t* iout) {
     const char* s = *p;
     lwjsonr_t res;
     uint8_t is_minus;
     lwjson_real_t num;
     lwjson_type_t type = LWJSON_TYPE_NUM_INT;
 
-    if ((res = prv_skip_blank(p)) != lwjsonOK) {
+    if ((res = prv_skip_blank(p, end)) != lwjsonOK) {
         return res;
     }
     s = *p;
-    if (*s == '\0') {
+    if (prv_char(s, end) == '\0') {
         return lwjsonERRJSON;
     }
     is_minus = *s == '-' ? (++s, 1) : 0;
-    if (*s == '\0'                              /* Invalid string */
-        || *s < '0' || *s > '9'                 /* Character outside number range */
-        || (*s == '0' && (*(s + 1) < '0' && *(s + 1) > '9'))) { /* Number starts with 0 but not followed by dot */
+    if (prv_char(s, end) == '\0'                /* Invalid string */
+        || *s < '0' || *s > '9') {              /* Character outside number range */
         return lwjsonERRJSON;
     }
     /* Parse number */
-    for (num = 0; *s >= '0' && *s <= '9'; ++s) {
+    for (num = 0; s < end && *s >= '0' && *s <= '9'; ++s) {
         num = num * 10 + (*s - '0');
     }
-    if (s != NULL && *s == '.') {               /* Number has exponent */
+    if (prv_char(s, end) == '.') {              /* Number has exponent */
         lwjson_real_t exp, dec_num;
 
         type = LWJSON_TYPE_NUM_REAL;            /* Format is real */
         ++s;                                    /* Ignore comma character */
-        if (*s < '0' || *s > '9') {             /* Must be followed by number characters */
+        if (prv_char(s, end) < '0' || *s > '9') {   /* Must be followed by number characters */
             return lwjsonERRJSON;
         }
         /* Get number after decimal point */
-        for (exp = 1, dec_num = 0; *s >= '0' && *s <= '9'; ++s, exp *= 10) {
+        for (exp = 1, dec_num = 0; s < end && *s >= '0' && *s <= '9'; ++s, exp *= 10) {
             dec_num = dec_num * 10 + (*s - '0');
         }
         num += dec_num / exp;                   /* Add decimal part to number */
     }
-    if (s != NULL && (*s == 'e' || *s == 'E')) {/* Engineering mode */
+    if (prv_char(s, end) == 'e' || prv_char(s, end) == 'E') {   /* Engineering mode */
         uint8_t is_minus_exp;
         int exp_cnt;
 
         type = LWJSON_TYPE_NUM_REAL;            /* Format is real */
         ++s;                                    /* Ignore enginnering sing part */
-        is_minus_exp = *s == '-' ? (++s, 1) : 0;/* Check if negative */
-        if (*s == '+') {                        /* Optional '+' is possible too */
+        is_minus_exp = prv_char(s, end) == '-' ? (++s, 1) : 0;/* Check if negative */
+        if (prv_char(s, end) == '+') {          /* Optional '+' is possible too */
             ++s;
         }
-        if (*s < '0' || *s > '9') {             /* Must be followed by number characters */
+        if (prv_char(s, end) < '0' || *s > '9') {   /* Must be followed by number characters */
             return lwjsonERRJSON;
         }
 
         /* Parse exponent number */
-        for (exp_cnt = 0; *s >= '0' && *s <= '9'; ++s) {
+        for (exp_cnt = 0; s < end && *s >= '0' && *s <= '9'; ++s) {
             exp_cnt = exp_cnt * 10 + (*s - '0');
         }
         /* Calculate new value for exponent 10^exponent */
@@ -275,42 +451,58 @@ prv_create_path_segment(const char** p, const char** opath, size_t* olen, uint8_
     return 1;
 }
 
+/**
+ * \brief           Token tree accessors for path search
+ *
+ * Search walks parsed token tree and tape with the same code, trees differ only in how tokens are linked.
+ */
+typedef struct {
+    /**
+     * \brief           Get first child of container token
+     * \param[in]       tree: Tree token belongs to
+     * \param[in]       token: Parent token
+     * \param[in]       type: Required type of parent token
+     * \return          First child, `NULL` if token is not of required type or is empty
+     */
+    const void* (*first_child)(const void* tree, const void* token, lwjson_type_t type);
+    const void* (*next)(const void* tree, const void* token); /*!< Get next token on a list, `NULL` for last */
+    uint8_t (*name_is)(const void* tree, const void* token, const char* name,
+                       size_t name_len); /*!< Check if token name is equal to `name` */
+} prv_tree_t;
+
 /**
  * \brief           Input recursive function for find operation
+ * \param[in]       acc: Tree accessors
+ * \param[in]       tree: Tree to search in, passed to accessors
  * \param[in]       parent: Parent token of type \ref LWJSON_TYPE_ARRAY or LWJSON_TYPE_OBJECT
  * \param[in]       path: Path to search for starting this token further
  * \return          Found token on success, `NULL` otherwise
  */
-static const lwjson_token_t*
-prv_find(const lwjson_token_t* parent, const char* path) {
-    lwjson_token_t* token = NULL;
+static const void*
+prv_find(const prv_tree_t* acc, const void* tree, const void* parent, const char* path) {
     const char* segment;
     size_t segment_len;
-    uint8_t is_last, result;
+    uint8_t is_last;
 
     /* Get path segments */
-    if ((result = prv_create_path_segment(&path, &segment, &segment_len, &is_last)) != 0) {
+    if (prv_create_path_segment(&path, &segment, &segment_len, &is_last)) {
         /* Check if detected an array request */
         if (*segment == '#' && segment_len == 1) {
-            if (parent->type != LWJSON_TYPE_ARRAY) {
-                return NULL;
-            }
-            for (const lwjson_token_t* tmp_t, *t = parent->u.first_child; t != NULL; t = t->next) {
-                if ((tmp_t = prv_find(t, path)) != NULL) {
+            for (const void *tmp_t, *t = acc->first_child(tree, parent, LWJSON_TYPE_ARRAY); t != NULL;
+                 t = acc->next(tree, t)) {
+                if ((tmp_t = prv_find(acc, tree, t, path)) != NULL) {
                     return tmp_t;
                 }
             }
         } else {
-            if (parent->type != LWJSON_TYPE_OBJECT) {
-                return NULL;
-            }
-            for (const lwjson_token_t* t = parent->u.first_child; t != NULL; t = t->next) {
-                if (t->token_name_len == segment_len && !strncmp(t->token_name, segment, segment_len)) {
-                    const lwjson_token_t* tmp_t;
+            for (const void* t = acc->first_child(tree, parent, LWJSON_TYPE_OBJECT); t != NULL;
+                 t = acc->next(tree, t)) {
+                if (acc->name_is(tree, t, segment, segment_len)) {
+                    const void* tmp_t;
                     if (is_last) {
                         return t;
                     }
-                    if ((tmp_t = prv_find(t, path)) != NULL) {
+                    if ((tmp_t = prv_find(acc, tree, t, path)) != NULL) {
                         return tmp_t;
                     }
                 }
@@ -320,6 +512,227 @@ prv_find(const lwjson_token_t* parent, const char* path) {
     return NULL;
 }
 
+/**
+ * \brief           Get first child of parsed token, see \ref prv_tree_t
+ */
+static const void*
+prv_token_first_child(const void* tree, const void* token, lwjson_type_t type) {
+    const lwjson_token_t* t = token;
+
+    (void)tree;
+    return t->type == type ? t->u.first_child : NULL;
+}
+
+/**
+ * \brief           Get next parsed token, see \ref prv_tree_t
+ */
+static const void*
+prv_token_next(const void* tree, const void* token) {
+    (void)tree;
+    return ((const lwjson_token_t*)token)->next;
+}
+
+/**
+ * \brief           Compare name of parsed token, see \ref prv_tree_t
+ */
+static uint8_t
+prv_token_name_is(const void* tree, const void* token, const char* name, size_t name_len) {
+    const lwjson_token_t* t = token;
+
+    (void)tree;
+    return t->token_name_len == name_len && !strncmp(t->token_name, name, name_len);
+}
+
+/**
+ * \brief           Accessors of parsed token tree
+ */
+static const prv_tree_t prv_token_tree = {prv_token_first_child, prv_token_next, prv_token_name_is};
+
+#if LWJSON_CFG_TAPE || __DOXYGEN__
+
+/**
+ * \brief           Get first child of tape token, see \ref prv_tree_t
+ */
+static const void*
+prv_tape_first_child(const void* tree, const void* token, lwjson_type_t type) {
+    const lwjson_tape_token_t* t = token;
+
+    return t->type == (uint32_t)type ? lwjson_tape_get_token(tree, t->u.first_child) : NULL;
+}
+
+/**
+ * \brief           Get next tape token, see \ref prv_tree_t
+ */
+static const void*
+prv_tape_next(const void* tree, const void* token) {
+    return lwjson_tape_get_next((const lwjson_tape_t*)tree, (const lwjson_tape_token_t*)token);
+}
+
+/**
+ * \brief           Compare name of tape token, see \ref prv_tree_t
+ */
+static uint8_t
+prv_tape_name_is(const void* tree, const void* token, const char* name, size_t name_len) {
+    const char* t_name;
+    size_t t_name_len;
+
+    return (t_name = lwjson_tape_get_name(tree, token, &t_name_len)) != NULL && t_name_len == name_len
+           && !strncmp(t_name, name, name_len);
+}
+
+/**
+ * \brief           Accessors of tape
+ */
+static const prv_tree_t prv_tape_tree = {prv_tape_first_child, prv_tape_next, prv_tape_name_is};
+
+#endif /* LWJSON_CFG_TAPE || __DOXYGEN__ */
+
+/**
+ * \brief           Write integer value to member of given size
+ * \param[out]      dst: Pointer to member
+ * \param[in]       size: Member size in units of bytes
+ * \param[in]       num: Value to write
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM if value does not fit to member,
+ *                      member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_bind_int(void* dst, size_t size, lwjson_int_t num) {
+    switch (size) {
+        case sizeof(int8_t):
+            if (num < INT8_MIN || num > INT8_MAX) {
+                return lwjsonERRMEM;
+            }
+            *(int8_t *)dst = (int8_t)num;
+            break;
+        case sizeof(int16_t):
+            if (num < INT16_MIN || num > INT16_MAX) {
+                return lwjsonERRMEM;
+            }
+            *(int16_t *)dst = (int16_t)num;
+            break;
+        case sizeof(int32_t):
+            if (num < INT32_MIN || num > INT32_MAX) {
+                return lwjsonERRMEM;
+            }
+            *(int32_t *)dst = (int32_t)num;
+            break;
+        case sizeof(int64_t): *(int64_t *)dst = (int64_t)num; break;
+        default: return lwjsonERR;
+    }
+    return lwjsonOK;
+}
+
+static lwjsonr_t prv_bind_object(const lwjson_token_t* parent, const lwjson_binding_t* bindings, uint8_t* out);
+
+/**
+ * \brief           Write token value to bound member
+ * \param[in]       t: Token with value
+ * \param[in]       b: Binding entry describing the member
+ * \param[out]      dst: Pointer to member
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_bind_value(const lwjson_token_t* t, const lwjson_binding_t* b, uint8_t* dst) {
+    lwjsonr_t res = lwjsonOK;
+
+    /* Null leaves member untouched */
+    if (t->type == LWJSON_TYPE_NULL) {
+        return lwjsonOK;
+    }
+    switch (b->type) {
+        case LWJSON_BIND_INT:
+            if (t->type != LWJSON_TYPE_NUM_INT) {
+                return lwjsonERR;
+            }
+            return prv_bind_int(dst, b->size, t->u.num_int);
+        case LWJSON_BIND_BOOL:
+            if (t->type != LWJSON_TYPE_TRUE && t->type != LWJSON_TYPE_FALSE) {
+                return lwjsonERR;
+            }
+            return prv_bind_int(dst, b->size, t->type == LWJSON_TYPE_TRUE);
+        case LWJSON_BIND_REAL: {
+            lwjson_real_t num;
+
+            if (t->type == LWJSON_TYPE_NUM_REAL) {
+                num = t->u.num_real;
+            } else if (t->type == LWJSON_TYPE_NUM_INT) {
+                num = (lwjson_real_t)t->u.num_int;
+            } else {
+                return lwjsonERR;
+            }
+            if (b->size == sizeof(float)) {
+                *(float *)dst = (float)num;
+            } else if (b->size == sizeof(double)) {
+                *(double *)dst = (double)num;
+            } else {
+                return lwjsonERR;
+            }
+            break;
+        }
+        case LWJSON_BIND_STRING:
+            if (t->type != LWJSON_TYPE_STRING) {
+                return lwjsonERR;
+            }
+            if (t->u.str.token_value_len >= b->size) {
+                return lwjsonERRMEM;
+            }
+            memcpy(dst, t->u.str.token_value, t->u.str.token_value_len);
+            dst[t->u.str.token_value_len] = '\0';
+            break;
+        case LWJSON_BIND_OBJECT:
+            if (t->type != LWJSON_TYPE_OBJECT || b->sub == NULL) {
+                return lwjsonERR;
+            }
+            return prv_bind_object(t, b->sub, dst);
+        case LWJSON_BIND_ARRAY: {
+            size_t i = 0, cnt;
+
+            if (t->type != LWJSON_TYPE_ARRAY || b->sub == NULL || b->sub->size == 0) {
+                return lwjsonERR;
+            }
+            cnt = b->size / b->sub->size;
+            for (const lwjson_token_t* c = t->u.first_child; c != NULL; c = c->next, ++i) {
+                if (i == cnt) {
+                    return lwjsonERRMEM;
+                }
+                if ((res = prv_bind_value(c, b->sub, dst + i * b->sub->size)) != lwjsonOK) {
+                    return res;
+                }
+            }
+            break;
+        }
+        default:
+            return lwjsonERR;
+    }
+    return res;
+}
+
+/**
+ * \brief           Bind all children of object token to structure in single pass
+ * \param[in]       parent: Token of \ref LWJSON_TYPE_OBJECT type
+ * \param[in]       bindings: Binding table terminated with \ref LWJSON_BIND_END
+ * \param[out]      out: Pointer to structure to fill
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_bind_object(const lwjson_token_t* parent, const lwjson_binding_t* bindings, uint8_t* out) {
+    lwjsonr_t res;
+
+    for (const lwjson_token_t* t = parent->u.first_child; t != NULL; t = t->next) {
+        for (const lwjson_binding_t* b = bindings; b->name != NULL; ++b) {
+            /* Length and first character are checked before full compare */
+            if (b->name_len == t->token_name_len
+                && (b->name_len == 0 || (b->name[0] == t->token_name[0] && !memcmp(b->name, t->token_name, b->name_len)))) {
+                if ((res = prv_bind_value(t, b, out + b->offset)) != lwjsonOK) {
+                    return res;
+                }
+                break;
+            }
+        }
+    }
+    return lwjsonOK;
+}
+
 /**
  * \brief           Setup LwJSON instance for parsing JSON strings
  * \param[in,out]   lw: LwJSON instance
@@ -338,35 +751,46 @@ lwjson_init(lwjson_t* lw, lwjson_token_t* tokens, size_t tokens_len) {
 }
 
 /**
- * \brief           Parse input JSON format
- * JSON format must be complete and must comply with RFC4627
- * \param[in,out]   lw: LwJSON instance
- * \param[in]       json_str: JSON string to parse
+ * \brief           Parse JSON text to tokens
+ *
+ * Last child of open object or array is kept in its `next` field during parsing,
+ * so that new children are appended in constant time.
+ *
+ * \param[in,out]   lw: LwJSON instance with reset top token and token counter
+ * \param[in,out]   pp: Pointer to input text, set to position where parsing stopped
+ * \param[in]       end: End of input text
+ * \param[in,out]   ring: Quote positions from scanner thread, `NULL` if not used
+ * \param[in]       elements: Set to `1` to parse elements of top array with opening bracket already consumed.
+ *                      Parsing then also succeeds when `end` is reached between two elements
+ * \param[out]      closed: Set to `1` when top object or array was closed. Set to `NULL` if not used
  * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
  */
-lwjsonr_t
-lwjson_parse(lwjson_t* lw, const char* json_str) {
+static lwjsonr_t
+prv_parse(lwjson_t* lw, const char** pp, const char* end, lwjson_quote_ring_t* ring, uint8_t elements, uint8_t* closed) {
     lwjsonr_t res = lwjsonOK;
-    const char* p = json_str;
+    const char* p = *pp;
     lwjson_token_t* t, *to = &lw->first_token;
-    uint8_t first_check = 1;
+    uint8_t first_check = !elements;
 
-    /* values from very beginning */
-    lw->flags.parsed = 0;
-    lw->next_free_token_pos = 0;
-    memset(to, 0x00, sizeof(*to));
-
-    /* Check input data first */
-    if (p == NULL || *p == '\0') {
-        return lwjsonERRJSON;
+    if (elements) {
+        to->type = LWJSON_TYPE_ARRAY;
+#if LWJSON_CFG_TOKEN_SPAN
+        to->token_raw = p;
+#endif /* LWJSON_CFG_TOKEN_SPAN */
+    }
+    if (closed != NULL) {
+        *closed = 0;
     }
 
     /* Process all characters */
-    while (p != NULL && *p != '\0') {
+    while (p < end && *p != '\0') {
         /* Filter out blanks */
-        if ((res = prv_skip_blank(&p)) != lwjsonOK) {
+        if ((res = prv_skip_blank(&p, end)) != lwjsonOK) {
             goto ret;
         }
+        if (p >= end) {
+            break;
+        }
         if (first_check) {
             first_check = 0;
             if (*p == '{') {
@@ -377,6 +801,9 @@ lwjson_parse(lwjson_t* lw, const char* json_str) {
                 res = lwjsonERRMEM;
                 goto ret;
             }
+#if LWJSON_CFG_TOKEN_SPAN
+            to->token_raw = p;
+#endif /* LWJSON_CFG_TOKEN_SPAN */
             ++p;
             continue;
         }
@@ -387,15 +814,21 @@ lwjson_parse(lwjson_t* lw, const char* json_str) {
 
         /* Check if end of object or array*/
         if (*p == (to->type == LWJSON_TYPE_OBJECT ? '}' : ']')) {
-            lwjson_token_t* parent = to->next;
+            lwjson_token_t* parent = to->parent;
             to->next = NULL;
+#if LWJSON_CFG_TOKEN_SPAN
+            to->token_raw_len = (size_t)(p + 1 - to->token_raw);
+#endif /* LWJSON_CFG_TOKEN_SPAN */
             to = parent;
             ++p;
 
             /* End of string, check if properly terminated */
             if (to == NULL) {
-                prv_skip_blank(&p);
-                res = (p == NULL || *p == '\0') ? lwjsonOK : lwjsonERR;
+                if (closed != NULL) {
+                    *closed = 1;
+                }
+                prv_skip_blank(&p, end);
+                res = prv_char(p, end) == '\0' ? lwjsonOK : lwjsonERR;
                 goto ret;
             }
             continue;
@@ -407,6 +840,7 @@ lwjson_parse(lwjson_t* lw, const char* json_str) {
             res = lwjsonERRMEM;
             goto ret;
         }
+        t->parent = to;
 
         /* If object type is not array, first thing is property that starts with quotes */
         if (to->type != LWJSON_TYPE_ARRAY) {
@@ -414,31 +848,33 @@ lwjson_parse(lwjson_t* lw, const char* json_str) {
                 res = lwjsonERRJSON;
                 goto ret;
             }
-            if ((res = prv_parse_property_name(&p, t)) != lwjsonOK) {
+            if ((res = prv_parse_property_name(&p, end, ring, t)) != lwjsonOK) {
                 goto ret;
             }
         }
         
-        /* Add element to linked list */
+        /* Add element to linked list, after last child of the open object or array */
         if (to->u.first_child == NULL) {
             to->u.first_child = t;
         } else {
-            lwjson_token_t* c;
-            for (c = to->u.first_child; c->next != NULL; c = c->next) {}
-            c->next = t;
+            to->next->next = t;
         }
+        to->next = t;
+
+#if LWJSON_CFG_TOKEN_SPAN
+        t->token_raw = p;
+#endif /* LWJSON_CFG_TOKEN_SPAN */
 
         /* Check next character to process */
-        switch (*p) {
+        switch (prv_char(p, end)) {
             case '{':
             case '[':
                 t->type = *p == '{' ? LWJSON_TYPE_OBJECT : LWJSON_TYPE_ARRAY;
-                t->next = to;           /* Temporary saved as parent object */
                 to = t;
                 ++p;
                 break;
             case '"':
-                if ((res = prv_parse_string(&p, &t->u.str.token_value, &t->u.str.token_value_len)) == lwjsonOK) {
+                if ((res = prv_parse_string(&p, end, ring, &t->u.str.token_value, &t->u.str.token_value_len)) == lwjsonOK) {
                     t->type = LWJSON_TYPE_STRING;
                 } else {
                     goto ret;
@@ -446,7 +882,7 @@ lwjson_parse(lwjson_t* lw, const char* json_str) {
                 break;
             case 't':
                 /* RFC4627 is lower-case only */
-                if (strncmp(p, "true", 4) == 0) {
+                if (end - p >= 4 && strncmp(p, "true", 4) == 0) {
                     t->type = LWJSON_TYPE_TRUE;
                     p += 4;
                 } else {
@@ -456,7 +892,7 @@ lwjson_parse(lwjson_t* lw, const char* json_str) {
                 break;
             case 'f':
                 /* RFC4627 is lower-case only */
-                if (strncmp(p, "false", 5) == 0) {
+                if (end - p >= 5 && strncmp(p, "false", 5) == 0) {
                     t->type = LWJSON_TYPE_FALSE;
                     p += 5;
                 } else {
@@ -466,7 +902,7 @@ lwjson_parse(lwjson_t* lw, const char* json_str) {
                 break;
             case 'n':
                 /* RFC4627 is lower-case only */
-                if (strncmp(p, "null", 4) == 0) {
+                if (end - p >= 4 && strncmp(p, "null", 4) == 0) {
                     t->type = LWJSON_TYPE_NULL;
                     p += 4;
                 } else {
@@ -476,7 +912,7 @@ lwjson_parse(lwjson_t* lw, const char* json_str) {
                 break;
             default:
                 if (*p == '-' || (*p >= '0' && *p <= '9')) {
-                    if (prv_parse_number(&p, &t->type, &t->u.num_real, &t->u.num_int) != lwjsonOK) {
+                    if (prv_parse_number(&p, end, &t->type, &t->u.num_real, &t->u.num_int) != lwjsonOK) {
                         res = lwjsonERRJSON;
                         goto ret;
                     }
@@ -491,6 +927,14 @@ lwjson_parse(lwjson_t* lw, const char* json_str) {
         if (t->type == LWJSON_TYPE_ARRAY || t->type == LWJSON_TYPE_OBJECT) {
             continue;
         }
+#if LWJSON_CFG_TOKEN_SPAN
+        if (t->type == LWJSON_TYPE_STRING) {
+            /* String parser skips blanks after closing quote */
+            t->token_raw_len = (size_t)(t->u.str.token_value + t->u.str.token_value_len + 1 - t->token_raw);
+        } else {
+            t->token_raw_len = (size_t)(p - t->token_raw);
+        }
+#endif /* LWJSON_CFG_TOKEN_SPAN */
 
         /*
          * Check what are values after the token value
@@ -501,23 +945,70 @@ lwjson_parse(lwjson_t* lw, const char* json_str) {
          *  - End of array indication
          *  - End of object indication
          */
-        if ((res = prv_skip_blank(&p)) != lwjsonOK) {
+        if ((res = prv_skip_blank(&p, end)) != lwjsonOK) {
             goto ret;
         }
         /* Check if valid string is availabe after */
-        if (p == NULL || *p == '\0' || (*p != ',' && *p != ']' && *p != '}')) {
+        if (prv_char(p, end) != ',' && prv_char(p, end) != ']' && prv_char(p, end) != '}') {
             res = lwjsonERRJSON;
             goto ret;
         } else if (*p == ',') {                 /* Check to advance to next token immediatey */
             ++p;
         }
     }
+    if (elements && to == &lw->first_token) {
+        goto ret;                               /* Stopped between two elements of top array */
+    }
     if (to != NULL) {
         to->token_name = NULL;
         to->token_name_len = 0;
     }
+    res = lwjsonERRJSON;                        /* Input ended before top object or array was closed */
 ret:
-    if (res == lwjsonOK) {
+    *pp = p;
+    return res;
+}
+
+/**
+ * \brief           Parse input JSON format
+ * JSON format must be complete and must comply with RFC4627
+ * \param[in,out]   lw: LwJSON instance
+ * \param[in]       json_str: `NULL` terminated JSON string to parse
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_parse(lwjson_t* lw, const char* json_str) {
+    return lwjson_parse_ex(lw, json_str, json_str != NULL ? strlen(json_str) : 0);
+}
+
+/**
+ * \brief           Parse input JSON format with known length
+ *
+ * Input does not need to be `NULL` terminated and no character after `len` is accessed,
+ * so it can point inside larger buffer, such as one record of newline delimited JSON.
+ * Parsing stops at `NULL` character when found before `len`.
+ *
+ * \param[in,out]   lw: LwJSON instance
+ * \param[in]       json_data: JSON text to parse
+ * \param[in]       len: Length of JSON text in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_parse_ex(lwjson_t* lw, const char* json_data, size_t len) {
+    const char* p = json_data;
+    lwjsonr_t res;
+
+    /* values from very beginning */
+    lw->flags.parsed = 0;
+    lw->flags.split = 0;
+    lw->next_free_token_pos = 0;
+    memset(&lw->first_token, 0x00, sizeof(lw->first_token));
+
+    /* Check input data first */
+    if (p == NULL || len == 0 || *p == '\0') {
+        return lwjsonERRJSON;
+    }
+    if ((res = prv_parse(lw, &p, json_data + len, NULL, 0, NULL)) == lwjsonOK) {
         lw->flags.parsed = 1;
     }
     return res;
@@ -525,12 +1016,23 @@ ret:
 
 /**
  * \brief           Reset token instances and prepare for new parsing
+ *
+ * Only tokens used by last parsing are cleared, so that reset time does not depend
+ * on size of token array. After \ref lwjson_parse_parallel all tokens are cleared.
+ *
  * \param[in,out]   lw: LwJSON instance
  * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
  */
 lwjsonr_t
 lwjson_reset(lwjson_t* lw) {
-    memset(lw->tokens, 0x00, sizeof(*lw->tokens) * lw->tokens_len);
+    size_t used = lw->flags.split ? lw->tokens_len : lw->next_free_token_pos;
+
+    memset(lw->tokens, 0x00, sizeof(*lw->tokens) * used);
+    memset(&lw->first_token, 0x00, sizeof(lw->first_token));
+    lw->first_token.type = LWJSON_TYPE_OBJECT;
+    lw->next_free_token_pos = 0;
+    lw->flags.parsed = 0;
+    lw->flags.split = 0;
     return lwjsonOK;
 }
 
@@ -542,9 +1044,503 @@ lwjson_reset(lwjson_t* lw) {
  * \return          Pointer to found token on success, `NULL` if token cannot be found
  */
 const lwjson_token_t*
-lwjson_find(lwjson_t* lw, const char* path) {
+lwjson_find(const lwjson_t* lw, const char* path) {
     if (lw == NULL || !lw->flags.parsed || path == NULL) {
         return NULL;
     }
-    return prv_find(lwjson_get_first_token(lw), path);
+    return prv_find(&prv_token_tree, NULL, lwjson_get_first_token(lw), path);
+}
+
+/**
+ * \brief           Get immutable document of parsed JSON
+ *
+ * Document stays valid until parser instance is parsed again, reset or freed.
+ *
+ * \param[in]       lw: JSON instance with parsed JSON string
+ * \param[out]      doc: Document to fill. Root is set to `NULL` on failure
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_get_doc(const lwjson_t* lw, lwjson_doc_t* doc) {
+    if (doc == NULL) {
+        return lwjsonERR;
+    }
+    if (lw == NULL || !lw->flags.parsed) {
+        doc->root = NULL;
+        doc->tokens_used = 0;
+        return lwjsonERR;
+    }
+    doc->root = lwjson_get_first_token(lw);
+    doc->tokens_used = lwjson_get_tokens_used(lw);
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Find first match in the given path for JSON entry
+ * \note            Function is thread-safe, document is not modified
+ * \param[in]       doc: Parsed document
+ * \param[in]       path: Path with dot-separated entries to search for the JSON key to return
+ * \return          Pointer to found token on success, `NULL` if token cannot be found
+ */
+const lwjson_token_t*
+lwjson_doc_find(const lwjson_doc_t* doc, const char* path) {
+    if (doc == NULL || doc->root == NULL || path == NULL) {
+        return NULL;
+    }
+    return prv_find(&prv_token_tree, NULL, doc->root, path);
+}
+
+#if LWJSON_CFG_TAPE || __DOXYGEN__
+
+/**
+ * \brief           Find first match in the given path for JSON entry in tape
+ *
+ * Path has the same format as for \ref lwjson_find. Tape is only read,
+ * so that it can be searched from many threads or processes at the same time.
+ *
+ * \param[in]       tape: Tape to search in, opened with \ref lwjson_tape_open or \ref lwjson_tape_load
+ * \param[in]       path: Path with dot-separated entries to search for the JSON key to return
+ * \return          Pointer to found tape token on success, `NULL` if token cannot be found
+ */
+const lwjson_tape_token_t*
+lwjson_tape_find(const lwjson_tape_t* tape, const char* path) {
+    return lwjson_tape_find_ex(tape, lwjson_tape_get_first_token(tape), path);
+}
+
+/**
+ * \brief           Find first match in the given path, starting from given tape token
+ *
+ * Path is relative to `token`, which is usually object or array found by previous search.
+ *
+ * \param[in]       tape: Tape to search in, opened with \ref lwjson_tape_open or \ref lwjson_tape_load
+ * \param[in]       token: Tape token to start search in, must belong to `tape`
+ * \param[in]       path: Path with dot-separated entries to search for the JSON key to return
+ * \return          Pointer to found tape token on success, `NULL` if token cannot be found
+ */
+const lwjson_tape_token_t*
+lwjson_tape_find_ex(const lwjson_tape_t* tape, const lwjson_tape_token_t* token, const char* path) {
+    if (tape == NULL || token == NULL || path == NULL) {
+        return NULL;
+    }
+    return prv_find(&prv_tape_tree, tape, token, path);
+}
+
+#endif /* LWJSON_CFG_TAPE || __DOXYGEN__ */
+
+/**
+ * \brief           Fill structure from parsed JSON using binding table
+ *
+ * Token tree is traversed once, every object member is matched against binding table.
+ * Keys not in the table are ignored, members with no key in JSON or with `null` value are left untouched.
+ *
+ * \note            Function is thread-safe, document is not modified
+ * \param[in]       doc: Parsed document
+ * \param[in]       bindings: Binding table for top object, terminated with \ref LWJSON_BIND_END
+ * \param[out]      out: Pointer to structure to fill
+ * \return          \ref lwjsonOK on success, \ref lwjsonERR on type mismatch,
+ *                      \ref lwjsonERRMEM if string, array or integer value does not fit to member
+ */
+lwjsonr_t
+lwjson_bind(const lwjson_doc_t* doc, const lwjson_binding_t* bindings, void* out) {
+    if (doc == NULL || doc->root == NULL || bindings == NULL || out == NULL
+        || doc->root->type != LWJSON_TYPE_OBJECT) {
+        return lwjsonERR;
+    }
+    return prv_bind_object(doc->root, bindings, out);
+}
+
+/**
+ * \brief           Copy all integer elements of array token to contiguous buffer
+ *
+ * Function walks array children once and writes every value to `out`.
+ * It stops at first element that is not of \ref LWJSON_TYPE_NUM_INT type.
+ *
+ * \param[in]       token: Token of \ref LWJSON_TYPE_ARRAY type
+ * \param[out]      out: Output buffer to write values to
+ * \param[in]       cap: Number of elements `out` can hold
+ * \param[out]      len: Pointer to output variable. On success it holds number of elements written.
+ *                      On type error it holds index of first element with wrong type.
+ *                      Set to `NULL` if not used
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM if array does not fit to `out`,
+ *                      \ref lwjsonERR if token is not array or an element has wrong type
+ */
+lwjsonr_t
+lwjson_array_to_i64(const lwjson_token_t* token, int64_t* out, size_t cap, size_t* len) {
+    lwjsonr_t res = lwjsonOK;
+    size_t i = 0;
+
+    if (token == NULL || token->type != LWJSON_TYPE_ARRAY || (out == NULL && cap > 0)) {
+        res = lwjsonERR;
+        goto ret;
+    }
+    for (const lwjson_token_t* t = token->u.first_child; t != NULL; t = t->next, ++i) {
+        if (t->type != LWJSON_TYPE_NUM_INT) {
+            res = lwjsonERR;
+            break;
+        }
+        if (i == cap) {
+            res = lwjsonERRMEM;
+            break;
+        }
+        out[i] = (int64_t)t->u.num_int;
+    }
+ret:
+    if (len != NULL) {
+        *len = i;
+    }
+    return res;
+}
+
+/**
+ * \brief           Copy all numeric elements of array token to contiguous `double` buffer
+ *
+ * Integer elements are converted to `double`, any other type stops the operation.
+ *
+ * \param[in]       token: Token of \ref LWJSON_TYPE_ARRAY type
+ * \param[out]      out: Output buffer to write values to
+ * \param[in]       cap: Number of elements `out` can hold
+ * \param[out]      len: Pointer to output variable. On success it holds number of elements written.
+ *                      On type error it holds index of first element with wrong type.
+ *                      Set to `NULL` if not used
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM if array does not fit to `out`,
+ *                      \ref lwjsonERR if token is not array or an element has wrong type
+ */
+lwjsonr_t
+lwjson_array_to_f64(const lwjson_token_t* token, double* out, size_t cap, size_t* len) {
+    lwjsonr_t res = lwjsonOK;
+    size_t i = 0;
+
+    if (token == NULL || token->type != LWJSON_TYPE_ARRAY || (out == NULL && cap > 0)) {
+        res = lwjsonERR;
+        goto ret;
+    }
+    for (const lwjson_token_t* t = token->u.first_child; t != NULL; t = t->next, ++i) {
+        if (t->type != LWJSON_TYPE_NUM_REAL && t->type != LWJSON_TYPE_NUM_INT) {
+            res = lwjsonERR;
+            break;
+        }
+        if (i == cap) {
+            res = lwjsonERRMEM;
+            break;
+        }
+        out[i] = t->type == LWJSON_TYPE_NUM_REAL ? (double)t->u.num_real : (double)t->u.num_int;
+    }
+ret:
+    if (len != NULL) {
+        *len = i;
+    }
+    return res;
+}
+
+/**
+ * \brief           Copy all numeric elements of array token to contiguous `float` buffer
+ *
+ * Integer elements are converted to `float`, any other type stops the operation.
+ *
+ * \param[in]       token: Token of \ref LWJSON_TYPE_ARRAY type
+ * \param[out]      out: Output buffer to write values to
+ * \param[in]       cap: Number of elements `out` can hold
+ * \param[out]      len: Pointer to output variable. On success it holds number of elements written.
+ *                      On type error it holds index of first element with wrong type.
+ *                      Set to `NULL` if not used
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM if array does not fit to `out`,
+ *                      \ref lwjsonERR if token is not array or an element has wrong type
+ */
+lwjsonr_t
+lwjson_array_to_f32(const lwjson_token_t* token, float* out, size_t cap, size_t* len) {
+    lwjsonr_t res = lwjsonOK;
+    size_t i = 0;
+
+    if (token == NULL || token->type != LWJSON_TYPE_ARRAY || (out == NULL && cap > 0)) {
+        res = lwjsonERR;
+        goto ret;
+    }
+    for (const lwjson_token_t* t = token->u.first_child; t != NULL; t = t->next, ++i) {
+        if (t->type != LWJSON_TYPE_NUM_REAL && t->type != LWJSON_TYPE_NUM_INT) {
+            res = lwjsonERR;
+            break;
+        }
+        if (i == cap) {
+            res = lwjsonERRMEM;
+            break;
+        }
+        out[i] = t->type == LWJSON_TYPE_NUM_REAL ? (float)t->u.num_real : (float)t->u.num_int;
+    }
+ret:
+    if (len != NULL) {
+        *len = i;
+    }
+    return res;
+}
+
+#if LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__
+
+/**
+ * \brief           Part of top array elements parsed by one thread
+ */
+typedef struct {
+    lwjson_t lw;                                /*!< Instance with own slice of tokens */
+    lwjson_token_t* root;                       /*!< Top token of complete document */
+    const char* start;                          /*!< Start of first element */
+    const char* end;                            /*!< Start of next part or end of input */
+    const char* stop;                           /*!< Position where parsing stopped */
+    lwjson_token_t* first;                      /*!< First parsed element */
+    lwjson_token_t* last;                       /*!< Last parsed element */
+    lwjsonr_t res;                              /*!< Parse result */
+    uint8_t closed;                             /*!< Set when top array was closed in this part */
+} lwjson_part_t;
+
+/**
+ * \brief           Find candidate start of top array element
+ *
+ * Candidate is object or array following another object or array and comma, as in `},{` or `],[`.
+ * Text is scanned with quote and backslash state, so that candidates inside strings are skipped.
+ * Candidate may still be inside nested array, therefore it must be verified by parsing.
+ *
+ * \param[in,out]   p: Position to scan from, not inside string. Set to position where scan stopped
+ * \param[in]       from: Position to search candidate from, commas before it only move the scan
+ * \param[in]       begin: Start of input text
+ * \param[in]       end: End of input text
+ * \return          Candidate element start, `NULL` if not found
+ */
+static const char*
+prv_find_element(const char** p, const char* from, const char* begin, const char* end) {
+    const char* s = *p;
+
+    while (s < end) {
+        if (*s == '"') {
+            /* Skip string, escaped character is never its end */
+            for (++s; s < end && *s != '"'; ++s) {
+                if (*s == '\\') {
+                    ++s;
+                }
+            }
+            s = s < end ? s + 1 : end;
+        } else if (*s == ',' && s >= from) {
+            const char* b = s - 1, *a = s + 1;
+
+            for (; b > begin && (*b == ' ' || *b == '\t' || *b == '\r' || *b == '\n' || *b == '\f'); --b) {}
+            prv_skip_blank(&a, end);
+            if (b > begin && (*b == '}' || *b == ']') && (prv_char(a, end) == '{' || prv_char(a, end) == '[')) {
+                *p = a;
+                return a;
+            }
+            ++s;
+        } else {
+            ++s;
+        }
+    }
+    *p = end;
+    return NULL;
+}
+
+/**
+ * \brief           Parse elements of one part and attach them to top token
+ * \param[in,out]   arg: Part to parse
+ * \return          Always `NULL`, result is stored in part
+ */
+static void*
+prv_parse_part(void* arg) {
+    lwjson_part_t* part = arg;
+    const char* p = part->start;
+
+    part->lw.next_free_token_pos = 0;
+    memset(&part->lw.first_token, 0x00, sizeof(part->lw.first_token));
+    part->first = part->last = NULL;
+    part->res = prv_parse(&part->lw, &p, part->end, NULL, 1, &part->closed);
+    part->stop = p;
+    if (part->res == lwjsonOK) {
+        part->first = part->lw.first_token.u.first_child;
+        for (lwjson_token_t* t = part->first; t != NULL; t = t->next) {
+            t->parent = part->root;
+            part->last = t;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Parse JSON with top array using multiple threads
+ *
+ * Input is split to parts at candidate element boundaries, found without parsing.
+ * Candidates are searched with single scan of quotes and commas up to the last one,
+ * which is cheaper than parsing but is not split among threads.
+ * Every part is parsed by its own thread to its own slice of tokens and elements are linked
+ * to single top token afterwards, so result is the same as with \ref lwjson_parse_ex.
+ * Part is valid only when previous part ended exactly at its start. When candidate was not real
+ * element boundary, the rest of input is parsed again by calling thread with all remaining tokens.
+ *
+ * Only arrays of objects or arrays are split. Other input, or input shorter than two
+ * \ref LWJSON_CFG_PARALLEL_BLOCK sizes, is parsed with single thread.
+ * Number of tokens needed may be higher than for single thread, as every part has fixed slice.
+ *
+ * \note            Available when \ref LWJSON_CFG_PARALLEL_THREADS is enabled, requires POSIX threads
+ * \param[in,out]   lw: LwJSON instance
+ * \param[in]       json_data: JSON text to parse
+ * \param[in]       len: Length of JSON text in units of bytes
+ * \param[in]       nthreads: Number of threads to parse with, including calling thread
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_parse_parallel(lwjson_t* lw, const char* json_data, size_t len, size_t nthreads) {
+    lwjson_part_t parts[LWJSON_CFG_PARALLEL_THREADS];
+    pthread_t threads[LWJSON_CFG_PARALLEL_THREADS];
+    uint8_t started[LWJSON_CFG_PARALLEL_THREADS] = {0};
+    const char* p = json_data, *end = json_data + len, *scan;
+    lwjson_token_t* root, *last = NULL;
+    size_t cnt, n = 0, used = 0;
+
+    if (lw == NULL || json_data == NULL || nthreads == 0) {
+        return lwjsonERR;
+    }
+    if (nthreads > LWJSON_CFG_PARALLEL_THREADS) {
+        nthreads = LWJSON_CFG_PARALLEL_THREADS;
+    }
+    cnt = len / LWJSON_CFG_PARALLEL_BLOCK;
+    if (cnt > nthreads) {
+        cnt = nthreads;
+    }
+    prv_skip_blank(&p, end);
+    if (cnt < 2 || prv_char(p, end) != '[') {
+        return lwjson_parse_ex(lw, json_data, len);
+    }
+    lw->flags.parsed = 0;
+    lw->flags.split = 1;
+    lw->next_free_token_pos = 0;
+    root = &lw->first_token;
+    memset(root, 0x00, sizeof(*root));
+    root->type = LWJSON_TYPE_ARRAY;
+
+    /* Split input at candidate boundaries, every part starts after previous one */
+    memset(parts, 0x00, sizeof(parts));
+    parts[0].start = scan = p + 1;
+    for (size_t i = 1; i < cnt; ++i) {
+        const char* c = prv_find_element(&scan, json_data + len / cnt * i, json_data, end);
+        if (c != NULL && c > parts[n].start) {
+            parts[n].end = c;
+            parts[++n].start = c;
+        }
+    }
+    parts[n++].end = end;
+
+    /* Every part gets equal slice of tokens */
+    for (size_t i = 0; i < n; ++i) {
+        size_t from = lw->tokens_len * i / n, to = lw->tokens_len * (i + 1) / n;
+        parts[i].lw.tokens = &lw->tokens[from]; /* Tokens are cleared on allocation */
+        parts[i].lw.tokens_len = to - from;
+        parts[i].root = root;
+    }
+    for (size_t i = 1; i < n; ++i) {
+        started[i] = pthread_create(&threads[i], NULL, prv_parse_part, &parts[i]) == 0;
+    }
+    prv_parse_part(&parts[0]);
+    for (size_t i = 1; i < n; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            prv_parse_part(&parts[i]);
+        }
+    }
+
+    /* Verify parts in order and link their elements */
+    for (size_t i = 0; i < n; ++i) {
+        lwjson_part_t* part = &parts[i];
+
+        if (part->res != lwjsonOK || (i + 1 < n ? (part->closed || part->stop != part->end) : !part->closed)) {
+            /* Start of this part is verified, parse the rest again with all remaining tokens */
+            part->lw.tokens_len = (size_t)(&lw->tokens[lw->tokens_len] - part->lw.tokens);
+            part->end = end;
+            prv_parse_part(part);
+            if (part->res != lwjsonOK || !part->closed) {
+                return part->res != lwjsonOK ? part->res : lwjsonERRJSON;
+            }
+            n = i + 1;
+        }
+        if (part->first != NULL) {
+            if (last == NULL) {
+                root->u.first_child = part->first;
+            } else {
+                last->next = part->first;
+            }
+            last = part->last;
+        }
+        used += part->lw.next_free_token_pos;
+    }
+#if LWJSON_CFG_TOKEN_SPAN
+    root->token_raw = p;
+    root->token_raw_len = (size_t)(parts[n - 1].lw.first_token.token_raw + parts[n - 1].lw.first_token.token_raw_len - p);
+#endif /* LWJSON_CFG_TOKEN_SPAN */
+    lw->next_free_token_pos = used;
+    lw->flags.parsed = 1;
+    return lwjsonOK;
+}
+
+#endif /* LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__ */
+
+#if LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__
+
+/**
+ * \brief           Parse input JSON with two pipelined threads
+ *
+ * Scanner thread finds all string boundaries ahead of the parser and passes them through
+ * lock-free ring, so that parsing thread does not scan string contents.
+ * Result is the same as with \ref lwjson_parse_ex, except that `NULL` characters
+ * inside strings are not detected. Input shorter than \ref LWJSON_CFG_PARALLEL_BLOCK,
+ * system with less than \ref LWJSON_CFG_PIPELINE_MIN_CPUS online processors or failure to start
+ * scanner thread falls back to single thread parsing.
+ *
+ * Only string scanning is moved to second thread. Gain depends on how much of the input is in strings,
+ * string heavy documents gain the most and documents of numbers and nesting do not gain.
+ * Measure with `lwjson_bench -p 1` before use.
+ *
+ * \note            Available when \ref LWJSON_CFG_PARALLEL_THREADS is enabled, requires POSIX threads
+ * \param[in,out]   lw: LwJSON instance
+ * \param[in]       json_data: JSON text to parse
+ * \param[in]       len: Length of JSON text in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_parse_pipelined(lwjson_t* lw, const char* json_data, size_t len) {
+    lwjson_quote_ring_t ring;
+    const char* p = json_data;
+    pthread_t thread;
+    lwjsonr_t res;
+
+    if (lw == NULL || json_data == NULL || len < LWJSON_CFG_PARALLEL_BLOCK
+        || sysconf(_SC_NPROCESSORS_ONLN) < LWJSON_CFG_PIPELINE_MIN_CPUS) {
+        return lwjson_parse_ex(lw, json_data, len);
+    }
+    memset(&ring, 0x00, sizeof(ring));
+    ring.data = json_data;
+    ring.end = json_data + len;
+    if (pthread_mutex_init(&ring.mutex, NULL) != 0) {
+        return lwjson_parse_ex(lw, json_data, len);
+    }
+    if (pthread_cond_init(&ring.cond, NULL) != 0) {
+        pthread_mutex_destroy(&ring.mutex);
+        return lwjson_parse_ex(lw, json_data, len);
+    }
+    if (pthread_create(&thread, NULL, prv_ring_scan, &ring) != 0) {
+        pthread_cond_destroy(&ring.cond);
+        pthread_mutex_destroy(&ring.mutex);
+        return lwjson_parse_ex(lw, json_data, len);
+    }
+    lw->flags.parsed = 0;
+    lw->flags.split = 0;
+    lw->next_free_token_pos = 0;
+    memset(&lw->first_token, 0x00, sizeof(lw->first_token));
+    res = prv_parse(lw, &p, json_data + len, &ring, 0, NULL);
+    __atomic_store_n(&ring.stop, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&ring.mutex);
+    pthread_cond_broadcast(&ring.cond);
+    pthread_mutex_unlock(&ring.mutex);
+    pthread_join(thread, NULL);
+    pthread_cond_destroy(&ring.cond);
+    pthread_mutex_destroy(&ring.mutex);
+    if (res == lwjsonOK) {
+        lw->flags.parsed = 1;
+    }
+    return res;
 }
+
+#endif /* LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__ */
@@ -0,0 +1,238 @@
+/**
+ * \file            lwjson_batch.c
+ * \brief           Parallel ingestion of many JSON files
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwJSON - Lightweight JSON format parser.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 700                       /* pread and posix_fadvise with strict C standard */
+#endif
+#include "lwjson/lwjson.h"
+
+#if LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * \brief           Shared state of batch file parse
+ */
+typedef struct {
+    const char* const* paths;                   /*!< Paths of files to parse */
+    size_t paths_len;                           /*!< Number of paths */
+    size_t next_path;                           /*!< Next path to be claimed by worker */
+    lwjson_batch_fn fn;                         /*!< Callback function */
+    void* arg;                                  /*!< User argument */
+    lwjsonr_t res;                              /*!< First non-OK result returned by callback */
+    pthread_mutex_t mutex;                      /*!< Protects path counter and result */
+} lwjson_batch_job_t;
+
+/**
+ * \brief           Read buffer of single worker
+ */
+typedef struct {
+    char* data;                                 /*!< Buffer memory, grown to the largest file read */
+    size_t size;                                /*!< Size of buffer memory */
+} lwjson_batch_buf_t;
+
+/**
+ * \brief           Claim next file to parse
+ * \param[in,out]   job: Batch state
+ * \param[out]      idx: Claimed path index
+ * \return          `1` when file is claimed, `0` when there is no more work
+ */
+static uint8_t
+prv_batch_claim(lwjson_batch_job_t* job, size_t* idx) {
+    uint8_t ok = 0;
+
+    pthread_mutex_lock(&job->mutex);
+    if (job->res == lwjsonOK && job->next_path < job->paths_len) {
+        *idx = job->next_path++;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&job->mutex);
+    return ok;
+}
+
+/**
+ * \brief           Read whole file to worker buffer
+ * \param[in]       path: File path
+ * \param[in,out]   buf: Worker buffer, grown when file does not fit
+ * \param[out]      len: Number of bytes read
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM when buffer cannot grow,
+ *                      \ref lwjsonERR when file cannot be read
+ */
+static lwjsonr_t
+prv_batch_read(const char* path, lwjson_batch_buf_t* buf, size_t* len) {
+    lwjsonr_t res = lwjsonOK;
+    struct stat st;
+    size_t size, pos = 0;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return lwjsonERR;
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return lwjsonERR;
+    }
+    size = (size_t)st.st_size;
+    if (size > buf->size) {
+        char* data = realloc(buf->data, size);
+
+        if (data == NULL) {
+            close(fd);
+            return lwjsonERRMEM;
+        }
+        buf->data = data;
+        buf->size = size;
+    }
+
+    /* Whole file is read with one request, loop only handles short reads */
+    (void)posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    while (pos < size) {
+        ssize_t r = pread(fd, buf->data + pos, size - pos, (off_t)pos);
+
+        if (r <= 0) {
+            res = lwjsonERR;
+            break;
+        }
+        pos += (size_t)r;
+    }
+    close(fd);
+    *len = pos;
+    return res;
+}
+
+/**
+ * \brief           Worker thread, reads and parses claimed files with its own buffer and tokens
+ * \param[in]       arg: Batch state
+ * \return          `NULL`
+ */
+static void*
+prv_batch_worker(void* arg) {
+    lwjson_batch_job_t* job = arg;
+    lwjson_token_t tokens[LWJSON_CFG_BATCH_TOKENS];
+    lwjson_batch_buf_t buf = {NULL, 0};
+    lwjson_doc_t doc;
+    lwjson_t lw;
+    size_t idx, len = 0;
+
+    lwjson_init(&lw, tokens, LWJSON_ARRAYSIZE(tokens));
+    while (prv_batch_claim(job, &idx)) {
+        lwjsonr_t res = prv_batch_read(job->paths[idx], &buf, &len);
+
+        if (res == lwjsonOK) {
+            res = lwjson_parse_ex(&lw, buf.data, len);
+        }
+        if (res == lwjsonOK) {
+            lwjson_get_doc(&lw, &doc);
+        } else {
+            doc.root = NULL;
+            doc.tokens_used = 0;
+        }
+        if ((res = job->fn(idx, res, &doc, job->arg)) != lwjsonOK) {
+            pthread_mutex_lock(&job->mutex);
+            if (job->res == lwjsonOK) {
+                job->res = res;
+            }
+            pthread_mutex_unlock(&job->mutex);
+        }
+    }
+    free(buf.data);
+    return NULL;
+}
+
+/**
+ * \brief           Read and parse many JSON files with multiple threads
+ *
+ * Files are claimed dynamically by workers. Every worker reads whole file with `pread`
+ * to its own buffer and parses it with its own pool of \ref LWJSON_CFG_BATCH_TOKENS tokens on stack,
+ * so that while one worker waits for the storage, others parse files already read.
+ * Calling thread is one of the workers.
+ *
+ * Read buffer of every worker is allocated with `realloc` and grows to the largest file it reads.
+ * It is freed when batch finishes.
+ *
+ * Callback is called concurrently from different threads and files are not passed in input order.
+ * File that cannot be read is passed with \ref lwjsonERR result, file that does not fit to the buffer
+ * or tokens with \ref lwjsonERRMEM result. When callback returns error, workers stop after their current file.
+ *
+ * \note            Available when \ref LWJSON_CFG_PARALLEL_THREADS is enabled, requires POSIX threads
+ * \param[in]       paths: Array of file paths
+ * \param[in]       paths_len: Number of file paths
+ * \param[in]       nthreads: Number of threads to use, including calling thread
+ * \param[in]       fn: Callback function called for every file
+ * \param[in]       arg: User argument passed to callback
+ * \return          \ref lwjsonOK on success, value returned by callback when it stops parsing
+ */
+lwjsonr_t
+lwjson_batch_files(const char* const* paths, size_t paths_len, size_t nthreads, lwjson_batch_fn fn, void* arg) {
+    pthread_t threads[LWJSON_CFG_PARALLEL_THREADS];
+    lwjson_batch_job_t job;
+    size_t started = 0;
+
+    if ((paths == NULL && paths_len > 0) || nthreads == 0 || fn == NULL) {
+        return lwjsonERR;
+    }
+    if (nthreads > LWJSON_CFG_PARALLEL_THREADS) {
+        nthreads = LWJSON_CFG_PARALLEL_THREADS;
+    }
+    if (nthreads > paths_len) {
+        nthreads = paths_len > 0 ? paths_len : 1;
+    }
+    memset(&job, 0x00, sizeof(job));
+    job.paths = paths;
+    job.paths_len = paths_len;
+    job.fn = fn;
+    job.arg = arg;
+    job.res = lwjsonOK;
+    if (pthread_mutex_init(&job.mutex, NULL) != 0) {
+        return lwjsonERR;
+    }
+
+    /* Thread that cannot be created is not needed, remaining workers take its files */
+    for (size_t i = 0; i + 1 < nthreads; ++i) {
+        if (pthread_create(&threads[started], NULL, prv_batch_worker, &job) == 0) {
+            ++started;
+        }
+    }
+    prv_batch_worker(&job);
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&job.mutex);
+    return job.res;
+}
+
+#endif /* LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__ */
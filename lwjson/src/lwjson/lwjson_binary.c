@@ -0,0 +1,1094 @@
+/**
+ * \file            lwjson_binary.c
+ * \brief           CBOR and MessagePack encoding and decoding
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwJSON - Lightweight JSON format parser.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lwjson/lwjson.h"
+
+/**
+ * \brief           Binary output, writes to writer and counts length
+ */
+typedef struct {
+    lwjson_writer_t* w;                         /*!< Writer instance, `NULL` to count length only */
+    size_t len;                                 /*!< Number of bytes written */
+} lwjson_bin_out_t;
+
+/**
+ * \brief           Write bytes to binary output
+ * \param[in,out]   o: Binary output
+ * \param[in]       data: Data to write
+ * \param[in]       len: Length of data in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_out(lwjson_bin_out_t* o, const void* data, size_t len) {
+    o->len += len;
+    return o->w != NULL ? lwjson_writer_bytes(o->w, data, len) : lwjsonOK;
+}
+
+/**
+ * \brief           Write unsigned value in big-endian byte order after leading byte
+ * \param[in,out]   o: Binary output
+ * \param[in]       lead: Leading byte
+ * \param[in]       val: Value to write
+ * \param[in]       size: Number of value bytes, `0`, `1`, `2`, `4` or `8`
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_out_be(lwjson_bin_out_t* o, uint8_t lead, uint64_t val, size_t size) {
+    uint8_t buf[9];
+
+    buf[0] = lead;
+    for (size_t i = 0; i < size; ++i) {
+        buf[size - i] = (uint8_t)(val >> (8 * i));
+    }
+    return prv_out(o, buf, size + 1);
+}
+
+/**
+ * \brief           Get value of hexadecimal digit
+ * \param[in]       ch: Character to convert
+ * \return          Digit value, `-1` if character is not hexadecimal digit
+ */
+static int
+prv_hex(char ch) {
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    } else if (ch >= 'a' && ch <= 'f') {
+        return ch - 'a' + 10;
+    } else if (ch >= 'A' && ch <= 'F') {
+        return ch - 'A' + 10;
+    }
+    return -1;
+}
+
+/**
+ * \brief           Decode 4 hexadecimal digits of `\u` escape sequence
+ * \param[in]       s: First digit
+ * \param[in]       end: End of string
+ * \return          Code unit, `-1` if digits are not valid
+ */
+static long
+prv_hex4(const char* s, const char* end) {
+    long cu = 0;
+
+    if (end - s < 4) {
+        return -1;
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        int d = prv_hex(s[i]);
+        if (d < 0) {
+            return -1;
+        }
+        cu = (cu << 4) | d;
+    }
+    return cu;
+}
+
+/**
+ * \brief           Decode escape sequences of JSON string
+ *
+ * Lone surrogate code units are replaced with `U+FFFD` character.
+ *
+ * \param[in,out]   o: Binary output for decoded string, `NULL` to get length only
+ * \param[in]       str: String as it is in JSON text, without quotes
+ * \param[in]       len: Length of string
+ * \param[out]      out_len: Length of decoded string
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRJSON for invalid escape sequence
+ */
+static lwjsonr_t
+prv_decode_string(lwjson_bin_out_t* o, const char* str, size_t len, size_t* out_len) {
+    const char *s = str, *end = str + len;
+    size_t dec_len = 0;
+
+    while (s < end) {
+        const char* bs = memchr(s, '\\', (size_t)(end - s));
+        uint8_t buf[4];
+        size_t n = 1;
+        long cp;
+
+        /* Copy plain part at once */
+        if (bs == NULL) {
+            bs = end;
+        }
+        if (o != NULL && bs > s) {
+            prv_out(o, s, (size_t)(bs - s));
+        }
+        dec_len += (size_t)(bs - s);
+        if ((s = bs) == end) {
+            break;
+        }
+        if (++s == end) {
+            return lwjsonERRJSON;
+        }
+        switch (*s++) {
+            case '"': buf[0] = '"'; break;
+            case '\\': buf[0] = '\\'; break;
+            case '/': buf[0] = '/'; break;
+            case 'b': buf[0] = '\b'; break;
+            case 'f': buf[0] = '\f'; break;
+            case 'n': buf[0] = '\n'; break;
+            case 'r': buf[0] = '\r'; break;
+            case 't': buf[0] = '\t'; break;
+            case 'u':
+                if ((cp = prv_hex4(s, end)) < 0) {
+                    return lwjsonERRJSON;
+                }
+                s += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    long lo = end - s >= 6 && s[0] == '\\' && s[1] == 'u' ? prv_hex4(s + 2, end) : -1;
+                    if (lo >= 0xDC00 && lo <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        s += 6;
+                    } else {
+                        cp = 0xFFFD;
+                    }
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    cp = 0xFFFD;
+                }
+                if (cp < 0x80) {
+                    buf[0] = (uint8_t)cp;
+                } else if (cp < 0x800) {
+                    buf[0] = (uint8_t)(0xC0 | (cp >> 6));
+                    buf[1] = (uint8_t)(0x80 | (cp & 0x3F));
+                    n = 2;
+                } else if (cp < 0x10000) {
+                    buf[0] = (uint8_t)(0xE0 | (cp >> 12));
+                    buf[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+                    buf[2] = (uint8_t)(0x80 | (cp & 0x3F));
+                    n = 3;
+                } else {
+                    buf[0] = (uint8_t)(0xF0 | (cp >> 18));
+                    buf[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3F));
+                    buf[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+                    buf[3] = (uint8_t)(0x80 | (cp & 0x3F));
+                    n = 4;
+                }
+                break;
+            default:
+                return lwjsonERRJSON;
+        }
+        if (o != NULL) {
+            prv_out(o, buf, n);
+        }
+        dec_len += n;
+    }
+    *out_len = dec_len;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Write CBOR data item head with smallest argument encoding
+ * \param[in,out]   o: Binary output
+ * \param[in]       major: Major type, `0` to `7`
+ * \param[in]       val: Argument value
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_cbor_head(lwjson_bin_out_t* o, uint8_t major, uint64_t val) {
+    major <<= 5;
+    if (val < 24) {
+        return prv_out_be(o, (uint8_t)(major | val), 0, 0);
+    } else if (val <= 0xFF) {
+        return prv_out_be(o, major | 24, val, 1);
+    } else if (val <= 0xFFFF) {
+        return prv_out_be(o, major | 25, val, 2);
+    } else if (val <= 0xFFFFFFFFUL) {
+        return prv_out_be(o, major | 26, val, 4);
+    }
+    return prv_out_be(o, major | 27, val, 8);
+}
+
+/**
+ * \brief           Write CBOR integer
+ * \param[in,out]   o: Binary output
+ * \param[in]       num: Number to write
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_cbor_int(lwjson_bin_out_t* o, int64_t num) {
+    return num >= 0 ? prv_cbor_head(o, 0, (uint64_t)num) : prv_cbor_head(o, 1, ~(uint64_t)num);
+}
+
+/**
+ * \brief           Write real number as single precision float when it is exact, double precision otherwise
+ * \param[in,out]   o: Binary output
+ * \param[in]       num: Number to write
+ * \param[in]       lead32: Leading byte of single precision float
+ * \param[in]       lead64: Leading byte of double precision float
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_out_real(lwjson_bin_out_t* o, double num, uint8_t lead32, uint8_t lead64) {
+    float f;
+
+    /* Conversion of number out of single precision range is undefined */
+    if (num >= -FLT_MAX && num <= FLT_MAX && (double)(f = (float)num) == num) {
+        uint32_t bits;
+
+        memcpy(&bits, &f, sizeof(bits));
+        return prv_out_be(o, lead32, bits, 4);
+    } else {
+        uint64_t bits;
+
+        memcpy(&bits, &num, sizeof(bits));
+        return prv_out_be(o, lead64, bits, 8);
+    }
+}
+
+/**
+ * \brief           Write CBOR text string, decoded from JSON string
+ * \param[in,out]   o: Binary output
+ * \param[in]       str: String as it is in JSON text, without quotes
+ * \param[in]       len: Length of string
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_cbor_string(lwjson_bin_out_t* o, const char* str, size_t len) {
+    lwjsonr_t res;
+    size_t dec_len;
+
+    if ((res = prv_decode_string(NULL, str, len, &dec_len)) != lwjsonOK) {
+        return res;
+    }
+    prv_cbor_head(o, 3, dec_len);
+    return prv_decode_string(o, str, len, &dec_len);
+}
+
+/**
+ * \brief           Write MessagePack integer with smallest encoding
+ * \param[in,out]   o: Binary output
+ * \param[in]       num: Number to write
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_msgpack_int(lwjson_bin_out_t* o, int64_t num) {
+    if (num >= 0) {
+        if (num < 0x80) {
+            return prv_out_be(o, (uint8_t)num, 0, 0);
+        } else if (num <= 0xFF) {
+            return prv_out_be(o, 0xCC, (uint64_t)num, 1);
+        } else if (num <= 0xFFFF) {
+            return prv_out_be(o, 0xCD, (uint64_t)num, 2);
+        } else if (num <= (int64_t)0xFFFFFFFFUL) {
+            return prv_out_be(o, 0xCE, (uint64_t)num, 4);
+        }
+        return prv_out_be(o, 0xCF, (uint64_t)num, 8);
+    }
+    if (num >= -32) {
+        return prv_out_be(o, (uint8_t)num, 0, 0);
+    } else if (num >= INT8_MIN) {
+        return prv_out_be(o, 0xD0, (uint8_t)num, 1);
+    } else if (num >= INT16_MIN) {
+        return prv_out_be(o, 0xD1, (uint16_t)num, 2);
+    } else if (num >= INT32_MIN) {
+        return prv_out_be(o, 0xD2, (uint32_t)num, 4);
+    }
+    return prv_out_be(o, 0xD3, (uint64_t)num, 8);
+}
+
+/**
+ * \brief           Write MessagePack string, array or map head
+ * \param[in,out]   o: Binary output
+ * \param[in]       fix: Leading byte of fixed format, with length `0`
+ * \param[in]       fix_max: Maximal length of fixed format
+ * \param[in]       lead: Leading byte of 16-bit length format, `8`-bit format uses previous leading byte
+ *                      and 32-bit format the next one
+ * \param[in]       len: Length to write
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_msgpack_head(lwjson_bin_out_t* o, uint8_t fix, size_t fix_max, uint8_t lead, uint64_t len) {
+    if (len <= fix_max) {
+        return prv_out_be(o, (uint8_t)(fix | len), 0, 0);
+    } else if (len <= 0xFF && fix == 0xA0) {
+        return prv_out_be(o, lead - 1, len, 1);                 /* Only strings have 8-bit length format */
+    } else if (len <= 0xFFFF) {
+        return prv_out_be(o, lead, len, 2);
+    }
+    return prv_out_be(o, lead + 1, len, 4);
+}
+
+/**
+ * \brief           Write MessagePack string, decoded from JSON string
+ * \param[in,out]   o: Binary output
+ * \param[in]       str: String as it is in JSON text, without quotes
+ * \param[in]       len: Length of string
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_msgpack_string(lwjson_bin_out_t* o, const char* str, size_t len) {
+    lwjsonr_t res;
+    size_t dec_len;
+
+    if ((res = prv_decode_string(NULL, str, len, &dec_len)) != lwjsonOK) {
+        return res;
+    }
+    prv_msgpack_head(o, 0xA0, 31, 0xDA, dec_len);
+    return prv_decode_string(o, str, len, &dec_len);
+}
+
+/**
+ * \brief           Encode token subtree to CBOR or MessagePack
+ * \param[in,out]   o: Binary output
+ * \param[in]       token: Token to encode
+ * \param[in]       msgpack: Set to `1` for MessagePack, `0` for CBOR
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_encode(lwjson_bin_out_t* o, const lwjson_token_t* token, uint8_t msgpack) {
+    lwjsonr_t res = lwjsonOK;
+
+    switch (token->type) {
+        case LWJSON_TYPE_OBJECT:
+        case LWJSON_TYPE_ARRAY: {
+            uint8_t is_obj = token->type == LWJSON_TYPE_OBJECT;
+            size_t cnt = 0;
+
+            /* Both formats need number of children in advance */
+            for (const lwjson_token_t* t = token->u.first_child; t != NULL; t = t->next) {
+                ++cnt;
+            }
+            if (msgpack) {
+                prv_msgpack_head(o, is_obj ? 0x80 : 0x90, 15, is_obj ? 0xDE : 0xDC, cnt);
+            } else {
+                prv_cbor_head(o, is_obj ? 5 : 4, cnt);
+            }
+            for (const lwjson_token_t* t = token->u.first_child; t != NULL && res == lwjsonOK; t = t->next) {
+                if (is_obj) {
+                    res = msgpack ? prv_msgpack_string(o, t->token_name, t->token_name_len)
+                                  : prv_cbor_string(o, t->token_name, t->token_name_len);
+                }
+                if (res == lwjsonOK) {
+                    res = prv_encode(o, t, msgpack);
+                }
+            }
+            return res;
+        }
+        case LWJSON_TYPE_STRING:
+            return msgpack ? prv_msgpack_string(o, token->u.str.token_value, token->u.str.token_value_len)
+                           : prv_cbor_string(o, token->u.str.token_value, token->u.str.token_value_len);
+        case LWJSON_TYPE_NUM_INT:
+            return msgpack ? prv_msgpack_int(o, (int64_t)token->u.num_int) : prv_cbor_int(o, (int64_t)token->u.num_int);
+        case LWJSON_TYPE_NUM_REAL:
+            return msgpack ? prv_out_real(o, (double)token->u.num_real, 0xCA, 0xCB)
+                           : prv_out_real(o, (double)token->u.num_real, 0xFA, 0xFB);
+        case LWJSON_TYPE_TRUE: return prv_out_be(o, msgpack ? 0xC3 : 0xF5, 0, 0);
+        case LWJSON_TYPE_FALSE: return prv_out_be(o, msgpack ? 0xC2 : 0xF4, 0, 0);
+        case LWJSON_TYPE_NULL: return prv_out_be(o, msgpack ? 0xC0 : 0xF6, 0, 0);
+        default: return lwjsonERR;
+    }
+}
+
+/**
+ * \brief           Encode token subtree of parsed document
+ * \param[in]       doc: Parsed document
+ * \param[in]       token: Token to encode, `NULL` for complete document
+ * \param[in,out]   w: Writer instance, `NULL` to get length only
+ * \param[out]      len: Length of encoded data, `NULL` if not used
+ * \param[in]       msgpack: Set to `1` for MessagePack, `0` for CBOR
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_encode_doc(const lwjson_doc_t* doc, const lwjson_token_t* token, lwjson_writer_t* w, size_t* len,
+               uint8_t msgpack) {
+    lwjson_bin_out_t o = {w, 0};
+    lwjsonr_t res;
+
+    if (doc == NULL || doc->root == NULL) {
+        return lwjsonERR;
+    }
+    if ((res = prv_encode(&o, token != NULL ? token : doc->root, msgpack)) == lwjsonOK && w != NULL) {
+        res = w->err;
+    }
+    if (res == lwjsonOK && len != NULL) {
+        *len = o.len;
+    }
+    return res;
+}
+
+/**
+ * \brief           Encode token subtree of parsed document to CBOR, as per RFC 8949
+ *
+ * Objects and arrays are encoded with definite length, integers with the shortest form.
+ * Real numbers are encoded as single precision float when it keeps the value, double precision otherwise.
+ * String escape sequences are decoded to UTF-8 text.
+ * Call with `NULL` writer first to get exact length and preallocate output.
+ *
+ * \note            Function is thread-safe, document is not modified
+ * \param[in]       doc: Parsed document
+ * \param[in]       token: Token to encode. Set to `NULL` to encode complete document
+ * \param[in,out]   w: Writer instance for binary output, `NULL` to get length only
+ * \param[out]      len: Pointer to output variable with encoded length. Set to `NULL` if not used
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRJSON for invalid string escape sequence,
+ *                      member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_to_cbor(const lwjson_doc_t* doc, const lwjson_token_t* token, lwjson_writer_t* w, size_t* len) {
+    return prv_encode_doc(doc, token, w, len, 0);
+}
+
+/**
+ * \brief           Encode token subtree of parsed document to MessagePack
+ *
+ * Values are encoded with the shortest form, real numbers and strings as in \ref lwjson_to_cbor.
+ * Call with `NULL` writer first to get exact length and preallocate output.
+ *
+ * \note            Function is thread-safe, document is not modified
+ * \param[in]       doc: Parsed document
+ * \param[in]       token: Token to encode. Set to `NULL` to encode complete document
+ * \param[in,out]   w: Writer instance for binary output, `NULL` to get length only
+ * \param[out]      len: Pointer to output variable with encoded length. Set to `NULL` if not used
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRJSON for invalid string escape sequence,
+ *                      member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_to_msgpack(const lwjson_doc_t* doc, const lwjson_token_t* token, lwjson_writer_t* w, size_t* len) {
+    return prv_encode_doc(doc, token, w, len, 1);
+}
+
+/**
+ * \brief           Check if character is blank as per RFC4627
+ * \param[in]       ch: Character to check
+ * \return          `1` if blank, `0` otherwise
+ */
+static uint8_t
+prv_is_blank(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '\f';
+}
+
+/**
+ * \brief           Write CBOR number from JSON number text
+ * \param[in,out]   o: Binary output
+ * \param[in]       s: Number text
+ * \param[in]       len: Length of number text
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRJSON for invalid number
+ */
+static lwjsonr_t
+prv_cbor_number(lwjson_bin_out_t* o, const char* s, size_t len) {
+    char buf[64], *num_end;
+    uint8_t neg = *s == '-', is_real = 0;
+    uint64_t u = 0;
+    double d;
+
+    for (size_t i = neg; i < len; ++i) {
+        if (s[i] >= '0' && s[i] <= '9') {
+            if (u > (UINT64_MAX - 9) / 10) {
+                is_real = 1;                    /* Too large for integer */
+            }
+            u = u * 10 + (uint64_t)(s[i] - '0');
+        } else if (s[i] == '.' || s[i] == 'e' || s[i] == 'E' || s[i] == '+' || s[i] == '-') {
+            is_real = 1;
+        } else {
+            return lwjsonERRJSON;
+        }
+    }
+    if (len == (size_t)neg) {
+        return lwjsonERRJSON;
+    }
+    if (!is_real && (neg ? u <= (uint64_t)INT64_MAX + 1 : u <= (uint64_t)INT64_MAX)) {
+        return (neg && u > 0) ? prv_cbor_head(o, 1, u - 1) : prv_cbor_head(o, 0, u);
+    }
+
+    /* Number text is not terminated in input */
+    if (len >= sizeof(buf)) {
+        return lwjsonERRJSON;
+    }
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+    d = strtod(buf, &num_end);
+    if (num_end != &buf[len]) {
+        return lwjsonERRJSON;
+    }
+    return prv_out_real(o, d, 0xFA, 0xFB);
+}
+
+/**
+ * \brief           Transcode JSON text to CBOR without creating tokens
+ *
+ * Text is processed in single pass, like \ref lwjson_minify. Objects and arrays are written
+ * with indefinite length, so that output never waits for number of children.
+ * Values are encoded as in \ref lwjson_to_cbor. Brackets must match, strings must be terminated
+ * and numbers and literals must be valid, other structure of input is not validated.
+ *
+ * \param[in]       in: Input JSON text
+ * \param[in]       len: Length of input text in units of bytes
+ * \param[in,out]   w: Writer instance for binary output
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRJSON for invalid input,
+ *                      \ref lwjsonERRMEM for input nested deeper than \ref LWJSON_CFG_WRITER_MAX_DEPTH,
+ *                      member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_json_to_cbor(const char* in, size_t len, lwjson_writer_t* w) {
+    const char *s = in, *end = in + len;
+    lwjson_bin_out_t o = {w, 0};
+    uint32_t is_obj[(LWJSON_WRITER_MAX_DEPTH + 31) / 32] = {0};
+    lwjsonr_t res = lwjsonOK;
+    size_t depth = 0;
+
+    if (in == NULL || w == NULL) {
+        return lwjsonERR;
+    }
+    while (s < end && res == lwjsonOK && w->err == lwjsonOK) {
+        const char* run = s;
+
+        switch (*s) {
+            case '{':
+            case '[':
+                if (depth == LWJSON_WRITER_MAX_DEPTH) {
+                    return lwjsonERRMEM;
+                }
+                if (*s == '{') {
+                    is_obj[depth >> 5] |= (uint32_t)1 << (depth & 0x1F);
+                } else {
+                    is_obj[depth >> 5] &= ~((uint32_t)1 << (depth & 0x1F));
+                }
+                ++depth;
+                res = prv_out_be(&o, *s == '{' ? 0xBF : 0x9F, 0, 0);
+                ++s;
+                break;
+            case '}':
+            case ']':
+                if (depth == 0
+                    || ((is_obj[(depth - 1) >> 5] >> ((depth - 1) & 0x1F)) & 0x01) != (uint32_t)(*s == '}')) {
+                    return lwjsonERRJSON;
+                }
+                --depth;
+                res = prv_out_be(&o, 0xFF, 0, 0);
+                ++s;
+                break;
+            case ',':
+            case ':':
+                ++s;
+                break;
+            case '"': {
+                const char* q = NULL;
+
+                /* Quote is escaped when preceded by odd number of backslashes */
+                for (++s; s < end;) {
+                    const char* b;
+
+                    if ((q = memchr(s, '"', (size_t)(end - s))) == NULL) {
+                        break;
+                    }
+                    for (b = q; b > s && b[-1] == '\\'; --b) {}
+                    if (((q - b) & 0x01) == 0) {
+                        break;
+                    }
+                    s = q + 1;
+                    q = NULL;
+                }
+                if (q == NULL) {
+                    return lwjsonERRJSON;
+                }
+                s = q + 1;
+                res = prv_cbor_string(&o, run + 1, (size_t)(q - run - 1));
+                break;
+            }
+            default:
+                if (prv_is_blank(*s)) {
+                    ++s;
+                    break;
+                }
+                for (++s; s < end && strchr("{}[],:\" \t\r\n\f", *s) == NULL; ++s) {}
+                if (s - run == 4 && !strncmp(run, "true", 4)) {
+                    res = prv_out_be(&o, 0xF5, 0, 0);
+                } else if (s - run == 5 && !strncmp(run, "false", 5)) {
+                    res = prv_out_be(&o, 0xF4, 0, 0);
+                } else if (s - run == 4 && !strncmp(run, "null", 4)) {
+                    res = prv_out_be(&o, 0xF6, 0, 0);
+                } else {
+                    res = prv_cbor_number(&o, run, (size_t)(s - run));
+                }
+                break;
+        }
+    }
+    if (res == lwjsonOK && depth > 0) {
+        res = lwjsonERRJSON;
+    }
+    return res != lwjsonOK ? res : w->err;
+}
+
+/**
+ * \brief           Largest value of \ref lwjson_int_t
+ */
+#define LWJSON_INT_MAX                      ((uint64_t)-1 >> (64 - 8 * sizeof(lwjson_int_t) + 1))
+
+/**
+ * \brief           Number of children left to decode in open object or array
+ *
+ * Open container keeps its last child in `next` field, like in text parser, and the number of
+ * children left in string length field, which is not used by containers. `SIZE_MAX` is used
+ * for CBOR indefinite length container.
+ */
+#define LWJSON_BIN_LEFT(token)              ((token)->u.str.token_value_len)
+
+/**
+ * \brief           Binary item decoder prototype
+ * \param[in,out]   pp: Pointer to input data, set after the item
+ * \param[in]       end: End of input data
+ * \param[out]      t: Token to fill with item type and value
+ * \param[out]      count: Number of children for object or array
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+typedef lwjsonr_t (*lwjson_bin_read_fn)(const uint8_t** pp, const uint8_t* end, lwjson_token_t* t, size_t* count);
+
+/**
+ * \brief           Allocate new token for binary decoder
+ * \param[in]       lw: LwJSON instance
+ * \return          New token, `NULL` when there is no free token
+ */
+static lwjson_token_t*
+prv_alloc_token(lwjson_t* lw) {
+    if (lw->next_free_token_pos < lw->tokens_len) {
+        memset(&lw->tokens[lw->next_free_token_pos], 0x00, sizeof(*lw->tokens));
+        return &lw->tokens[lw->next_free_token_pos++];
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Read big-endian unsigned value
+ * \param[in,out]   pp: Pointer to input data, set after the value
+ * \param[in]       end: End of input data
+ * \param[in]       size: Number of bytes to read
+ * \param[out]      val: Value
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRJSON when input is too short
+ */
+static lwjsonr_t
+prv_in_be(const uint8_t** pp, const uint8_t* end, size_t size, uint64_t* val) {
+    if ((size_t)(end - *pp) < size) {
+        return lwjsonERRJSON;
+    }
+    *val = 0;
+    for (size_t i = 0; i < size; ++i) {
+        *val = (*val << 8) | *(*pp)++;
+    }
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Set token to unsigned or negative integer, real number when it does not fit to \ref lwjson_int_t
+ * \param[out]      t: Token to set
+ * \param[in]       mag: Magnitude, value itself for positive number and `-1 - value` for negative number
+ * \param[in]       neg: Set to `1` for negative number
+ */
+static void
+prv_set_int(lwjson_token_t* t, uint64_t mag, uint8_t neg) {
+    if (mag <= LWJSON_INT_MAX) {
+        t->type = LWJSON_TYPE_NUM_INT;
+        t->u.num_int = neg ? -1 - (lwjson_int_t)mag : (lwjson_int_t)mag;
+    } else {
+        t->type = LWJSON_TYPE_NUM_REAL;
+        t->u.num_real = neg ? (lwjson_real_t)(-1.0 - (double)mag) : (lwjson_real_t)mag;
+    }
+}
+
+/**
+ * \brief           Set token to string that references input data
+ * \param[in,out]   pp: Pointer to input data, set after the string
+ * \param[in]       end: End of input data
+ * \param[out]      t: Token to set
+ * \param[in]       len: String length
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRJSON when input is too short
+ */
+static lwjsonr_t
+prv_set_string(const uint8_t** pp, const uint8_t* end, lwjson_token_t* t, uint64_t len) {
+    if ((uint64_t)(end - *pp) < len) {
+        return lwjsonERRJSON;
+    }
+    t->type = LWJSON_TYPE_STRING;
+    t->u.str.token_value = (const char*)*pp;
+    t->u.str.token_value_len = (size_t)len;
+    *pp += len;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Escape decoded string for JSON, so that tokens hold the same text as after \ref lwjson_parse
+ *
+ * Strings without characters to escape keep referencing input data, others are copied to escape buffer.
+ *
+ * \param[in,out]   esc: Writer over escape buffer, `NULL` when there is no buffer
+ * \param[in,out]   str: String to escape, set to escaped string
+ * \param[in,out]   len: Length of string, set to length of escaped string
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM when escape buffer is full
+ */
+static lwjsonr_t
+prv_escape_string(lwjson_writer_t* esc, const char** str, size_t* len) {
+    size_t i = 0, start;
+
+    for (; i < *len; ++i) {
+        unsigned char ch = (unsigned char)(*str)[i];
+
+        if (ch < 0x20 || ch == '"' || ch == '\\') {
+            break;
+        }
+    }
+    if (i == *len) {
+        return lwjsonOK;
+    }
+    if (esc == NULL) {
+        return lwjsonERRMEM;
+    }
+    start = esc->len;
+    if (lwjson_writer_string(esc, *str, *len) != lwjsonOK) {
+        return esc->err;
+    }
+    *str = &esc->buf[start + 1];                /* Without quotes */
+    *len = esc->len - start - 2;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Set token to real number from IEEE 754 bits
+ * \param[out]      t: Token to set
+ * \param[in]       bits: Number bits
+ * \param[in]       size: Number size in units of bytes, `2`, `4` or `8`
+ */
+static void
+prv_set_real(lwjson_token_t* t, uint64_t bits, size_t size) {
+    double d;
+
+    if (size == 2) {
+        uint32_t exp = (uint32_t)(bits >> 10) & 0x1F, mant = (uint32_t)bits & 0x3FF;
+
+        if (exp == 0) {
+            d = (double)mant / 16777216.0;      /* Subnormal, mant * 2^-24 */
+            d = (bits & 0x8000) ? -d : d;
+        } else {
+            /* Same value in single precision layout, infinity and NaN keep all exponent bits set */
+            uint32_t b32 = ((uint32_t)(bits & 0x8000) << 16) | ((exp == 31 ? 0xFF : exp - 15 + 127) << 23) | (mant << 13);
+            float f;
+
+            memcpy(&f, &b32, sizeof(f));
+            d = f;
+        }
+    } else if (size == 4) {
+        uint32_t b32 = (uint32_t)bits;
+        float f;
+
+        memcpy(&f, &b32, sizeof(f));
+        d = f;
+    } else {
+        memcpy(&d, &bits, sizeof(d));
+    }
+    t->type = LWJSON_TYPE_NUM_REAL;
+    t->u.num_real = (lwjson_real_t)d;
+}
+
+/**
+ * \brief           Decode single CBOR data item head, see \ref lwjson_bin_read_fn
+ */
+static lwjsonr_t
+prv_cbor_read(const uint8_t** pp, const uint8_t* end, lwjson_token_t* t, size_t* count) {
+    uint8_t ib, major, ai;
+    uint64_t arg = 0;
+
+    /* Tags are skipped, tagged item is used as it is */
+    do {
+        if (*pp >= end) {
+            return lwjsonERRJSON;
+        }
+        ib = *(*pp)++;
+        major = ib >> 5;
+        ai = ib & 0x1F;
+        if (ai < 24) {
+            arg = ai;
+        } else if (ai <= 27) {
+            if (prv_in_be(pp, end, (size_t)1 << (ai - 24), &arg) != lwjsonOK) {
+                return lwjsonERRJSON;
+            }
+        } else if (ai != 31 || major < 4 || major == 6) {
+            return lwjsonERRJSON;                       /* Reserved, or chunked string that cannot be referenced */
+        }
+    } while (major == 6);
+
+    switch (major) {
+        case 0: prv_set_int(t, arg, 0); break;
+        case 1: prv_set_int(t, arg, 1); break;
+        case 2:
+        case 3: return prv_set_string(pp, end, t, arg);
+        case 4:
+        case 5:
+            t->type = major == 5 ? LWJSON_TYPE_OBJECT : LWJSON_TYPE_ARRAY;
+            if (ai == 31) {
+                *count = SIZE_MAX;
+            } else if (arg >= SIZE_MAX || arg > (uint64_t)(end - *pp)) {
+                return lwjsonERRJSON;                   /* Every child needs at least one byte */
+            } else {
+                *count = (size_t)arg;
+            }
+            break;
+        default:
+            if (ai == 20 || ai == 21) {
+                t->type = ai == 21 ? LWJSON_TYPE_TRUE : LWJSON_TYPE_FALSE;
+            } else if (ai == 22 || ai == 23) {
+                t->type = LWJSON_TYPE_NULL;             /* Undefined is decoded as null */
+            } else if (ai >= 25 && ai <= 27) {
+                prv_set_real(t, arg, (size_t)1 << (ai - 24));
+            } else {
+                return lwjsonERRJSON;
+            }
+            break;
+    }
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Decode single MessagePack object head, see \ref lwjson_bin_read_fn
+ */
+static lwjsonr_t
+prv_msgpack_read(const uint8_t** pp, const uint8_t* end, lwjson_token_t* t, size_t* count) {
+    uint64_t val = 0;
+    uint8_t b;
+
+    if (*pp >= end) {
+        return lwjsonERRJSON;
+    }
+    b = *(*pp)++;
+    if (b <= 0x7F) {
+        prv_set_int(t, b, 0);
+    } else if (b >= 0xE0) {
+        prv_set_int(t, (uint64_t)(0xFF - b), 1);
+    } else if (b <= 0x9F) {
+        t->type = b <= 0x8F ? LWJSON_TYPE_OBJECT : LWJSON_TYPE_ARRAY;
+        *count = b & 0x0F;
+    } else if (b <= 0xBF) {
+        return prv_set_string(pp, end, t, b & 0x1F);
+    } else {
+        switch (b) {
+            case 0xC0: t->type = LWJSON_TYPE_NULL; break;
+            case 0xC2: t->type = LWJSON_TYPE_FALSE; break;
+            case 0xC3: t->type = LWJSON_TYPE_TRUE; break;
+            case 0xC4: case 0xC5: case 0xC6:            /* Binary is decoded as string */
+                if (prv_in_be(pp, end, (size_t)1 << (b - 0xC4), &val) != lwjsonOK) {
+                    return lwjsonERRJSON;
+                }
+                return prv_set_string(pp, end, t, val);
+            case 0xD9: case 0xDA: case 0xDB:
+                if (prv_in_be(pp, end, (size_t)1 << (b - 0xD9), &val) != lwjsonOK) {
+                    return lwjsonERRJSON;
+                }
+                return prv_set_string(pp, end, t, val);
+            case 0xCA: case 0xCB:
+                if (prv_in_be(pp, end, b == 0xCA ? 4 : 8, &val) != lwjsonOK) {
+                    return lwjsonERRJSON;
+                }
+                prv_set_real(t, val, b == 0xCA ? 4 : 8);
+                break;
+            case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+                if (prv_in_be(pp, end, (size_t)1 << (b - 0xCC), &val) != lwjsonOK) {
+                    return lwjsonERRJSON;
+                }
+                prv_set_int(t, val, 0);
+                break;
+            case 0xD0: case 0xD1: case 0xD2: case 0xD3: {
+                size_t size = (size_t)1 << (b - 0xD0);
+
+                if (prv_in_be(pp, end, size, &val) != lwjsonOK) {
+                    return lwjsonERRJSON;
+                }
+                /* Sign extend to 64 bits */
+                if (size < 8 && (val >> (8 * size - 1)) != 0) {
+                    val |= (uint64_t)-1 << (8 * size);
+                }
+                if ((int64_t)val < 0) {
+                    prv_set_int(t, ~val, 1);
+                } else {
+                    prv_set_int(t, val, 0);
+                }
+                break;
+            }
+            case 0xDC: case 0xDD: case 0xDE: case 0xDF:
+                if (prv_in_be(pp, end, (b & 0x01) ? 4 : 2, &val) != lwjsonOK || val > (uint64_t)(end - *pp)) {
+                    return lwjsonERRJSON;
+                }
+                t->type = b >= 0xDE ? LWJSON_TYPE_OBJECT : LWJSON_TYPE_ARRAY;
+                *count = (size_t)val;
+                break;
+            default:
+                return lwjsonERRJSON;                   /* Extension types have no JSON equivalent */
+        }
+    }
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Decode binary data to tokens
+ * \param[in,out]   lw: LwJSON instance
+ * \param[in]       data: Input data
+ * \param[in]       len: Length of input data
+ * \param[in]       buf: Buffer for escaped strings, can be `NULL`
+ * \param[in]       buf_len: Size of `buf` in units of bytes
+ * \param[in]       read_fn: Item decoder of the format
+ * \param[in]       brk: Set to `1` when format has CBOR break code for indefinite length containers
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_parse_binary(lwjson_t* lw, const void* data, size_t len, char* buf, size_t buf_len, lwjson_bin_read_fn read_fn,
+                 uint8_t brk) {
+    const uint8_t *p = data, *end = p + len;
+    lwjson_token_t *t, *to = &lw->first_token, key;
+    lwjson_writer_t esc_w, *esc = NULL;
+    size_t cnt = 0;
+    lwjsonr_t res;
+
+    if (lwjson_writer_init(&esc_w, buf, buf_len, NULL, NULL) == lwjsonOK) {
+        esc = &esc_w;
+    }
+
+    lw->flags.parsed = 0;
+    lw->flags.split = 0;
+    lw->next_free_token_pos = 0;
+    memset(&lw->first_token, 0x00, sizeof(lw->first_token));
+    if (p == NULL || len == 0) {
+        return lwjsonERRJSON;
+    }
+
+    /* Top item must be object or array */
+    if ((res = read_fn(&p, end, to, &cnt)) != lwjsonOK) {
+        return res;
+    }
+    if (to->type != LWJSON_TYPE_OBJECT && to->type != LWJSON_TYPE_ARRAY) {
+        return lwjsonERRJSON;
+    }
+    LWJSON_BIN_LEFT(to) = cnt;
+    while (to != NULL) {
+        /* Close container when all children are decoded */
+        if (LWJSON_BIN_LEFT(to) == 0 || (brk && LWJSON_BIN_LEFT(to) == SIZE_MAX && p < end && *p == 0xFF)) {
+            p += LWJSON_BIN_LEFT(to) != 0;
+            LWJSON_BIN_LEFT(to) = 0;
+            to->next = NULL;
+            to = to->parent;
+            continue;
+        }
+        if ((t = prv_alloc_token(lw)) == NULL) {
+            return lwjsonERRMEM;
+        }
+        t->parent = to;
+
+        /* Object member names must be strings */
+        if (to->type == LWJSON_TYPE_OBJECT) {
+            memset(&key, 0x00, sizeof(key));
+            if ((res = read_fn(&p, end, &key, &cnt)) != lwjsonOK || key.type != LWJSON_TYPE_STRING) {
+                return res != lwjsonOK ? res : lwjsonERRJSON;
+            }
+            if ((res = prv_escape_string(esc, &key.u.str.token_value, &key.u.str.token_value_len)) != lwjsonOK) {
+                return res;
+            }
+            t->token_name = key.u.str.token_value;
+            t->token_name_len = key.u.str.token_value_len;
+        }
+        if (to->u.first_child == NULL) {
+            to->u.first_child = t;
+        } else {
+            to->next->next = t;
+        }
+        to->next = t;
+        if (LWJSON_BIN_LEFT(to) != SIZE_MAX) {
+            --LWJSON_BIN_LEFT(to);
+        }
+
+        if ((res = read_fn(&p, end, t, &cnt)) != lwjsonOK) {
+            return res;
+        }
+        if (t->type == LWJSON_TYPE_STRING
+            && (res = prv_escape_string(esc, &t->u.str.token_value, &t->u.str.token_value_len)) != lwjsonOK) {
+            return res;
+        }
+        if (t->type == LWJSON_TYPE_OBJECT || t->type == LWJSON_TYPE_ARRAY) {
+            LWJSON_BIN_LEFT(t) = cnt;
+            to = t;
+        }
+    }
+    if (p != end) {
+        return lwjsonERR;
+    }
+    lw->flags.parsed = 1;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Parse CBOR data item to tokens, as per RFC 8949
+ *
+ * Tokens are the same as for JSON text and all access functions, writer and diff work unchanged.
+ * Tokens have no input text span, \ref lwjson_get_raw returns `NULL` and patch functions
+ * that splice input text return error.
+ * Text and byte strings are referenced in input data, strings with quote, backslash or control characters
+ * are copied to `buf` with JSON escape sequences, like they would be in JSON text.
+ * Tags are skipped, undefined value is decoded as null, integers that do not fit to \ref lwjson_int_t as real numbers.
+ * Top item must be map or array, map keys must be strings. Indefinite length strings are not supported.
+ *
+ * \param[in,out]   lw: LwJSON instance
+ * \param[in]       data: CBOR data. It must stay valid while tokens are used
+ * \param[in]       len: Length of data in units of bytes
+ * \param[in]       buf: Buffer for escaped strings, it must stay valid while tokens are used. Can be `NULL`
+ *                      when no string needs escaping
+ * \param[in]       buf_len: Size of `buf` in units of bytes
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM when tokens or `buf` are full,
+ *                      member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_parse_cbor(lwjson_t* lw, const void* data, size_t len, char* buf, size_t buf_len) {
+    if (lw == NULL) {
+        return lwjsonERR;
+    }
+    return prv_parse_binary(lw, data, len, buf, buf_len, prv_cbor_read, 1);
+}
+
+/**
+ * \brief           Parse MessagePack object to tokens
+ *
+ * Tokens are the same as for JSON text and all access functions, writer and diff work unchanged,
+ * without input text span as with \ref lwjson_parse_cbor.
+ * Strings and binary data are decoded as strings and escaped the same way as by \ref lwjson_parse_cbor.
+ * Top object must be map or array, map keys must be strings. Extension types are not supported.
+ *
+ * \param[in,out]   lw: LwJSON instance
+ * \param[in]       data: MessagePack data. It must stay valid while tokens are used
+ * \param[in]       len: Length of data in units of bytes
+ * \param[in]       buf: Buffer for escaped strings, it must stay valid while tokens are used. Can be `NULL`
+ *                      when no string needs escaping
+ * \param[in]       buf_len: Size of `buf` in units of bytes
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM when tokens or `buf` are full,
+ *                      member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_parse_msgpack(lwjson_t* lw, const void* data, size_t len, char* buf, size_t buf_len) {
+    if (lw == NULL) {
+        return lwjsonERR;
+    }
+    return prv_parse_binary(lw, data, len, buf, buf_len, prv_msgpack_read, 0);
+}
@@ -0,0 +1,282 @@
+/**
+ * \file            lwjson_gzip.c
+ * \brief           Newline delimited JSON parser for gzip compressed input
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwJSON - Lightweight JSON format parser.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "lwjson/lwjson.h"
+
+#if LWJSON_CFG_ZLIB || __DOXYGEN__
+#include <unistd.h>
+#include <zlib.h>
+#if LWJSON_CFG_PARALLEL_THREADS
+#include <pthread.h>
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+
+/**
+ * \brief           Window of decompressed text
+ *
+ * Window holds tail of previous window, which is start of record not finished there,
+ * followed by up to \ref LWJSON_CFG_INFLATE_WINDOW new bytes.
+ */
+typedef struct {
+    char* data;                                 /*!< Text memory of `2 * LWJSON_CFG_INFLATE_WINDOW` bytes */
+    size_t len;                                 /*!< Length of text in window */
+    size_t parse_len;                           /*!< Length of complete records, up to and including last newline */
+    uint8_t filled;                             /*!< Set when window is ready to be parsed */
+    uint8_t last;                               /*!< Set for last window of input */
+} lwjson_gz_window_t;
+
+/**
+ * \brief           State of compressed input parse
+ */
+typedef struct {
+    gzFile gz;                                  /*!< Compressed input */
+    lwjson_gz_window_t win[2];                  /*!< Windows filled and parsed in turns */
+    lwjsonr_t res;                              /*!< First error of decompression, parsing or callback */
+#if LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__
+    pthread_mutex_t mutex;                      /*!< Protects window flags and result */
+    pthread_cond_t cond;                        /*!< Signals change of window flags or result */
+#endif /* LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__ */
+} lwjson_gz_t;
+
+/**
+ * \brief           Fill window with unfinished record of previous window and new decompressed text
+ * \param[in,out]   gz: Compressed input state
+ * \param[in]       w: Window to fill
+ * \param[in]       prev: Previous window, `NULL` for first window
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM when record is longer than window,
+ *                      \ref lwjsonERR on decompression error
+ */
+static lwjsonr_t
+prv_gz_fill(lwjson_gz_t* gz, lwjson_gz_window_t* w, const lwjson_gz_window_t* prev) {
+    size_t carry = prev != NULL ? prev->len - prev->parse_len : 0;
+    const char* nl;
+    int r;
+
+    if (carry > LWJSON_CFG_INFLATE_WINDOW) {
+        return lwjsonERRMEM;
+    }
+    if (carry > 0) {
+        memcpy(w->data, &prev->data[prev->parse_len], carry);
+    }
+    if ((r = gzread(gz->gz, &w->data[carry], LWJSON_CFG_INFLATE_WINDOW)) < 0) {
+        return lwjsonERR;
+    }
+    w->len = carry + (size_t)r;
+    w->last = r == 0 || gzeof(gz->gz);
+    if (w->last) {
+        int err;
+
+        /* Input that ends in the middle of compressed stream is reported at its end only */
+        gzerror(gz->gz, &err);
+        if (err != Z_OK) {
+            return lwjsonERR;
+        }
+    }
+
+    /* Last window is parsed to its end, other windows to the last complete record */
+    if (w->last) {
+        w->parse_len = w->len;
+    } else {
+        for (nl = &w->data[w->len]; nl > w->data && nl[-1] != '\n'; --nl) {}
+        w->parse_len = (size_t)(nl - w->data);
+    }
+    return lwjsonOK;
+}
+
+#if LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__
+
+/**
+ * \brief           Decompression thread, fills windows in turns while parsing thread parses the other one
+ * \param[in]       arg: Compressed input state
+ * \return          `NULL`
+ */
+static void*
+prv_gz_producer(void* arg) {
+    lwjson_gz_t* gz = arg;
+    const lwjson_gz_window_t* prev = NULL;
+
+    for (size_t i = 0;; i ^= 1) {
+        lwjson_gz_window_t* w = &gz->win[i];
+        lwjsonr_t res;
+
+        pthread_mutex_lock(&gz->mutex);
+        while (w->filled && gz->res == lwjsonOK) {
+            pthread_cond_wait(&gz->cond, &gz->mutex);
+        }
+        res = gz->res;
+        pthread_mutex_unlock(&gz->mutex);
+        if (res != lwjsonOK) {
+            break;
+        }
+
+        /* Previous window is only read here, while parsing thread may be parsing it */
+        res = prv_gz_fill(gz, w, prev);
+        pthread_mutex_lock(&gz->mutex);
+        if (res != lwjsonOK && gz->res == lwjsonOK) {
+            gz->res = res;
+        }
+        w->filled = res == lwjsonOK;
+        pthread_cond_broadcast(&gz->cond);
+        pthread_mutex_unlock(&gz->mutex);
+        if (res != lwjsonOK || w->last) {
+            break;
+        }
+        prev = w;
+    }
+    return NULL;
+}
+
+#endif /* LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__ */
+
+/**
+ * \brief           Parse gzip compressed newline delimited JSON, without decompressing whole input to memory
+ *
+ * Input is decompressed in windows of \ref LWJSON_CFG_INFLATE_WINDOW bytes and complete records of every window
+ * are parsed with \ref lwjson_ndjson_parse, record not finished at window end is moved to the next window.
+ * With \ref LWJSON_CFG_PARALLEL_THREADS enabled, decompression runs on separate thread and fills one window
+ * while calling thread parses the other one.
+ *
+ * Record text and parsed document passed to callback are valid only during the callback.
+ * Input that is not compressed is parsed as it is.
+ *
+ * \note            Available when \ref LWJSON_CFG_ZLIB is enabled, requires zlib library
+ * \param[in,out]   lw: LwJSON instance with tokens for the largest record
+ * \param[in]       fd: File descriptor of compressed input, it stays open
+ * \param[in]       fn: Callback function called for every record
+ * \param[in]       arg: User argument passed to callback
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM for record longer than window or when memory
+ *                      cannot be allocated, \ref lwjsonERR on read or decompression error, or when input
+ *                      is truncated in the middle of compressed stream,
+ *                      value returned by callback when it stops parsing
+ */
+lwjsonr_t
+lwjson_gz_ndjson_parse(lwjson_t* lw, int fd, lwjson_ndjson_fn fn, void* arg) {
+    lwjson_gz_t gz;
+    lwjsonr_t res = lwjsonOK;
+    int gz_fd;
+
+    if (lw == NULL || fd < 0 || fn == NULL) {
+        return lwjsonERR;
+    }
+    memset(&gz, 0x00, sizeof(gz));
+    gz.res = lwjsonOK;
+    if ((gz.win[0].data = malloc(4 * LWJSON_CFG_INFLATE_WINDOW)) == NULL) {
+        return lwjsonERRMEM;
+    }
+    gz.win[1].data = gz.win[0].data + 2 * LWJSON_CFG_INFLATE_WINDOW;
+    if ((gz_fd = dup(fd)) < 0 || (gz.gz = gzdopen(gz_fd, "rb")) == NULL) {
+        if (gz_fd >= 0) {
+            close(gz_fd);
+        }
+        free(gz.win[0].data);
+        return lwjsonERR;
+    }
+    gzbuffer(gz.gz, LWJSON_CFG_INFLATE_WINDOW);
+
+#if LWJSON_CFG_PARALLEL_THREADS
+    {
+        pthread_t producer;
+        uint8_t started = 0;
+
+        if (pthread_mutex_init(&gz.mutex, NULL) == 0) {
+            if (pthread_cond_init(&gz.cond, NULL) == 0) {
+                started = pthread_create(&producer, NULL, prv_gz_producer, &gz) == 0;
+                if (!started) {
+                    pthread_cond_destroy(&gz.cond);
+                }
+            }
+            if (!started) {
+                pthread_mutex_destroy(&gz.mutex);
+            }
+        }
+        if (started) {
+            for (size_t i = 0;; i ^= 1) {
+                lwjson_gz_window_t* w = &gz.win[i];
+                uint8_t last, filled;
+
+                pthread_mutex_lock(&gz.mutex);
+                while (!w->filled && gz.res == lwjsonOK) {
+                    pthread_cond_wait(&gz.cond, &gz.mutex);
+                }
+                filled = w->filled;
+                pthread_mutex_unlock(&gz.mutex);
+                if (!filled) {
+                    break;
+                }
+                res = lwjson_ndjson_parse(lw, w->data, w->parse_len, fn, arg);
+                last = w->last;
+
+                /* Window becomes free for decompression, error stops decompression thread */
+                pthread_mutex_lock(&gz.mutex);
+                if (res != lwjsonOK && gz.res == lwjsonOK) {
+                    gz.res = res;
+                }
+                w->filled = 0;
+                pthread_cond_broadcast(&gz.cond);
+                pthread_mutex_unlock(&gz.mutex);
+                if (res != lwjsonOK || last) {
+                    break;
+                }
+            }
+            pthread_join(producer, NULL);
+            pthread_cond_destroy(&gz.cond);
+            pthread_mutex_destroy(&gz.mutex);
+            res = gz.res;
+        } else
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+        {
+            /* Single thread decompresses and parses windows in turns */
+            const lwjson_gz_window_t* prev = NULL;
+
+            for (size_t i = 0; res == lwjsonOK; i ^= 1) {
+                if ((res = prv_gz_fill(&gz, &gz.win[i], prev)) == lwjsonOK) {
+                    res = lwjson_ndjson_parse(lw, gz.win[i].data, gz.win[i].parse_len, fn, arg);
+                }
+                if (gz.win[i].last) {
+                    break;
+                }
+                prev = &gz.win[i];
+            }
+        }
+#if LWJSON_CFG_PARALLEL_THREADS
+    }
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+    if (gzclose(gz.gz) != Z_OK && res == lwjsonOK) {
+        res = lwjsonERR;
+    }
+    free(gz.win[0].data);
+    return res;
+}
+
+#endif /* LWJSON_CFG_ZLIB || __DOXYGEN__ */
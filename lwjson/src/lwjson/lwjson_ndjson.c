@@ -0,0 +1,452 @@
+/**
+ * \file            lwjson_ndjson.c
+ * \brief           Newline delimited and concatenated JSON parser
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwJSON - Lightweight JSON format parser.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <string.h>
+#include "lwjson/lwjson.h"
+#if LWJSON_CFG_PARALLEL_THREADS
+#include <pthread.h>
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+
+/**
+ * \brief           Check if record has only blank characters
+ * \param[in]       s: Record start
+ * \param[in]       end: Record end
+ * \return          `1` if blank, `0` otherwise
+ */
+static uint8_t
+prv_is_blank_record(const char* s, const char* end) {
+    for (; s < end; ++s) {
+        if (*s != ' ' && *s != '\t' && *s != '\r' && *s != '\f') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * \brief           Parse records starting in given range
+ *
+ * Record may continue after `stop`, it is parsed up to its newline or end of input.
+ *
+ * \param[in,out]   lw: LwJSON instance used for every record
+ * \param[in]       p: Start of first record
+ * \param[in]       stop: No record starts at or after this position
+ * \param[in]       end: End of input text
+ * \param[in]       fn: Callback function
+ * \param[in]       arg: User argument
+ * \return          \ref lwjsonOK on success, value returned by callback when it stops parsing
+ */
+static lwjsonr_t
+prv_ndjson_range(lwjson_t* lw, const char* p, const char* stop, const char* end, lwjson_ndjson_fn fn, void* arg) {
+    lwjsonr_t res = lwjsonOK;
+    lwjson_doc_t doc;
+
+    while (p < stop && res == lwjsonOK) {
+        /* Newline search is done by libc, which scans multiple bytes at a time */
+        const char* nl = memchr(p, '\n', (size_t)(end - p));
+        const char* rec_end = nl != NULL ? nl : end;
+
+        if (!prv_is_blank_record(p, rec_end)) {
+            lwjsonr_t pres = lwjson_parse_ex(lw, p, (size_t)(rec_end - p));
+
+            lwjson_get_doc(lw, &doc);
+            res = fn(pres, &doc, p, (size_t)(rec_end - p), arg);
+        }
+        p = nl != NULL ? nl + 1 : end;
+    }
+    return res;
+}
+
+/**
+ * \brief           Parse newline delimited JSON, one record at a time
+ *
+ * Every line is parsed as separate JSON text with the same instance and passed to callback.
+ * Lines with blank characters only are skipped. Records that fail to parse are passed to callback too,
+ * with parse result and invalid document, so that application can decide to skip them or stop.
+ *
+ * \param[in,out]   lw: LwJSON instance with tokens for the largest record
+ * \param[in]       data: Input text, does not need to be `NULL` terminated
+ * \param[in]       len: Length of input text in units of bytes
+ * \param[in]       fn: Callback function called for every record
+ * \param[in]       arg: User argument passed to callback
+ * \return          \ref lwjsonOK on success, value returned by callback when it stops parsing
+ */
+lwjsonr_t
+lwjson_ndjson_parse(lwjson_t* lw, const char* data, size_t len, lwjson_ndjson_fn fn, void* arg) {
+    if (lw == NULL || (data == NULL && len > 0) || fn == NULL) {
+        return lwjsonERR;
+    }
+    return prv_ndjson_range(lw, data, data + len, data + len, fn, arg);
+}
+
+/**
+ * \brief           Setup iterator over records of newline delimited JSON
+ * \param[out]      it: Iterator to setup
+ * \param[in]       data: Input text, does not need to be `NULL` terminated.
+ *                      It must stay valid while iterator and parsed records are used
+ * \param[in]       len: Length of input text in units of bytes
+ * \param[in]       skip_errors: Set to `1` to skip malformed records and count them in `errors` member
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_lines_init(lwjson_lines_t* it, const char* data, size_t len, uint8_t skip_errors) {
+    if (it == NULL || (data == NULL && len > 0)) {
+        return lwjsonERR;
+    }
+    memset(it, 0x00, sizeof(*it));
+    it->p = data;
+    it->end = data + len;
+    it->skip_errors = skip_errors;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Parse next record of newline delimited JSON
+ *
+ * Record is parsed in place from input text, using tokens of given instance.
+ * Tokens of previous record are reused, and its document becomes invalid.
+ * Lines with blank characters only are skipped. Iterator always advances past the parsed line,
+ * so that malformed record can be reported and iteration can continue with next call.
+ *
+ * \param[in,out]   it: Iterator
+ * \param[in,out]   lw: LwJSON instance with tokens for the largest record
+ * \return          \ref lwjsonOK when record is parsed, \ref lwjsonEND when there are no more records,
+ *                      parse error of malformed record when errors are not skipped
+ */
+lwjsonr_t
+lwjson_lines_next(lwjson_lines_t* it, lwjson_t* lw) {
+    if (it == NULL || lw == NULL) {
+        return lwjsonERR;
+    }
+    while (it->p < it->end) {
+        const char* nl = memchr(it->p, '\n', (size_t)(it->end - it->p));
+        const char* rec_end = nl != NULL ? nl : it->end;
+        const char* rec = it->p;
+        lwjsonr_t res;
+
+        it->p = nl != NULL ? nl + 1 : it->end;
+        ++it->line;
+        if (prv_is_blank_record(rec, rec_end)) {
+            continue;
+        }
+        it->rec = rec;
+        it->rec_len = (size_t)(rec_end - rec);
+        if ((res = lwjson_parse_ex(lw, rec, it->rec_len)) == lwjsonOK || !it->skip_errors) {
+            return res;
+        }
+        ++it->errors;
+    }
+    it->p = it->end;
+    return lwjsonEND;
+}
+
+/**
+ * \brief           Record separator of RFC 7464 JSON text sequence
+ */
+#define LWJSON_SPLIT_RS                     '\x1E'
+
+/**
+ * \brief           Check if character separates values in a stream
+ * \param[in]       c: Character to check
+ * \return          `1` if separator, `0` otherwise
+ */
+static uint8_t
+prv_is_split_sep(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == LWJSON_SPLIT_RS;
+}
+
+/**
+ * \brief           Find end of string value without decoding it
+ * \param[in]       p: First character after opening quote
+ * \param[in]       end: End of input text
+ * \return          Pointer after closing quote, or `NULL` when string is not terminated
+ *                      before end of input or record separator
+ */
+static const char*
+prv_split_string_end(const char* p, const char* end) {
+    const char* q;
+
+    while ((q = memchr(p, '"', (size_t)(end - p))) != NULL) {
+        const char* b = q;
+
+        /* Record separator cannot be part of a string, it means value was truncated */
+        if (memchr(p, LWJSON_SPLIT_RS, (size_t)(q - p)) != NULL) {
+            return NULL;
+        }
+        /* Quote is escaped when preceded by odd number of backslashes */
+        while (b > p && b[-1] == '\\') {
+            --b;
+        }
+        if (((q - b) & 1) == 0) {
+            return q + 1;
+        }
+        p = q + 1;
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Setup splitter of concatenated JSON values
+ * \param[out]      sp: Splitter to setup
+ * \param[in]       data: Input text, does not need to be `NULL` terminated
+ * \param[in]       len: Length of input text in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_split_init(lwjson_split_t* sp, const char* data, size_t len) {
+    if (sp == NULL || (data == NULL && len > 0)) {
+        return lwjsonERR;
+    }
+    sp->p = data;
+    sp->end = data + len;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Find next value in stream of concatenated JSON values
+ *
+ * Values may follow each other directly, be separated by blank characters,
+ * or be prefixed with record separator `0x1E` as in RFC 7464 JSON text sequence.
+ * Boundaries are found by tracking brackets and strings only, no tokens are built
+ * and value itself is not validated. Returned span can be passed to \ref lwjson_parse_ex,
+ * possibly on another thread.
+ *
+ * Value that is not complete before end of input or before next record separator
+ * is returned with \ref lwjsonERRJSON result and splitting continues after it.
+ *
+ * \param[in,out]   sp: Splitter
+ * \param[out]      value: Start of value text
+ * \param[out]      value_len: Length of value text
+ * \return          \ref lwjsonOK when value is found, \ref lwjsonEND when there are no more values,
+ *                      \ref lwjsonERRJSON for truncated value
+ */
+lwjsonr_t
+lwjson_split_next(lwjson_split_t* sp, const char** value, size_t* value_len) {
+    const char *p, *end, *start;
+    lwjsonr_t res = lwjsonOK;
+
+    if (sp == NULL || value == NULL || value_len == NULL) {
+        return lwjsonERR;
+    }
+    p = sp->p;
+    end = sp->end;
+    while (p < end && prv_is_split_sep(*p)) {
+        ++p;
+    }
+    if (p >= end) {
+        sp->p = end;
+        return lwjsonEND;
+    }
+    start = p;
+    if (*p == '{' || *p == '[') {
+        size_t depth = 0;
+
+        for (; p < end; ++p) {
+            if (*p == '"') {
+                const char* q = prv_split_string_end(p + 1, end);
+
+                if (q == NULL) {
+                    res = lwjsonERRJSON;
+                    break;
+                }
+                p = q - 1;
+            } else if (*p == '{' || *p == '[') {
+                ++depth;
+            } else if (*p == '}' || *p == ']') {
+                if (--depth == 0) {
+                    ++p;
+                    break;
+                }
+            } else if (*p == LWJSON_SPLIT_RS) {
+                res = lwjsonERRJSON;
+                break;
+            }
+        }
+        if (depth > 0 && res == lwjsonOK) {
+            res = lwjsonERRJSON;
+        }
+    } else if (*p == '"') {
+        const char* q = prv_split_string_end(p + 1, end);
+
+        if (q != NULL) {
+            p = q;
+        } else {
+            res = lwjsonERRJSON;
+        }
+    } else {
+        /* Number or literal, ends where next value or separator starts */
+        while (p < end && !prv_is_split_sep(*p) && *p != '{' && *p != '[' && *p != '"') {
+            ++p;
+        }
+    }
+
+    /* Truncated value ends at next record separator, or at end of input */
+    if (res != lwjsonOK) {
+        const char* rs = memchr(start, LWJSON_SPLIT_RS, (size_t)(end - start));
+
+        p = rs != NULL ? rs : end;
+    }
+    *value = start;
+    *value_len = (size_t)(p - start);
+    sp->p = p;
+    return res;
+}
+
+#if LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__
+
+/**
+ * \brief           Shared state of parallel parse
+ */
+typedef struct {
+    const char* data;                           /*!< Input text */
+    size_t len;                                 /*!< Length of input text */
+    size_t blocks;                              /*!< Number of blocks input is split to */
+    size_t next_block;                          /*!< Next block to be claimed by worker */
+    lwjson_ndjson_fn fn;                        /*!< Callback function */
+    void* arg;                                  /*!< User argument */
+    lwjsonr_t res;                              /*!< First non-OK result */
+    pthread_mutex_t mutex;                      /*!< Protects block counter and result */
+} lwjson_ndjson_job_t;
+
+/**
+ * \brief           Claim next block to parse
+ * \param[in,out]   job: Parallel parse state
+ * \param[out]      blk: Claimed block index
+ * \return          `1` when block is claimed, `0` when there is no more work
+ */
+static uint8_t
+prv_ndjson_claim(lwjson_ndjson_job_t* job, size_t* blk) {
+    uint8_t ok = 0;
+
+    pthread_mutex_lock(&job->mutex);
+    if (job->res == lwjsonOK && job->next_block < job->blocks) {
+        *blk = job->next_block++;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&job->mutex);
+    return ok;
+}
+
+/**
+ * \brief           Worker thread, parses claimed blocks with its own token pool
+ * \param[in]       arg: Parallel parse state
+ * \return          `NULL`
+ */
+static void*
+prv_ndjson_worker(void* arg) {
+    lwjson_ndjson_job_t* job = arg;
+    lwjson_token_t tokens[LWJSON_CFG_NDJSON_TOKENS];
+    const char* end = job->data + job->len;
+    lwjson_t lw;
+    size_t blk;
+
+    lwjson_init(&lw, tokens, LWJSON_ARRAYSIZE(tokens));
+    while (prv_ndjson_claim(job, &blk)) {
+        const char* p = job->data + blk * LWJSON_CFG_PARALLEL_BLOCK;
+        const char* stop = (size_t)(end - p) > LWJSON_CFG_PARALLEL_BLOCK ? p + LWJSON_CFG_PARALLEL_BLOCK : end;
+        lwjsonr_t res;
+
+        /* Record crossing block start belongs to previous block */
+        if (blk > 0 && p[-1] != '\n') {
+            const char* nl = memchr(p, '\n', (size_t)(end - p));
+            p = nl != NULL ? nl + 1 : end;
+        }
+        if ((res = prv_ndjson_range(&lw, p, stop, end, job->fn, job->arg)) != lwjsonOK) {
+            pthread_mutex_lock(&job->mutex);
+            if (job->res == lwjsonOK) {
+                job->res = res;
+            }
+            pthread_mutex_unlock(&job->mutex);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Parse newline delimited JSON with multiple threads
+ *
+ * Input is split to blocks of \ref LWJSON_CFG_PARALLEL_BLOCK bytes, claimed dynamically by workers,
+ * so that threads finishing early continue with remaining blocks. Every record is parsed by the worker
+ * owning block where record starts, each worker has its own pool of \ref LWJSON_CFG_NDJSON_TOKENS tokens on stack.
+ * Calling thread is one of the workers.
+ *
+ * Callback is called concurrently from different threads and records are not passed in input order.
+ * When callback returns error, workers stop after their current block.
+ * See \ref lwjson_ndjson_parse for record rules.
+ *
+ * \note            Available when \ref LWJSON_CFG_PARALLEL_THREADS is enabled, requires POSIX threads
+ * \param[in]       data: Input text, does not need to be `NULL` terminated
+ * \param[in]       len: Length of input text in units of bytes
+ * \param[in]       nthreads: Number of threads to parse with, including calling thread
+ * \param[in]       fn: Callback function called for every record
+ * \param[in]       arg: User argument passed to callback
+ * \return          \ref lwjsonOK on success, value returned by callback when it stops parsing
+ */
+lwjsonr_t
+lwjson_ndjson_parse_parallel(const char* data, size_t len, size_t nthreads, lwjson_ndjson_fn fn, void* arg) {
+    pthread_t threads[LWJSON_CFG_PARALLEL_THREADS];
+    lwjson_ndjson_job_t job;
+    size_t started = 0;
+
+    if ((data == NULL && len > 0) || nthreads == 0 || fn == NULL) {
+        return lwjsonERR;
+    }
+    if (nthreads > LWJSON_CFG_PARALLEL_THREADS) {
+        nthreads = LWJSON_CFG_PARALLEL_THREADS;
+    }
+    memset(&job, 0x00, sizeof(job));
+    job.data = data;
+    job.len = len;
+    job.blocks = (len + LWJSON_CFG_PARALLEL_BLOCK - 1) / LWJSON_CFG_PARALLEL_BLOCK;
+    job.fn = fn;
+    job.arg = arg;
+    job.res = lwjsonOK;
+    if (pthread_mutex_init(&job.mutex, NULL) != 0) {
+        return lwjsonERR;
+    }
+
+    /* Thread that cannot be created is not needed, remaining workers take its blocks */
+    for (size_t i = 0; i + 1 < nthreads; ++i) {
+        if (pthread_create(&threads[started], NULL, prv_ndjson_worker, &job) == 0) {
+            ++started;
+        }
+    }
+    prv_ndjson_worker(&job);
+    for (size_t i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&job.mutex);
+    return job.res;
+}
+
+#endif /* LWJSON_CFG_PARALLEL_THREADS || __DOXYGEN__ */
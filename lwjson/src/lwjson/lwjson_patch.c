@@ -0,0 +1,1632 @@
+/**
+ * \file            lwjson_patch.c
+ * \brief           Modifications of parsed JSON with splice-based output
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwJSON - Lightweight JSON format parser.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <string.h>
+#include "lwjson/lwjson.h"
+
+/**
+ * \brief           Slots shared by hash tables of all objects on current nesting path
+ *
+ * Tables are taken from the store when object is entered and given back when it is left,
+ * in reverse order, so that one store on stack of the top function serves any nesting.
+ */
+typedef struct {
+    const lwjson_token_t* slots[LWJSON_CFG_HASH_SLOTS]; /*!< Members by hash of their name */
+    uint8_t matched[LWJSON_CFG_HASH_SLOTS];     /*!< Set when member was found by lookup */
+    size_t used;                                /*!< Number of slots taken by tables */
+} lwjson_member_store_t;
+
+/**
+ * \brief           Hash table of object members
+ */
+typedef struct {
+    lwjson_member_store_t* store;               /*!< Store table slots are taken from */
+    size_t off;                                 /*!< Index of first slot in store */
+    size_t size;                                /*!< Number of slots, power of `2` or `0` for empty object */
+    uint8_t valid;                              /*!< Set when all members are in the table */
+} lwjson_member_table_t;
+
+/**
+ * \brief           Calculate FNV-1a hash of member name
+ * \param[in]       name: Member name
+ * \param[in]       len: Length of name
+ * \return          Hash value
+ */
+static uint32_t
+prv_hash(const char* name, size_t len) {
+    uint32_t h = 2166136261UL;
+
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ (uint8_t)name[i]) * 16777619UL;
+    }
+    return h;
+}
+
+/**
+ * \brief           Check if token name equals to given name
+ * \param[in]       t: Token to check
+ * \param[in]       name: Name to compare with
+ * \param[in]       len: Length of name
+ * \return          `1` if equal, `0` otherwise
+ */
+static uint8_t
+prv_name_equal(const lwjson_token_t* t, const char* name, size_t len) {
+    return t->token_name_len == len && (len == 0 || !memcmp(t->token_name, name, len));
+}
+
+/**
+ * \brief           Fill hash table with members of object token
+ *
+ * Table takes smallest power of `2` slots, that is at least twice the number of members.
+ * When store has no space left, table is not valid and lookups walk all members.
+ *
+ * \param[out]      tbl: Table to fill, must be released with \ref prv_table_release
+ * \param[in,out]   store: Store to take slots from
+ * \param[in]       obj: Token of \ref LWJSON_TYPE_OBJECT type, may be `NULL`
+ */
+static void
+prv_table_build(lwjson_member_table_t* tbl, lwjson_member_store_t* store, const lwjson_token_t* obj) {
+    size_t cnt = 0;
+
+    memset(tbl, 0x00, sizeof(*tbl));
+    tbl->store = store;
+    if (obj == NULL || obj->type != LWJSON_TYPE_OBJECT) {
+        tbl->valid = 1;
+        return;
+    }
+    for (const lwjson_token_t* t = obj->u.first_child; t != NULL; t = t->next, ++cnt) {}
+    if (cnt > 0) {
+        for (tbl->size = 4; tbl->size < 2 * cnt; tbl->size <<= 1) {}
+        if (tbl->size > LWJSON_CFG_HASH_SLOTS - store->used) {
+            tbl->size = 0;
+            return;                             /* No space left, linear lookup is used */
+        }
+    }
+    tbl->off = store->used;
+    store->used += tbl->size;
+    memset(&store->slots[tbl->off], 0x00, tbl->size * sizeof(store->slots[0]));
+    memset(&store->matched[tbl->off], 0x00, tbl->size * sizeof(store->matched[0]));
+    for (const lwjson_token_t* t = obj->u.first_child; t != NULL; t = t->next) {
+        size_t i = prv_hash(t->token_name, t->token_name_len) & (tbl->size - 1);
+        for (; store->slots[tbl->off + i] != NULL; i = (i + 1) & (tbl->size - 1)) {}
+        store->slots[tbl->off + i] = t;
+    }
+    tbl->valid = 1;
+}
+
+/**
+ * \brief           Give table slots back to the store
+ * \param[in]       tbl: Table to release, the last built one that is not released yet
+ */
+static void
+prv_table_release(lwjson_member_table_t* tbl) {
+    tbl->store->used -= tbl->size;
+}
+
+/**
+ * \brief           Find slot of member with given name
+ * \param[in]       tbl: Valid table
+ * \param[in]       name: Member name
+ * \param[in]       len: Length of name
+ * \return          Slot index in store, `LWJSON_CFG_HASH_SLOTS` if not found
+ */
+static size_t
+prv_table_slot(const lwjson_member_table_t* tbl, const char* name, size_t len) {
+    const lwjson_member_store_t* store = tbl->store;
+
+    if (tbl->size > 0) {
+        for (size_t i = prv_hash(name, len) & (tbl->size - 1); store->slots[tbl->off + i] != NULL;
+             i = (i + 1) & (tbl->size - 1)) {
+            if (prv_name_equal(store->slots[tbl->off + i], name, len)) {
+                return tbl->off + i;
+            }
+        }
+    }
+    return LWJSON_CFG_HASH_SLOTS;
+}
+
+/**
+ * \brief           Find first object member with given name
+ * \param[in,out]   tbl: Table built for `obj`, found member is marked as matched
+ * \param[in]       obj: Token of \ref LWJSON_TYPE_OBJECT type, may be `NULL`
+ * \param[in]       name: Member name
+ * \param[in]       len: Length of name
+ * \return          Member token, `NULL` if not found
+ */
+static const lwjson_token_t*
+prv_table_get(lwjson_member_table_t* tbl, const lwjson_token_t* obj, const char* name, size_t len) {
+    size_t i;
+
+    if (obj == NULL || obj->type != LWJSON_TYPE_OBJECT) {
+        return NULL;
+    }
+    if (!tbl->valid) {
+        for (const lwjson_token_t* t = obj->u.first_child; t != NULL; t = t->next) {
+            if (prv_name_equal(t, name, len)) {
+                return t;
+            }
+        }
+        return NULL;
+    }
+    if ((i = prv_table_slot(tbl, name, len)) == LWJSON_CFG_HASH_SLOTS) {
+        return NULL;
+    }
+    tbl->store->matched[i] = 1;
+    return tbl->store->slots[i];
+}
+
+/**
+ * \brief           Check if member was found by any lookup in the table
+ * \param[in]       tbl: Table to check
+ * \param[in]       t: Member token
+ * \param[in]       other: Object token lookups were done for, used when table is not valid
+ * \return          `1` if member was matched, `0` otherwise
+ */
+static uint8_t
+prv_table_matched(lwjson_member_table_t* tbl, const lwjson_token_t* t, const lwjson_token_t* other) {
+    size_t i;
+
+    if (!tbl->valid) {
+        return prv_table_get(tbl, other, t->token_name, t->token_name_len) != NULL;
+    }
+    return (i = prv_table_slot(tbl, t->token_name, t->token_name_len)) != LWJSON_CFG_HASH_SLOTS
+           && tbl->store->matched[i];
+}
+
+/**
+ * \brief           Check if two objects or arrays have identical input text
+ *
+ * Values parsed from CBOR or MessagePack have no input text and are never identical.
+ *
+ * \param[in]       a: First value
+ * \param[in]       b: Second value
+ * \return          `1` if text is identical, `0` if not, if values are not containers or if spans are not available
+ */
+static uint8_t
+prv_raw_equal(const lwjson_token_t* a, const lwjson_token_t* b) {
+#if LWJSON_CFG_TOKEN_SPAN
+    return (a->type == LWJSON_TYPE_OBJECT || a->type == LWJSON_TYPE_ARRAY) && a->type == b->type
+           && a->token_raw != NULL && b->token_raw != NULL && a->token_raw_len == b->token_raw_len && !memcmp(a->token_raw, b->token_raw, a->token_raw_len);
+#else
+    (void)a;
+    (void)b;
+    return 0;
+#endif /* LWJSON_CFG_TOKEN_SPAN */
+}
+
+/**
+ * \brief           Compare two values for equality
+ *
+ * Numbers are compared by value, strings and names as they are in input text.
+ * With \ref LWJSON_CFG_TOKEN_SPAN enabled, identical input text is detected first without walking children.
+ *
+ * \param[in,out]   store: Store for member tables
+ * \param[in]       a: First value
+ * \param[in]       b: Second value
+ * \return          `1` if equal, `0` otherwise
+ */
+static uint8_t
+prv_equal(lwjson_member_store_t* store, const lwjson_token_t* a, const lwjson_token_t* b) {
+    const lwjson_token_t* ca, *cb;
+
+    if (prv_raw_equal(a, b)) {
+        return 1;
+    }
+    if ((a->type == LWJSON_TYPE_NUM_INT || a->type == LWJSON_TYPE_NUM_REAL)
+        && (b->type == LWJSON_TYPE_NUM_INT || b->type == LWJSON_TYPE_NUM_REAL)) {
+        if (a->type == LWJSON_TYPE_NUM_INT && b->type == LWJSON_TYPE_NUM_INT) {
+            return a->u.num_int == b->u.num_int;
+        }
+        return (a->type == LWJSON_TYPE_NUM_INT ? (lwjson_real_t)a->u.num_int : a->u.num_real)
+               == (b->type == LWJSON_TYPE_NUM_INT ? (lwjson_real_t)b->u.num_int : b->u.num_real);
+    }
+    if (a->type != b->type) {
+        return 0;
+    }
+    switch (a->type) {
+        case LWJSON_TYPE_STRING:
+            return a->u.str.token_value_len == b->u.str.token_value_len
+                   && !memcmp(a->u.str.token_value, b->u.str.token_value, a->u.str.token_value_len);
+        case LWJSON_TYPE_ARRAY:
+            for (ca = a->u.first_child, cb = b->u.first_child; ca != NULL && cb != NULL; ca = ca->next, cb = cb->next) {
+                if (!prv_equal(store, ca, cb)) {
+                    return 0;
+                }
+            }
+            return ca == NULL && cb == NULL;
+        case LWJSON_TYPE_OBJECT: {
+            lwjson_member_table_t tbl;
+            size_t cnt_a = 0, cnt_b = 0;
+
+            prv_table_build(&tbl, store, b);
+            for (ca = a->u.first_child; ca != NULL; ca = ca->next, ++cnt_a) {
+                if ((cb = prv_table_get(&tbl, b, ca->token_name, ca->token_name_len)) == NULL
+                    || !prv_equal(store, ca, cb)) {
+                    break;
+                }
+            }
+            prv_table_release(&tbl);
+            for (cb = b->u.first_child; ca == NULL && cb != NULL; cb = cb->next, ++cnt_b) {}
+            return ca == NULL && cnt_a == cnt_b;
+        }
+        default:
+            return 1;                           /* true, false and null */
+    }
+}
+
+/**
+ * \brief           Write result of merge patch for one value as per RFC 7386
+ * \param[in,out]   store: Store for member tables
+ * \param[in]       target: Target value, `NULL` if it does not exist
+ * \param[in]       patch: Patch value
+ * \param[in,out]   w: Writer instance
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_merge(lwjson_member_store_t* store, const lwjson_token_t* target, const lwjson_token_t* patch,
+          lwjson_writer_t* w) {
+    lwjson_member_table_t tbl;
+    const lwjson_token_t* p;
+
+    if (patch->type != LWJSON_TYPE_OBJECT) {
+        return lwjson_writer_token(w, patch);
+    }
+    if (target != NULL && target->type != LWJSON_TYPE_OBJECT) {
+        target = NULL;
+    }
+    lwjson_writer_begin_object(w);
+    prv_table_build(&tbl, store, patch);
+
+    /* Target members in original order, replaced, merged or removed by patch */
+    if (target != NULL) {
+        for (const lwjson_token_t* t = target->u.first_child; t != NULL && w->err == lwjsonOK; t = t->next) {
+            p = prv_table_get(&tbl, patch, t->token_name, t->token_name_len);
+            if (p != NULL && p->type == LWJSON_TYPE_NULL) {
+                continue;
+            }
+            lwjson_writer_key_raw(w, t->token_name, t->token_name_len);
+            if (p == NULL) {
+                lwjson_writer_token(w, t);
+            } else {
+                prv_merge(store, t, p, w);
+            }
+        }
+    }
+
+    /* New members from patch */
+    for (p = patch->u.first_child; p != NULL && w->err == lwjsonOK; p = p->next) {
+        if (p->type == LWJSON_TYPE_NULL || (target != NULL && prv_table_matched(&tbl, p, target))) {
+            continue;
+        }
+        lwjson_writer_key_raw(w, p->token_name, p->token_name_len);
+        prv_merge(store, NULL, p, w);
+    }
+    prv_table_release(&tbl);
+    return lwjson_writer_end(w);
+}
+
+/**
+ * \brief           Apply JSON merge patch as per RFC 7386 and write result
+ *
+ * Neither of input instances is modified. Object members are found with hash table lookup,
+ * so merging wide objects takes linear time. Tables of all objects on nesting path share
+ * \ref LWJSON_CFG_HASH_SLOTS slots on stack, objects that do not fit are merged with linear lookup.
+ * Member names are compared as they are in input text.
+ *
+ * \note            Function is thread-safe, documents are not modified
+ * \param[in]       base: Parsed target document
+ * \param[in]       patch: Parsed merge patch document
+ * \param[in,out]   w: Writer instance to write merged document to
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_merge_patch(const lwjson_doc_t* base, const lwjson_doc_t* patch, lwjson_writer_t* w) {
+    lwjson_member_store_t store;
+
+    if (base == NULL || patch == NULL || w == NULL || base->root == NULL || patch->root == NULL) {
+        return lwjsonERR;
+    }
+    store.used = 0;
+    return prv_merge(&store, base->root, patch->root, w);
+}
+
+/**
+ * \brief           Diff state with JSON pointer of current value
+ */
+typedef struct {
+    char path[LWJSON_CFG_DIFF_PATH_LEN];        /*!< JSON pointer of current value */
+    size_t path_len;                            /*!< Length of path */
+    lwjson_diff_fn fn;                          /*!< Callback function */
+    void* arg;                                  /*!< User argument for callback */
+    lwjson_member_store_t store;                /*!< Store for member tables */
+} lwjson_diff_ctx_t;
+
+/**
+ * \brief           Append decoded character of member name to current path
+ * \param[in,out]   ctx: Diff state
+ * \param[in]       c: Character, `~` and `/` are escaped as per RFC 6901
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM if path does not fit
+ */
+static lwjsonr_t
+prv_diff_push_char(lwjson_diff_ctx_t* ctx, char c) {
+    if (ctx->path_len + 2 > sizeof(ctx->path)) {
+        return lwjsonERRMEM;
+    }
+    if (c == '~' || c == '/') {
+        ctx->path[ctx->path_len++] = '~';
+        c = c == '~' ? '0' : '1';
+    }
+    ctx->path[ctx->path_len++] = c;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Decode 4 hexadecimal digits of `\u` escape sequence
+ * \param[in]       s: First digit
+ * \param[in]       end: End of name
+ * \return          Code unit, `-1` if digits are not valid
+ */
+static long
+prv_diff_hex4(const char* s, const char* end) {
+    long cu = 0;
+
+    if (end - s < 4) {
+        return -1;
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        char c = s[i];
+        int d = c >= '0' && c <= '9' ? c - '0' : (c | 0x20) >= 'a' && (c | 0x20) <= 'f' ? (c | 0x20) - 'a' + 10 : -1;
+
+        if (d < 0) {
+            return -1;
+        }
+        cu = (cu << 4) | d;
+    }
+    return cu;
+}
+
+/**
+ * \brief           Append member name to current path as pointer segment
+ *
+ * Name is decoded from JSON escape sequences first, pointer holds name characters as UTF-8.
+ * Lone surrogate code units are replaced with `U+FFFD` character.
+ *
+ * \param[in,out]   ctx: Diff state
+ * \param[in]       name: Member name as it is in JSON text
+ * \param[in]       len: Length of name
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM if path does not fit,
+ *                      \ref lwjsonERRJSON for invalid escape sequence
+ */
+static lwjsonr_t
+prv_diff_push_name(lwjson_diff_ctx_t* ctx, const char* name, size_t len) {
+    const char *s = name, *end = name + len;
+    lwjsonr_t res = lwjsonOK;
+
+    if (ctx->path_len >= sizeof(ctx->path)) {
+        return lwjsonERRMEM;
+    }
+    ctx->path[ctx->path_len++] = '/';
+    while (s < end && res == lwjsonOK) {
+        long cp;
+
+        if (*s != '\\') {
+            res = prv_diff_push_char(ctx, *s++);
+            continue;
+        }
+        if (++s == end) {
+            return lwjsonERRJSON;
+        }
+        switch (*s++) {
+            case '"': res = prv_diff_push_char(ctx, '"'); break;
+            case '\\': res = prv_diff_push_char(ctx, '\\'); break;
+            case '/': res = prv_diff_push_char(ctx, '/'); break;
+            case 'b': res = prv_diff_push_char(ctx, '\b'); break;
+            case 'f': res = prv_diff_push_char(ctx, '\f'); break;
+            case 'n': res = prv_diff_push_char(ctx, '\n'); break;
+            case 'r': res = prv_diff_push_char(ctx, '\r'); break;
+            case 't': res = prv_diff_push_char(ctx, '\t'); break;
+            case 'u':
+                if ((cp = prv_diff_hex4(s, end)) < 0) {
+                    return lwjsonERRJSON;
+                }
+                s += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    long lo = end - s >= 6 && s[0] == '\\' && s[1] == 'u' ? prv_diff_hex4(s + 2, end) : -1;
+                    if (lo >= 0xDC00 && lo <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        s += 6;
+                    } else {
+                        cp = 0xFFFD;
+                    }
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    cp = 0xFFFD;
+                }
+                if (cp < 0x80) {
+                    res = prv_diff_push_char(ctx, (char)cp);
+                } else {
+                    /* Leading byte, then continuation bytes from the highest */
+                    size_t n = cp < 0x800 ? 1 : cp < 0x10000 ? 2 : 3;
+
+                    res = prv_diff_push_char(ctx, (char)(((0xFF00 >> (n + 1)) & 0xFF) | (cp >> (6 * n))));
+                    while (n-- > 0 && res == lwjsonOK) {
+                        res = prv_diff_push_char(ctx, (char)(0x80 | ((cp >> (6 * n)) & 0x3F)));
+                    }
+                }
+                break;
+            default:
+                return lwjsonERRJSON;
+        }
+    }
+    return res;
+}
+
+/**
+ * \brief           Append array index to current path as pointer segment
+ * \param[in,out]   ctx: Diff state
+ * \param[in]       idx: Array index
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM if path does not fit
+ */
+static lwjsonr_t
+prv_diff_push_index(lwjson_diff_ctx_t* ctx, size_t idx) {
+    char tmp[24];
+    size_t len = 0;
+
+    do {
+        tmp[len++] = (char)('0' + idx % 10);
+        idx /= 10;
+    } while (idx > 0);
+    if (ctx->path_len + 1 + len > sizeof(ctx->path)) {
+        return lwjsonERRMEM;
+    }
+    ctx->path[ctx->path_len++] = '/';
+    while (len > 0) {
+        ctx->path[ctx->path_len++] = tmp[--len];
+    }
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Number of positions remembered at once when removed elements are reported in reverse order
+ */
+#define LWJSON_DIFF_REVERSE_MARKS           32
+
+/**
+ * \brief           Report removed array elements from the last one to the first one
+ *
+ * Elements are linked forward only. Every `step`-th element is remembered on stack,
+ * then the parts between remembered elements are reported from the last part,
+ * so that all elements are walked only once per recursion level.
+ *
+ * \param[in,out]   ctx: Diff state, path points to the array
+ * \param[in]       first: First removed element
+ * \param[in]       idx: Index of `first` in the array
+ * \param[in]       cnt: Number of removed elements
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_diff_removed(lwjson_diff_ctx_t* ctx, const lwjson_token_t* first, size_t idx, size_t cnt) {
+    const lwjson_token_t* marks[LWJSON_DIFF_REVERSE_MARKS];
+    const size_t path_len = ctx->path_len;
+    const size_t step = (cnt + LWJSON_DIFF_REVERSE_MARKS - 1) / LWJSON_DIFF_REVERSE_MARKS;
+    const lwjson_token_t* t = first;
+    lwjsonr_t res = lwjsonOK;
+    size_t n = 0;
+
+    for (; n * step < cnt; ++n) {
+        marks[n] = t;
+        for (size_t i = 0; i < step && t != NULL; ++i, t = t->next) {}
+    }
+    while (n > 0 && res == lwjsonOK) {
+        const size_t start = --n * step;
+
+        if (step > 1) {
+            res = prv_diff_removed(ctx, marks[n], idx + start, cnt - start < step ? cnt - start : step);
+        } else if ((res = prv_diff_push_index(ctx, idx + start)) == lwjsonOK) {
+            res = ctx->fn(LWJSON_DIFF_REMOVED, ctx->path, ctx->path_len, marks[n], NULL, ctx->arg);
+        }
+        ctx->path_len = path_len;
+    }
+    return res;
+}
+
+/**
+ * \brief           Compare two values and report differences
+ * \param[in,out]   ctx: Diff state, path points to both values
+ * \param[in]       a: Value in first document
+ * \param[in]       b: Value in second document
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_diff(lwjson_diff_ctx_t* ctx, const lwjson_token_t* a, const lwjson_token_t* b) {
+    const size_t path_len = ctx->path_len;
+    const lwjson_token_t *ca, *cb;
+    lwjsonr_t res = lwjsonOK;
+    size_t idx = 0;
+
+    if (prv_raw_equal(a, b)) {
+        return lwjsonOK;                        /* Skip identical subtree without walking it */
+    }
+    if (a->type != b->type || (a->type != LWJSON_TYPE_OBJECT && a->type != LWJSON_TYPE_ARRAY)) {
+        return prv_equal(&ctx->store, a, b) ? lwjsonOK : ctx->fn(LWJSON_DIFF_CHANGED, ctx->path, ctx->path_len, a, b, ctx->arg);
+    }
+    if (a->type == LWJSON_TYPE_OBJECT) {
+        lwjson_member_table_t tbl;
+
+        prv_table_build(&tbl, &ctx->store, b);
+        for (ca = a->u.first_child; ca != NULL && res == lwjsonOK; ca = ca->next) {
+            if ((res = prv_diff_push_name(ctx, ca->token_name, ca->token_name_len)) != lwjsonOK) {
+                break;
+            }
+            cb = prv_table_get(&tbl, b, ca->token_name, ca->token_name_len);
+            if (cb == NULL) {
+                res = ctx->fn(LWJSON_DIFF_REMOVED, ctx->path, ctx->path_len, ca, NULL, ctx->arg);
+            } else {
+                res = prv_diff(ctx, ca, cb);
+            }
+            ctx->path_len = path_len;
+        }
+        for (cb = b->u.first_child; cb != NULL && res == lwjsonOK; cb = cb->next) {
+            if (prv_table_matched(&tbl, cb, a)) {
+                continue;
+            }
+            if ((res = prv_diff_push_name(ctx, cb->token_name, cb->token_name_len)) == lwjsonOK) {
+                res = ctx->fn(LWJSON_DIFF_ADDED, ctx->path, ctx->path_len, NULL, cb, ctx->arg);
+            }
+            ctx->path_len = path_len;
+        }
+        prv_table_release(&tbl);
+        return res;
+    }
+
+    /* Arrays are compared by index */
+    for (ca = a->u.first_child, cb = b->u.first_child; ca != NULL && cb != NULL && res == lwjsonOK;
+         ca = ca->next, cb = cb->next, ++idx) {
+        if ((res = prv_diff_push_index(ctx, idx)) == lwjsonOK) {
+            res = prv_diff(ctx, ca, cb);
+        }
+        ctx->path_len = path_len;
+    }
+    for (; cb != NULL && res == lwjsonOK; cb = cb->next, ++idx) {
+        if ((res = prv_diff_push_index(ctx, idx)) == lwjsonOK) {
+            res = ctx->fn(LWJSON_DIFF_ADDED, ctx->path, ctx->path_len, NULL, cb, ctx->arg);
+        }
+        ctx->path_len = path_len;
+    }
+    if (ca != NULL && res == lwjsonOK) {
+        /* Trailing elements are reported from the last one, so that indexes stay valid when applied in order */
+        size_t cnt = 0;
+
+        for (const lwjson_token_t* t = ca; t != NULL; t = t->next, ++cnt) {}
+        res = prv_diff_removed(ctx, ca, idx, cnt);
+    }
+    return res;
+}
+
+/**
+ * \brief           Compare two parsed documents and report differences
+ *
+ * Object members are matched by name with hash table lookup, array elements by index.
+ * Numbers are compared by value, strings and names as they are in input text.
+ * With \ref LWJSON_CFG_TOKEN_SPAN enabled, subtrees with identical input text
+ * are skipped with single `memcmp` before walking their children.
+ *
+ * Changed containers of the same type are walked and only differences inside are reported.
+ * Trailing array elements removed are reported in descending index order.
+ * Member names in reported path are decoded from JSON escape sequences before they are escaped as per RFC 6901.
+ *
+ * \note            Function is thread-safe, documents are not modified
+ * \param[in]       a: First parsed document
+ * \param[in]       b: Second parsed document
+ * \param[in]       fn: Callback function called for every difference
+ * \param[in]       arg: User argument passed to callback
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM if path does not fit
+ *                      \ref LWJSON_CFG_DIFF_PATH_LEN, \ref lwjsonERRJSON for invalid escape sequence in name,
+ *                      value returned by callback when it stops the diff
+ */
+lwjsonr_t
+lwjson_diff(const lwjson_doc_t* a, const lwjson_doc_t* b, lwjson_diff_fn fn, void* arg) {
+    lwjson_diff_ctx_t ctx;
+
+    if (a == NULL || b == NULL || fn == NULL || a->root == NULL || b->root == NULL) {
+        return lwjsonERR;
+    }
+    ctx.path_len = 0;
+    ctx.fn = fn;
+    ctx.arg = arg;
+    ctx.store.used = 0;
+    return prv_diff(&ctx, a->root, b->root);
+}
+
+/**
+ * \brief           Write one difference as RFC 6902 operation object
+ * \param[in]       op: Difference type
+ * \param[in]       path: JSON pointer of the value
+ * \param[in]       path_len: Length of path
+ * \param[in]       a: Value in first document
+ * \param[in]       b: Value in second document
+ * \param[in]       arg: Writer instance
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_diff_write_op(lwjson_diff_op_t op, const char* path, size_t path_len, const lwjson_token_t* a,
+                  const lwjson_token_t* b, void* arg) {
+    lwjson_writer_t* w = arg;
+
+    (void)a;
+    lwjson_writer_begin_object(w);
+    lwjson_writer_key(w, "op", 2);
+    if (op == LWJSON_DIFF_ADDED) {
+        lwjson_writer_string(w, "add", 3);
+    } else if (op == LWJSON_DIFF_REMOVED) {
+        lwjson_writer_string(w, "remove", 6);
+    } else {
+        lwjson_writer_string(w, "replace", 7);
+    }
+
+    lwjson_writer_key(w, "path", 4);
+    lwjson_writer_string(w, path, path_len);
+    if (b != NULL) {
+        lwjson_writer_key(w, "value", 5);
+        lwjson_writer_token(w, b);
+    }
+    return lwjson_writer_end(w);
+}
+
+/**
+ * \brief           Write differences of two parsed documents as RFC 6902 JSON patch
+ *
+ * Applying written patch to first document gives document equal to the second one.
+ * See \ref lwjson_diff for comparison rules.
+ *
+ * \param[in]       a: First parsed document
+ * \param[in]       b: Second parsed document
+ * \param[in,out]   w: Writer instance to write patch array to
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_diff_write_patch(const lwjson_doc_t* a, const lwjson_doc_t* b, lwjson_writer_t* w) {
+    lwjsonr_t res;
+
+    if (w == NULL) {
+        return lwjsonERR;
+    }
+    lwjson_writer_begin_array(w);
+    if ((res = lwjson_diff(a, b, prv_diff_write_op, w)) != lwjsonOK) {
+        return res;
+    }
+    return lwjson_writer_end(w);
+}
+
+#if LWJSON_CFG_TOKEN_SPAN || __DOXYGEN__
+
+/**
+ * \brief           Get start of object member or array element, including member name
+ * \param[in]       t: Token to get start for
+ * \return          Pointer to first character
+ */
+static const char*
+prv_member_start(const lwjson_token_t* t) {
+    return t->token_name != NULL ? t->token_name - 1 : t->token_raw;
+}
+
+/**
+ * \brief           Get end of token value text
+ * \param[in]       t: Token to get end for
+ * \return          Pointer to character after the value
+ */
+static const char*
+prv_member_end(const lwjson_token_t* t) {
+    return t->token_raw + t->token_raw_len;
+}
+
+/**
+ * \brief           Add new entry to patch list
+ * \param[in,out]   patch: Patch instance
+ * \param[in]       op: Operation type
+ * \param[in]       token: Target token
+ * \return          Pointer to new entry, `NULL` if there is no more space
+ */
+static lwjson_patch_entry_t*
+prv_add_entry(lwjson_patch_t* patch, lwjson_patch_op_t op, const lwjson_token_t* token) {
+    lwjson_patch_entry_t* e;
+
+    if (patch->entries_used >= patch->entries_len) {
+        return NULL;
+    }
+    e = &patch->entries[patch->entries_used];
+    memset(e, 0x00, sizeof(*e));
+    e->op = op;
+    e->token = token;
+    e->seq = patch->entries_used++;
+    return e;
+}
+
+/**
+ * \brief           Entry order function prototype
+ * \param[in]       a: First entry
+ * \param[in]       b: Second entry
+ * \return          `1` if `a` goes before `b`, `0` otherwise
+ */
+typedef uint8_t (*prv_entry_less_fn)(const lwjson_patch_entry_t* a, const lwjson_patch_entry_t* b);
+
+/**
+ * \brief           Sort entries in place with heap sort, without extra memory
+ * \param[in,out]   entries: Entries to sort
+ * \param[in]       cnt: Number of entries
+ * \param[in]       less: Order function, it must not consider any two entries equal
+ */
+static void
+prv_entries_sort(lwjson_patch_entry_t* entries, size_t cnt, prv_entry_less_fn less) {
+    lwjson_patch_entry_t tmp;
+
+    for (size_t n = cnt, i = cnt / 2; n > 1;) {
+        size_t parent, child;
+
+        /* Build heap first, then move largest entry to the end one by one */
+        if (i > 0) {
+            parent = --i;
+        } else {
+            --n;
+            tmp = entries[0];
+            entries[0] = entries[n];
+            entries[n] = tmp;
+            parent = 0;
+        }
+        while ((child = 2 * parent + 1) < n) {
+            if (child + 1 < n && less(&entries[child], &entries[child + 1])) {
+                ++child;
+            }
+            if (!less(&entries[parent], &entries[child])) {
+                break;
+            }
+            tmp = entries[parent];
+            entries[parent] = entries[child];
+            entries[child] = tmp;
+            parent = child;
+        }
+    }
+}
+
+/**
+ * \brief           Order removals first, grouped by parent and then by token, see \ref prv_entry_less_fn
+ */
+static uint8_t
+prv_entry_is_removal_before(const lwjson_patch_entry_t* a, const lwjson_patch_entry_t* b) {
+    uintptr_t pa, pb;
+
+    if ((a->op == LWJSON_PATCH_REMOVE) != (b->op == LWJSON_PATCH_REMOVE)) {
+        return a->op == LWJSON_PATCH_REMOVE;
+    }
+    if (a->op == LWJSON_PATCH_REMOVE) {
+        if ((pa = (uintptr_t)a->token->parent) != (pb = (uintptr_t)b->token->parent)) {
+            return pa < pb;
+        }
+        if ((pa = (uintptr_t)a->token) != (pb = (uintptr_t)b->token)) {
+            return pa < pb;
+        }
+    }
+    return a->seq < b->seq;
+}
+
+/**
+ * \brief           Find first removal entry of given parent, or of given token when it is not `NULL`
+ * \param[in]       patch: Patch instance, with removals sorted by \ref prv_entry_is_removal_before
+ * \param[in]       cnt: Number of removal entries
+ * \param[in]       parent: Parent token
+ * \param[in]       t: Removed token, `NULL` to find first removal of any child of `parent`
+ * \return          Index of found entry, `cnt` if not found
+ */
+static size_t
+prv_removal_find(const lwjson_patch_t* patch, size_t cnt, const lwjson_token_t* parent, const lwjson_token_t* t) {
+    size_t lo = 0, hi = cnt;
+
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const lwjson_patch_entry_t* e = &patch->entries[mid];
+
+        if ((uintptr_t)e->token->parent < (uintptr_t)parent
+            || (e->token->parent == parent && t != NULL && (uintptr_t)e->token < (uintptr_t)t)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < cnt && patch->entries[lo].token->parent == parent && (t == NULL || patch->entries[lo].token == t)) {
+        return lo;
+    }
+    return cnt;
+}
+
+/**
+ * \brief           Set input byte range of all removal entries of token
+ * \param[in,out]   patch: Patch instance
+ * \param[in]       idx: Index of first removal entry of the token
+ * \param[in]       cnt: Number of removal entries
+ * \param[in]       start: Start of removed range
+ * \param[in]       end: End of removed range
+ */
+static void
+prv_removal_set_range(lwjson_patch_t* patch, size_t idx, size_t cnt, const char* start, const char* end) {
+    const lwjson_token_t* t = patch->entries[idx].token;
+
+    for (; idx < cnt && patch->entries[idx].token == t; ++idx) {
+        patch->entries[idx].start = start;
+        patch->entries[idx].end = end;
+    }
+}
+
+/**
+ * \brief           Calculate input byte ranges of removals of children of one parent
+ *
+ * Removed member takes its separator with it: the one before the next surviving sibling
+ * or, for the last surviving position, the one after previous surviving sibling.
+ * Children are walked once, every child is looked up in sorted removals.
+ * Comma flag of removal entries, not used otherwise, is set when parent keeps any child.
+ *
+ * \param[in,out]   patch: Patch instance, with removals sorted by \ref prv_entry_is_removal_before
+ * \param[in]       first: Index of first removal entry of the parent
+ * \param[in]       cnt: Number of removal entries
+ * \return          Index of first entry after removals of the parent
+ */
+static size_t
+prv_removal_ranges(lwjson_patch_t* patch, size_t first, size_t cnt) {
+    const lwjson_token_t* parent = patch->entries[first].token->parent;
+    const lwjson_token_t *c, *run = NULL, *prev = NULL, *last = NULL;
+    size_t idx, end;
+
+    for (end = first; end < cnt && patch->entries[end].token->parent == parent; ++end) {}
+    for (c = parent->u.first_child; c != NULL; c = c->next) {
+        if (prv_removal_find(patch, end, parent, c) != end) {
+            run = run == NULL ? c : run;        /* Start or continue run of removed siblings */
+            last = c;
+            continue;
+        }
+        /* Removed run takes separators up to this surviving sibling */
+        for (; run != NULL && run != c; run = run->next) {
+            prv_removal_set_range(patch, prv_removal_find(patch, end, parent, run), end, prv_member_start(run),
+                                  prv_member_start(c));
+        }
+        run = NULL;
+        prev = c;
+    }
+    /* Trailing run takes separator after previous surviving sibling, or all children when there is none */
+    for (c = run; c != NULL; c = c->next) {
+        idx = prv_removal_find(patch, end, parent, c);
+        if (prev != NULL) {
+            prv_removal_set_range(patch, idx, end, prv_member_end(prev), prv_member_end(c));
+        } else {
+            prv_removal_set_range(patch, idx, end, prv_member_start(parent->u.first_child), prv_member_end(last));
+        }
+    }
+    for (idx = first; idx < end; ++idx) {
+        patch->entries[idx].comma = prev != NULL;
+    }
+    return end;
+}
+
+/**
+ * \brief           Calculate input byte range replaced by set or insert entry
+ * \param[in]       patch: Patch instance, with removals sorted by \ref prv_entry_is_removal_before
+ * \param[in]       cnt: Number of removal entries
+ * \param[in,out]   e: Entry to calculate range for
+ */
+static void
+prv_entry_range(const lwjson_patch_t* patch, size_t cnt, lwjson_patch_entry_t* e) {
+    const lwjson_token_t* t = e->token;
+    size_t idx;
+
+    if (e->op == LWJSON_PATCH_SET) {
+        e->start = t->token_raw;
+        e->end = prv_member_end(t);
+    } else if (e->before != NULL) {
+        /* New member is added before existing one and gets separator after it */
+        e->start = e->end = prv_member_start(e->before);
+        e->comma = 1;
+    } else {
+        /* New member is added just before closing bracket, after any surviving child */
+        e->start = e->end = prv_member_end(t) - 1;
+        idx = prv_removal_find(patch, cnt, t, NULL);
+        e->comma = idx != cnt ? patch->entries[idx].comma : t->u.first_child != NULL;
+    }
+}
+
+/**
+ * \brief           Order entries by position in input, see \ref prv_entry_less_fn
+ *
+ * On the same position, insertion goes first and removal before replacement,
+ * so removal hides modifications inside removed range. Insertions keep order they were added in.
+ */
+static uint8_t
+prv_entry_is_before(const lwjson_patch_entry_t* a, const lwjson_patch_entry_t* b) {
+    static const uint8_t rank[] = {
+        [LWJSON_PATCH_INSERT] = 0,
+        [LWJSON_PATCH_REMOVE] = 1,
+        [LWJSON_PATCH_SET] = 2,
+    };
+    if (a->start != b->start) {
+        return a->start < b->start;
+    }
+    if (rank[a->op] != rank[b->op]) {
+        return rank[a->op] < rank[b->op];
+    }
+    return a->seq < b->seq;
+}
+
+/**
+ * \brief           Setup patch instance for parsed JSON
+ * \param[out]      patch: Patch instance
+ * \param[in]       lw: JSON instance with parsed JSON string. Input string must stay valid until output is emitted.
+ *                      Data parsed from CBOR or MessagePack has no text to splice and is rejected
+ * \param[in]       entries: Array of entries to store modifications to
+ * \param[in]       entries_len: Number of entries in array
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_patch_init(lwjson_patch_t* patch, const lwjson_t* lw, lwjson_patch_entry_t* entries, size_t entries_len) {
+    if (patch == NULL || lw == NULL || !lw->flags.parsed || lw->first_token.token_raw == NULL || entries == NULL) {
+        return lwjsonERR;
+    }
+    memset(patch, 0x00, sizeof(*patch));
+    patch->lw = lw;
+    patch->entries = entries;
+    patch->entries_len = entries_len;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Replace token value
+ * \param[in,out]   patch: Patch instance
+ * \param[in]       token: Token to replace value for. Member name stays the same
+ * \param[in]       value: New value as valid JSON text. It is not copied and must stay valid until output is emitted
+ * \param[in]       value_len: Length of value in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_patch_set(lwjson_patch_t* patch, const lwjson_token_t* token, const char* value, size_t value_len) {
+    lwjson_patch_entry_t* e;
+
+    if (patch == NULL || token == NULL || value == NULL) {
+        return lwjsonERR;
+    }
+    if ((e = prv_add_entry(patch, LWJSON_PATCH_SET, token)) == NULL) {
+        return lwjsonERRMEM;
+    }
+    e->value = value;
+    e->value_len = value_len;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Remove object member or array element
+ * \param[in,out]   patch: Patch instance
+ * \param[in]       token: Token to remove. Top token cannot be removed
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_patch_remove(lwjson_patch_t* patch, const lwjson_token_t* token) {
+    if (patch == NULL || token == NULL || token->parent == NULL) {
+        return lwjsonERR;
+    }
+    return prv_add_entry(patch, LWJSON_PATCH_REMOVE, token) != NULL ? lwjsonOK : lwjsonERRMEM;
+}
+
+/**
+ * \brief           Add new member at the end of object or array
+ * \param[in,out]   patch: Patch instance
+ * \param[in]       parent: Token of \ref LWJSON_TYPE_OBJECT or \ref LWJSON_TYPE_ARRAY type
+ * \param[in]       name: Member name without quotes, already escaped. Must be `NULL` for arrays
+ * \param[in]       name_len: Length of name in units of bytes
+ * \param[in]       value: Value as valid JSON text. It is not copied and must stay valid until output is emitted
+ * \param[in]       value_len: Length of value in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_patch_insert(lwjson_patch_t* patch, const lwjson_token_t* parent, const char* name, size_t name_len,
+                    const char* value, size_t value_len) {
+    lwjson_patch_entry_t* e;
+
+    if (patch == NULL || parent == NULL || value == NULL
+        || (parent->type == LWJSON_TYPE_OBJECT) != (name != NULL)
+        || (parent->type != LWJSON_TYPE_OBJECT && parent->type != LWJSON_TYPE_ARRAY)) {
+        return lwjsonERR;
+    }
+    if ((e = prv_add_entry(patch, LWJSON_PATCH_INSERT, parent)) == NULL) {
+        return lwjsonERRMEM;
+    }
+    e->name = name;
+    e->name_len = name_len;
+    e->value = value;
+    e->value_len = value_len;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Add new member before existing member of object or array
+ * \param[in,out]   patch: Patch instance
+ * \param[in]       before: Existing member to insert new one before. It must not be removed
+ * \param[in]       name: Member name without quotes, already escaped. Must be `NULL` for arrays
+ * \param[in]       name_len: Length of name in units of bytes
+ * \param[in]       value: Value as valid JSON text. It is not copied and must stay valid until output is emitted
+ * \param[in]       value_len: Length of value in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_patch_insert_before(lwjson_patch_t* patch, const lwjson_token_t* before, const char* name, size_t name_len,
+                           const char* value, size_t value_len) {
+    lwjsonr_t res;
+
+    if (before == NULL || before->parent == NULL) {
+        return lwjsonERR;
+    }
+    if ((res = lwjson_patch_insert(patch, before->parent, name, name_len, value, value_len)) == lwjsonOK) {
+        patch->entries[patch->entries_used - 1].before = before;
+    }
+    return res;
+}
+
+/**
+ * \brief           Write modified JSON to writer
+ *
+ * Input text between modifications is copied as-is, in as few copy operations as possible.
+ * Entries are sorted by position in place, new modifications can be added after the call.
+ * Time is `O(n log n)` to number of entries, plus one walk over children of every container with removed members.
+ *
+ * \param[in,out]   patch: Patch instance
+ * \param[in,out]   w: Writer instance
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_patch_emit(lwjson_patch_t* patch, lwjson_writer_t* w) {
+    const lwjson_token_t* root;
+    const char* cursor;
+    size_t cnt;
+
+    if (patch == NULL || w == NULL) {
+        return lwjsonERR;
+    }
+    root = lwjson_get_first_token(patch->lw);
+
+    /* Group removals by parent to calculate their ranges with one walk over children of every parent */
+    prv_entries_sort(patch->entries, patch->entries_used, prv_entry_is_removal_before);
+    for (cnt = 0; cnt < patch->entries_used && patch->entries[cnt].op == LWJSON_PATCH_REMOVE; ++cnt) {}
+    for (size_t i = 0; i < cnt;) {
+        i = prv_removal_ranges(patch, i, cnt);
+    }
+    for (size_t i = cnt; i < patch->entries_used; ++i) {
+        prv_entry_range(patch, cnt, &patch->entries[i]);
+    }
+
+    /* Sort by position, insertions after the first one at the end of the same container need separator */
+    prv_entries_sort(patch->entries, patch->entries_used, prv_entry_is_before);
+    for (size_t i = 1; i < patch->entries_used; ++i) {
+        const lwjson_patch_entry_t* p = &patch->entries[i - 1];
+        lwjson_patch_entry_t* e = &patch->entries[i];
+
+        if (e->op == LWJSON_PATCH_INSERT && e->before == NULL && p->op == LWJSON_PATCH_INSERT && p->before == NULL
+            && p->token == e->token) {
+            e->comma = 1;
+        }
+    }
+
+    /* Copy untouched ranges and splice modifications in between */
+    cursor = root->token_raw;
+    for (size_t i = 0; i < patch->entries_used; ++i) {
+        const lwjson_patch_entry_t* e = &patch->entries[i];
+
+        if (e->start < cursor) {
+            /* Entry is inside already replaced or removed range */
+            if (e->op == LWJSON_PATCH_REMOVE && e->end > cursor) {
+                cursor = e->end;
+            }
+            continue;
+        }
+        lwjson_writer_bytes(w, cursor, (size_t)(e->start - cursor));
+        if (e->op == LWJSON_PATCH_INSERT) {
+            if (e->comma && e->before == NULL) {
+                lwjson_writer_bytes(w, ",", 1);
+            }
+            if (e->name != NULL) {
+                lwjson_writer_bytes(w, "\"", 1);
+                lwjson_writer_bytes(w, e->name, e->name_len);
+                lwjson_writer_bytes(w, "\":", 2);
+            }
+        }
+        if (e->op != LWJSON_PATCH_REMOVE) {
+            lwjson_writer_bytes(w, e->value, e->value_len);
+        }
+        if (e->op == LWJSON_PATCH_INSERT && e->before != NULL) {
+            lwjson_writer_bytes(w, ",", 1);
+        }
+        cursor = e->end;
+    }
+    return lwjson_writer_bytes(w, cursor, (size_t)(prv_member_end(root) - cursor));
+}
+
+
+/**
+ * \brief           Compare JSON pointer segment with member name
+ * \param[in]       t: Member token
+ * \param[in]       seg: Pointer segment with `~0` and `~1` escape sequences
+ * \param[in]       seg_len: Length of segment
+ * \return          `1` if equal, `0` otherwise
+ */
+static uint8_t
+prv_pointer_seg_equal(const lwjson_token_t* t, const char* seg, size_t seg_len) {
+    size_t i = 0, j = 0;
+
+    for (; i < seg_len && j < t->token_name_len; ++i, ++j) {
+        char ch = seg[i];
+        if (ch == '~' && i + 1 < seg_len) {
+            ch = seg[++i] == '1' ? '/' : '~';
+        }
+        if (ch != t->token_name[j]) {
+            return 0;
+        }
+    }
+    return i == seg_len && j == t->token_name_len;
+}
+
+/**
+ * \brief           Parse array index from JSON pointer segment
+ * \param[in]       seg: Pointer segment
+ * \param[in]       seg_len: Length of segment
+ * \param[out]      idx: Parsed index
+ * \return          `1` on success, `0` if segment is not valid index
+ */
+static uint8_t
+prv_pointer_seg_index(const char* seg, size_t seg_len, size_t* idx) {
+    if (seg_len == 0 || (seg_len > 1 && seg[0] == '0')) {
+        return 0;
+    }
+    *idx = 0;
+    for (size_t i = 0; i < seg_len; ++i) {
+        if (seg[i] < '0' || seg[i] > '9') {
+            return 0;
+        }
+        *idx = *idx * 10 + (size_t)(seg[i] - '0');
+    }
+    return 1;
+}
+
+/**
+ * \brief           Resolve JSON pointer as per RFC 6901
+ * \param[in]       root: Top token
+ * \param[in]       ptr: JSON pointer
+ * \param[in]       len: Length of pointer
+ * \param[in]       skip: Token that is treated as already removed, `NULL` if none
+ * \param[out]      parent: Parent of the last segment, `NULL` if parent does not exist
+ * \param[out]      seg: Last segment
+ * \param[out]      seg_len: Length of last segment
+ * \return          Token at the pointer, `NULL` if it does not exist
+ */
+static const lwjson_token_t*
+prv_pointer_find(const lwjson_token_t* root, const char* ptr, size_t len, const lwjson_token_t* skip,
+                 const lwjson_token_t** parent, const char** seg, size_t* seg_len) {
+    const lwjson_token_t* t = root;
+    const char* end = ptr + len;
+
+    *parent = NULL;
+    *seg = ptr;
+    *seg_len = 0;
+    if (len > 0 && *ptr != '/') {
+        return NULL;
+    }
+    while (ptr < end) {
+        const char* s = ++ptr;
+        size_t s_len, idx;
+
+        for (; ptr < end && *ptr != '/'; ++ptr) {}
+        s_len = (size_t)(ptr - s);
+        if (t == NULL) {
+            *parent = NULL;                     /* Missing intermediate value */
+            return NULL;
+        }
+        *parent = t;
+        *seg = s;
+        *seg_len = s_len;
+        if (t->type == LWJSON_TYPE_OBJECT) {
+            for (t = t->u.first_child; t != NULL && (t == skip || !prv_pointer_seg_equal(t, s, s_len)); t = t->next) {}
+        } else if (t->type == LWJSON_TYPE_ARRAY && prv_pointer_seg_index(s, s_len, &idx)) {
+            for (t = t->u.first_child; t != NULL && (t == skip || idx > 0); t = t->next) {
+                idx -= t != skip;
+            }
+        } else {
+            t = NULL;
+        }
+    }
+    return t;
+}
+
+/**
+ * \brief           Get object member by name
+ * \param[in]       obj: Object token
+ * \param[in]       name: `NULL` terminated member name
+ * \return          Member token, `NULL` if not found
+ */
+static const lwjson_token_t*
+prv_object_get(const lwjson_token_t* obj, const char* name) {
+    size_t len = strlen(name);
+
+    for (const lwjson_token_t* t = obj->u.first_child; t != NULL; t = t->next) {
+        if (prv_name_equal(t, name, len)) {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Part of current document that JSON patch operation reads or modifies
+ */
+typedef struct {
+    const lwjson_token_t* token;                /*!< Value, or container that gets new member */
+    const lwjson_token_t* before;               /*!< Array element new one is inserted before, `NULL` if none */
+    const char* name;                           /*!< Name of new object member */
+    size_t name_len;                            /*!< Length of name */
+    uint8_t insert;                             /*!< Set when new member is added to `token` container */
+    uint8_t append;                             /*!< Set when element is appended with `-` index */
+} lwjson_json_patch_access_t;
+
+/**
+ * \brief           Check if token is the same as or ancestor of other token
+ * \param[in]       a: Possible ancestor
+ * \param[in]       t: Token to check
+ * \return          `1` if `a` is `t` or its ancestor, `0` otherwise
+ */
+static uint8_t
+prv_is_ancestor(const lwjson_token_t* a, const lwjson_token_t* t) {
+    for (; t != NULL; t = t->parent) {
+        if (t == a) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief           Check if access depends on modification of a container's member list
+ * \param[in]       acc: Access to check
+ * \param[in]       p: Container with inserted or removed member
+ * \param[in]       e: Insert or remove entry
+ * \return          `1` if access cannot be recorded in the same pass as the entry, `0` otherwise
+ */
+static uint8_t
+prv_access_on_members(const lwjson_json_patch_access_t* acc, const lwjson_token_t* p, const lwjson_patch_entry_t* e) {
+    if (!acc->insert || acc->token != p) {
+        /* Value that contains the container, or path through array with moved indexes */
+        return prv_is_ancestor(acc->token, p) || (p->type == LWJSON_TYPE_ARRAY && prv_is_ancestor(p, acc->token));
+    }
+    if (p->type == LWJSON_TYPE_OBJECT) {
+        return e->op == LWJSON_PATCH_INSERT && e->name_len == acc->name_len && !memcmp(e->name, acc->name, acc->name_len);
+    }
+    /* Only appends with `-` keep their order in one pass */
+    return !(acc->append && e->op == LWJSON_PATCH_INSERT && e->before == NULL);
+}
+
+/**
+ * \brief           Check if access depends on any modification already recorded in the pass
+ * \param[in]       patch: Patch instance with modifications of current pass
+ * \param[in]       acc: Access to check
+ * \return          `1` if document must be written and parsed again before the access, `0` otherwise
+ */
+static uint8_t
+prv_access_conflicts(const lwjson_patch_t* patch, const lwjson_json_patch_access_t* acc) {
+    for (size_t i = 0; i < patch->entries_used; ++i) {
+        const lwjson_patch_entry_t* e = &patch->entries[i];
+
+        if (e->op != LWJSON_PATCH_INSERT) {
+            /* Replaced or removed value */
+            if (prv_is_ancestor(e->token, acc->token) || (!acc->insert && prv_is_ancestor(acc->token, e->token))) {
+                return 1;
+            }
+        }
+        if (prv_access_on_members(acc, e->op == LWJSON_PATCH_INSERT ? e->token : e->token->parent, e)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief           Resolve target location of value added as `add` operation in RFC 6902
+ * \param[in]       root: Top token of current document
+ * \param[in]       path: Path string token
+ * \param[in]       skip: Token removed by the same operation, `NULL` if none
+ * \param[out]      acc: Target location
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_json_patch_target(const lwjson_token_t* root, const lwjson_token_t* path, const lwjson_token_t* skip,
+                      lwjson_json_patch_access_t* acc) {
+    const lwjson_token_t* t, *parent;
+    const char* seg;
+    size_t seg_len, idx;
+
+    memset(acc, 0x00, sizeof(*acc));
+    t = prv_pointer_find(root, path->u.str.token_value, path->u.str.token_value_len, skip, &parent, &seg, &seg_len);
+    if (t != NULL && (parent == NULL || parent->type == LWJSON_TYPE_OBJECT)) {
+        acc->token = t;                         /* Existing value is replaced */
+        return lwjsonOK;
+    }
+    if (parent == NULL) {
+        return lwjsonERR;
+    }
+    acc->token = parent;
+    acc->insert = 1;
+    if (parent->type == LWJSON_TYPE_OBJECT) {
+        if (memchr(seg, '~', seg_len) != NULL) {
+            return lwjsonERR;                   /* New name would need decoded copy */
+        }
+        acc->name = seg;
+        acc->name_len = seg_len;
+        return lwjsonOK;
+    }
+    if (seg_len == 1 && seg[0] == '-') {
+        acc->append = 1;
+        return lwjsonOK;
+    }
+    if (!prv_pointer_seg_index(seg, seg_len, &idx)) {
+        return lwjsonERR;
+    }
+    if ((acc->before = t) != NULL) {
+        return lwjsonOK;
+    }
+    /* Index equal to number of elements appends */
+    for (t = parent->u.first_child; t != NULL; t = t->next) {
+        if (t != skip && idx-- == 0) {
+            break;
+        }
+    }
+    return t == NULL && idx == 0 ? lwjsonOK : lwjsonERR;
+}
+
+/**
+ * \brief           Record value added to resolved target location
+ * \param[in,out]   patch: Patch instance
+ * \param[in]       acc: Target location from \ref prv_json_patch_target
+ * \param[in]       value: Value to add, as text
+ * \param[in]       value_len: Length of value
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_json_patch_add(lwjson_patch_t* patch, const lwjson_json_patch_access_t* acc, const char* value, size_t value_len) {
+    if (!acc->insert) {
+        return lwjson_patch_set(patch, acc->token, value, value_len);
+    }
+    if (acc->before != NULL) {
+        return lwjson_patch_insert_before(patch, acc->before, NULL, 0, value, value_len);
+    }
+    return lwjson_patch_insert(patch, acc->token, acc->name, acc->name_len, value, value_len);
+}
+
+/**
+ * \brief           Check if JSON pointer `path` points inside value at pointer `from`
+ * \param[in]       from: Path string token of source value
+ * \param[in]       path: Path string token of target location
+ * \return          `1` if `path` is strict descendant of `from`, `0` otherwise
+ */
+static uint8_t
+prv_pointer_is_child(const lwjson_token_t* from, const lwjson_token_t* path) {
+    size_t len = from->u.str.token_value_len;
+
+    return path->u.str.token_value_len > len && path->u.str.token_value[len] == '/'
+           && !memcmp(path->u.str.token_value, from->u.str.token_value, len);
+}
+
+/**
+ * \brief           Record one RFC 6902 operation as modifications of current document
+ *
+ * Operation is recorded only when values it reads or modifies are not modified by entries already in `patch`,
+ * otherwise nothing is recorded and \ref lwjsonEND is returned.
+ * Move resolves target location as if source value was already removed.
+ *
+ * \param[in,out]   patch: Patch instance for current document, with at least `2` free entries
+ * \param[in,out]   store: Store for member tables of `test` operation
+ * \param[in]       o: Operation object
+ * \return          \ref lwjsonOK on success, \ref lwjsonEND when current document must be written and parsed first,
+ *                      member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_json_patch_op(lwjson_patch_t* patch, lwjson_member_store_t* store, const lwjson_token_t* o) {
+    const lwjson_token_t* root = lwjson_get_first_token(patch->lw);
+    const lwjson_token_t *op, *path, *value = NULL, *from = NULL, *parent;
+    lwjson_json_patch_access_t src = {0}, acc = {0};
+    const char *seg, *name;
+    size_t seg_len, name_len;
+    lwjsonr_t res;
+
+    if (o->type != LWJSON_TYPE_OBJECT
+        || (op = prv_object_get(o, "op")) == NULL || op->type != LWJSON_TYPE_STRING
+        || (path = prv_object_get(o, "path")) == NULL || path->type != LWJSON_TYPE_STRING) {
+        return lwjsonERRJSON;
+    }
+    name = op->u.str.token_value;
+    name_len = op->u.str.token_value_len;
+    if ((name_len == 3 && !strncmp(name, "add", 3)) || (name_len == 7 && !strncmp(name, "replace", 7))
+        || (name_len == 4 && !strncmp(name, "test", 4))) {
+        if ((value = prv_object_get(o, "value")) == NULL) {
+            return lwjsonERRJSON;
+        }
+    } else if ((name_len == 4 && !strncmp(name, "move", 4)) || (name_len == 4 && !strncmp(name, "copy", 4))) {
+        if ((from = prv_object_get(o, "from")) == NULL || from->type != LWJSON_TYPE_STRING) {
+            return lwjsonERRJSON;
+        }
+        if (name[0] == 'm' && prv_pointer_is_child(from, path)) {
+            return lwjsonERR;                   /* Value cannot be moved into its own child */
+        }
+        src.token = prv_pointer_find(root, from->u.str.token_value, from->u.str.token_value_len, NULL, &parent, &seg,
+                                     &seg_len);
+        if (src.token == NULL) {
+            return lwjsonERR;
+        }
+        if (prv_access_conflicts(patch, &src)) {
+            return lwjsonEND;
+        }
+        if (name[0] == 'm' && from->u.str.token_value_len == path->u.str.token_value_len
+            && !memcmp(from->u.str.token_value, path->u.str.token_value, path->u.str.token_value_len)) {
+            return lwjsonOK;                    /* Move to the same location does nothing */
+        }
+    } else if (!(name_len == 6 && !strncmp(name, "remove", 6))) {
+        return lwjsonERRJSON;
+    }
+
+    switch (name[0]) {
+        case 'a':                               /* add */
+        case 'c':                               /* copy */
+        case 'm':                               /* move */
+            if ((res = prv_json_patch_target(root, path, name[0] == 'm' ? src.token : NULL, &acc)) != lwjsonOK) {
+                return res;
+            }
+            if (prv_access_conflicts(patch, &acc)) {
+                return lwjsonEND;
+            }
+            if (name[0] == 'm' && (res = lwjson_patch_remove(patch, src.token)) != lwjsonOK) {
+                return res;
+            }
+            if (value == NULL) {
+                value = src.token;
+            }
+            return prv_json_patch_add(patch, &acc, value->token_raw, value->token_raw_len);
+        default:                                /* remove, replace or test */
+            acc.token = prv_pointer_find(root, path->u.str.token_value, path->u.str.token_value_len, NULL, &parent,
+                                         &seg, &seg_len);
+            if (acc.token == NULL) {
+                return lwjsonERR;
+            }
+            if (prv_access_conflicts(patch, &acc)) {
+                return lwjsonEND;
+            }
+            if (name[0] == 't') {
+                return prv_equal(store, acc.token, value) ? lwjsonOK : lwjsonERR;
+            }
+            if (name[2] == 'm') {
+                return lwjson_patch_remove(patch, acc.token);
+            }
+            return lwjson_patch_set(patch, acc.token, value->token_raw, value->token_raw_len);
+    }
+}
+
+/**
+ * \brief           Write modifications of current pass to free half of working memory and parse it
+ * \param[in,out]   patch: Patch instance of current pass, set up for parsed document
+ * \param[in,out]   scratch: JSON instance to parse document to
+ * \param[in]       half: Free half of working memory
+ * \param[in]       half_len: Size of half in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_json_patch_pass(lwjson_patch_t* patch, lwjson_t* scratch, char* half, size_t half_len) {
+    lwjson_writer_t out;
+    lwjsonr_t res;
+
+    if (half == NULL || half_len == 0) {
+        return lwjsonERRMEM;
+    }
+    lwjson_writer_init(&out, half, half_len, NULL, NULL);
+    if ((res = lwjson_patch_emit(patch, &out)) != lwjsonOK || (res = out.err) != lwjsonOK
+        || (res = lwjson_parse_ex(scratch, half, out.len)) != lwjsonOK) {
+        return res;
+    }
+    return lwjson_patch_init(patch, scratch, patch->entries, patch->entries_len);
+}
+
+/**
+ * \brief           Apply RFC 6902 JSON patch operations in order and write result
+ *
+ * Supported operations are `add`, `remove`, `replace`, `move`, `copy` and `test`.
+ * Every operation sees result of all previous ones. Operations are recorded as modifications of one splice pass
+ * over current document, while they do not read or modify values already modified in the pass
+ * and there is free entry, see \ref LWJSON_CFG_JSON_PATCH_ENTRIES. Next operation then starts new pass:
+ * current pass is emitted to one half of `buf` and parsed to `scratch`.
+ * Time is linear to document size for every pass, and every half of `buf` must fit any intermediate document.
+ * Patches that modify unrelated values are applied in single pass, without `buf` and `scratch`.
+ * New object member names must not contain `~` escape sequences.
+ *
+ * Operation that fails in a pass with other operations is retried in new pass.
+ * When it fails again, including failed `test`, the function returns error as per RFC 6902
+ * and nothing is written to `w`.
+ *
+ * \param[in]       lw: JSON instance with parsed target document. It is not modified
+ * \param[in]       ops: Parsed JSON patch document, array of operation objects. Values are copied as text,
+ *                      therefore it must be parsed from JSON text
+ * \param[in,out]   scratch: JSON instance for intermediate documents, other than `lw`. May be `NULL`
+ *                      when no operation depends on previous ones
+ * \param[in]       buf: Working memory for intermediate documents. May be `NULL` when `scratch` is `NULL`
+ * \param[in]       buf_len: Length of working memory in units of bytes
+ * \param[in,out]   w: Writer instance to write patched document to
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM if intermediate document is needed and does not fit
+ *                      to half of `buf` or to tokens of `scratch`, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_json_patch_apply(const lwjson_t* lw, const lwjson_doc_t* ops, lwjson_t* scratch, char* buf, size_t buf_len,
+                        lwjson_writer_t* w) {
+    lwjson_patch_entry_t entries[LWJSON_CFG_JSON_PATCH_ENTRIES];
+    lwjson_member_store_t store;
+    lwjson_patch_t patch;
+    lwjsonr_t res;
+    char* half = buf;
+
+    if (lw == NULL || !lw->flags.parsed || ops == NULL || ops->root == NULL || ops->root->type != LWJSON_TYPE_ARRAY
+        || ops->root->token_raw == NULL || scratch == lw || w == NULL) {
+        return lwjsonERR;
+    }
+    if (scratch == NULL || buf == NULL) {
+        half = NULL;
+        buf_len = 0;
+    }
+    store.used = 0;
+    lwjson_patch_init(&patch, lw, entries, LWJSON_ARRAYSIZE(entries));
+    for (const lwjson_token_t* o = ops->root->u.first_child; o != NULL; o = o->next) {
+        size_t used = patch.entries_used;
+
+        res = used + 2 > patch.entries_len ? lwjsonEND : prv_json_patch_op(&patch, &store, o);
+        if (res != lwjsonOK && used > 0) {
+            /*
+             * Operation may depend on previous ones, for example on just added member.
+             * Start new pass on document with all previous operations, in the other half of memory
+             */
+            patch.entries_used = used;
+            if ((res = prv_json_patch_pass(&patch, scratch, half, buf_len / 2)) != lwjsonOK) {
+                return res;
+            }
+            half = half == buf ? &buf[buf_len / 2] : buf;
+            res = prv_json_patch_op(&patch, &store, o);
+        }
+        if (res != lwjsonOK) {
+            return res;
+        }
+    }
+    return lwjson_patch_emit(&patch, w);
+}
+
+#endif /* LWJSON_CFG_TOKEN_SPAN || __DOXYGEN__ */
@@ -0,0 +1,217 @@
+/**
+ * \file            lwjson_pool.c
+ * \brief           Pool of parser instances for concurrent use
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwJSON - Lightweight JSON format parser.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <string.h>
+#include "lwjson/lwjson.h"
+
+#if LWJSON_CFG_POOL || __DOXYGEN__
+
+/**
+ * \brief           Thread local storage class of per-thread cache
+ *
+ * Define it in compiler flags or options file for compiler not listed here.
+ */
+#ifndef LWJSON_THREAD_LOCAL
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define LWJSON_THREAD_LOCAL                 _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+#define LWJSON_THREAD_LOCAL                 __thread
+#elif defined(_MSC_VER)
+#define LWJSON_THREAD_LOCAL                 __declspec(thread)
+#else
+#error "LWJSON_CFG_POOL requires thread local storage, define LWJSON_THREAD_LOCAL for this compiler"
+#endif
+#endif /* LWJSON_THREAD_LOCAL */
+
+/**
+ * \brief           Per-thread cache of released items
+ */
+static LWJSON_THREAD_LOCAL struct {
+    lwjson_pool_t* pool;                        /*!< Pool item belongs to, `NULL` for empty entry */
+    lwjson_pool_item_t* item;                   /*!< Cached item */
+} prv_cache[LWJSON_CFG_POOL_CACHE];
+
+/**
+ * \brief           Push item to shared free stack
+ * \param[in,out]   pool: Pool instance
+ * \param[in]       item: Item to push
+ */
+static void
+prv_push(lwjson_pool_t* pool, lwjson_pool_item_t* item) {
+    uint64_t head = __atomic_load_n(&pool->head, __ATOMIC_RELAXED), next;
+    uint32_t idx = (uint32_t)(item - pool->items) + 1;
+
+    do {
+        __atomic_store_n(&item->next, (uint32_t)head, __ATOMIC_RELAXED);
+        next = ((head >> 32) + 1) << 32 | idx;
+    } while (!__atomic_compare_exchange_n(&pool->head, &head, next, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * \brief           Pop item from shared free stack
+ *
+ * Change counter in upper half of head prevents ABA problem, when item is popped
+ * and pushed back by other threads between load and compare-exchange.
+ *
+ * \param[in,out]   pool: Pool instance
+ * \return          Item on success, `NULL` if stack is empty
+ */
+static lwjson_pool_item_t*
+prv_pop(lwjson_pool_t* pool) {
+    uint64_t head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE), next;
+    lwjson_pool_item_t* item;
+
+    do {
+        if ((uint32_t)head == 0) {
+            return NULL;
+        }
+        item = &pool->items[(uint32_t)head - 1];
+        next = ((head >> 32) + 1) << 32 | __atomic_load_n(&item->next, __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&pool->head, &head, next, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+    return item;
+}
+
+/**
+ * \brief           Initialize pool of parser instances
+ *
+ * Every item gets its own slice of `tokens_per_item` tokens from token array.
+ *
+ * \param[out]      pool: Pool instance
+ * \param[in]       items: Array of items, each on its own cache line
+ * \param[in]       items_len: Number of items
+ * \param[in]       tokens: Token array with `items_len * tokens_per_item` tokens
+ * \param[in]       tokens_per_item: Number of tokens for every parser instance
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_pool_init(lwjson_pool_t* pool, lwjson_pool_item_t* items, size_t items_len, lwjson_token_t* tokens,
+                 size_t tokens_per_item) {
+    if (pool == NULL || items == NULL || items_len == 0 || items_len >= UINT32_MAX || tokens == NULL
+        || tokens_per_item == 0) {
+        return lwjsonERR;
+    }
+    memset(pool, 0x00, sizeof(*pool));
+    pool->items = items;
+    pool->items_len = items_len;
+    for (size_t i = 0; i < items_len; ++i) {
+        lwjson_init(&items[i].lw, &tokens[i * tokens_per_item], tokens_per_item);
+        items[i].next = i + 1 < items_len ? (uint32_t)(i + 2) : 0;
+    }
+    pool->head = 1;                             /* First item, counter starts at zero */
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Get parser instance from pool
+ *
+ * Instance is taken from cache of calling thread first, then from shared lock-free stack.
+ *
+ * \note            Function is thread-safe
+ * \param[in,out]   pool: Pool instance
+ * \return          Reset parser instance on success, `NULL` if all instances are in use
+ */
+lwjson_t*
+lwjson_pool_acquire(lwjson_pool_t* pool) {
+    lwjson_pool_item_t* item;
+
+    if (pool == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < LWJSON_ARRAYSIZE(prv_cache); ++i) {
+        if (prv_cache[i].pool == pool) {
+            prv_cache[i].pool = NULL;
+            return &prv_cache[i].item->lw;
+        }
+    }
+    item = prv_pop(pool);
+    return item != NULL ? &item->lw : NULL;
+}
+
+/**
+ * \brief           Return parser instance to pool
+ *
+ * Instance is reset with \ref lwjson_reset, which only clears tokens used by last parsing,
+ * and kept in cache of calling thread. When cache is full, it is returned to shared stack.
+ * Cached instance can be acquired again by the same thread only. Other threads do not see it
+ * until releasing thread calls \ref lwjson_pool_flush, and may get `NULL` from \ref lwjson_pool_acquire
+ * even though instances are not in use.
+ *
+ * \note            Function is thread-safe
+ * \param[in,out]   pool: Pool instance
+ * \param[in]       lw: Parser instance from \ref lwjson_pool_acquire
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_pool_release(lwjson_pool_t* pool, lwjson_t* lw) {
+    lwjson_pool_item_t* item = (lwjson_pool_item_t*)lw;
+
+    if (pool == NULL || item < pool->items || item >= &pool->items[pool->items_len]) {
+        return lwjsonERR;
+    }
+    lwjson_reset(lw);
+    for (size_t i = 0; i < LWJSON_ARRAYSIZE(prv_cache); ++i) {
+        if (prv_cache[i].pool == NULL) {
+            prv_cache[i].pool = pool;
+            prv_cache[i].item = item;
+            return lwjsonOK;
+        }
+    }
+    prv_push(pool, item);
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Return instances cached by calling thread to shared stack
+ *
+ * Instances in cache of a thread are invisible to other threads until this function is called.
+ * Thread must call it before it exits, otherwise its cached instances are lost for the pool,
+ * and should call it when it stops using the pool for a while.
+ *
+ * \param[in,out]   pool: Pool instance
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_pool_flush(lwjson_pool_t* pool) {
+    if (pool == NULL) {
+        return lwjsonERR;
+    }
+    for (size_t i = 0; i < LWJSON_ARRAYSIZE(prv_cache); ++i) {
+        if (prv_cache[i].pool == pool) {
+            prv_cache[i].pool = NULL;
+            prv_push(pool, prv_cache[i].item);
+        }
+    }
+    return lwjsonOK;
+}
+
+#endif /* LWJSON_CFG_POOL || __DOXYGEN__ */
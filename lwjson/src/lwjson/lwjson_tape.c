@@ -0,0 +1,411 @@
+/**
+ * \file            lwjson_tape.c
+ * \brief           Relocatable token tree
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwJSON - Lightweight JSON format parser.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE                             /* memfd_create and file seals */
+#endif
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 700                       /* ftruncate with strict C standard */
+#endif
+#include <string.h>
+#include "lwjson/lwjson.h"
+
+#if LWJSON_CFG_TAPE || __DOXYGEN__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * \brief           Tape identification, `LWJT` characters in little-endian order
+ */
+#define LWJSON_TAPE_MAGIC                   0x544A574CUL
+
+/**
+ * \brief           Version of tape layout
+ */
+#define LWJSON_TAPE_VERSION                 1
+
+/**
+ * \brief           Tape header, followed by tokens and string area
+ */
+typedef struct {
+    uint32_t magic;                             /*!< Set to \ref LWJSON_TAPE_MAGIC */
+    uint16_t version;                           /*!< Set to \ref LWJSON_TAPE_VERSION */
+    uint16_t token_size;                        /*!< Size of \ref lwjson_tape_token_t */
+    uint32_t tokens_len;                        /*!< Number of tokens */
+    uint32_t strings_len;                       /*!< Length of string area */
+} lwjson_tape_hdr_t;
+
+/**
+ * \brief           Count tokens and string bytes of token tree
+ * \param[in]       root: Top token
+ * \param[out]      tokens_len: Number of tokens
+ * \param[out]      strings_len: Length of all names and string values
+ */
+static void
+prv_tape_measure(const lwjson_token_t* root, size_t* tokens_len, size_t* strings_len) {
+    const lwjson_token_t* t = root;
+    size_t tokens = 0, strings = 0;
+
+    for (;;) {
+        ++tokens;
+        strings += t->token_name != NULL ? t->token_name_len : 0;
+        if (t->type == LWJSON_TYPE_STRING) {
+            strings += t->u.str.token_value_len;
+        } else if ((t->type == LWJSON_TYPE_OBJECT || t->type == LWJSON_TYPE_ARRAY) && t->u.first_child != NULL) {
+            t = t->u.first_child;
+            continue;
+        }
+        while (t != root && t->next == NULL) {
+            t = t->parent;
+        }
+        if (t == root) {
+            break;
+        }
+        t = t->next;
+    }
+    *tokens_len = tokens;
+    *strings_len = strings;
+}
+
+/**
+ * \brief           Store single token to tape, children and next token are linked later
+ * \param[in]       t: Token to store
+ * \param[out]      tt: Tape token to fill
+ * \param[in]       parent: Index of parent tape token
+ * \param[out]      strings: String area
+ * \param[in,out]   off: Current length of string area
+ */
+static void
+prv_tape_token(const lwjson_token_t* t, lwjson_tape_token_t* tt, uint32_t parent, char* strings, uint32_t* off) {
+    memset(tt, 0x00, sizeof(*tt));
+    tt->type = (uint32_t)t->type;
+    tt->parent = parent;
+    tt->next = LWJSON_TAPE_NONE;
+    tt->name = LWJSON_TAPE_NONE;
+    if (t->token_name != NULL) {
+        memcpy(&strings[*off], t->token_name, t->token_name_len);
+        tt->name = *off;
+        tt->name_len = (uint32_t)t->token_name_len;
+        *off += (uint32_t)t->token_name_len;
+    }
+    switch (t->type) {
+        case LWJSON_TYPE_STRING:
+            memcpy(&strings[*off], t->u.str.token_value, t->u.str.token_value_len);
+            tt->u.str.off = *off;
+            tt->u.str.len = (uint32_t)t->u.str.token_value_len;
+            *off += (uint32_t)t->u.str.token_value_len;
+            break;
+        case LWJSON_TYPE_NUM_INT: tt->u.num_int = (int64_t)t->u.num_int; break;
+        case LWJSON_TYPE_NUM_REAL: tt->u.num_real = (double)t->u.num_real; break;
+        case LWJSON_TYPE_OBJECT:
+        case LWJSON_TYPE_ARRAY: tt->u.first_child = LWJSON_TAPE_NONE; break;
+        default: break;
+    }
+}
+
+/**
+ * \brief           Store token tree to tape in depth-first order
+ *
+ * Tape is walked with token links only, indexes of ancestors are taken back from already stored tape tokens.
+ *
+ * \param[in]       root: Top token
+ * \param[out]      tt: Array of tape tokens, large enough for complete tree
+ * \param[out]      strings: String area, large enough for all names and string values
+ */
+static void
+prv_tape_write(const lwjson_token_t* root, lwjson_tape_token_t* tt, char* strings) {
+    const lwjson_token_t* t = root;
+    uint32_t idx = 0, cnt = 1, off = 0;
+
+    prv_tape_token(t, &tt[0], LWJSON_TAPE_NONE, strings, &off);
+    for (;;) {
+        if ((t->type == LWJSON_TYPE_OBJECT || t->type == LWJSON_TYPE_ARRAY) && t->u.first_child != NULL) {
+            t = t->u.first_child;
+            tt[idx].u.first_child = cnt;
+            prv_tape_token(t, &tt[cnt], idx, strings, &off);
+            idx = cnt++;
+            continue;
+        }
+
+        /* Go to next token on a list, or up to first ancestor that has one */
+        while (t != root && t->next == NULL) {
+            t = t->parent;
+            idx = tt[idx].parent;
+        }
+        if (t == root) {
+            break;
+        }
+        t = t->next;
+        tt[idx].next = cnt;
+        prv_tape_token(t, &tt[cnt], tt[idx].parent, strings, &off);
+        idx = cnt++;
+    }
+}
+
+/**
+ * \brief           Get length of tape for token tree
+ * \param[in]       root: Top token
+ * \param[out]      tokens_len: Number of tokens
+ * \param[out]      strings_len: Length of string area
+ * \param[out]      len: Length of complete tape
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM when tree is too large for the tape
+ */
+static lwjsonr_t
+prv_tape_len(const lwjson_token_t* root, size_t* tokens_len, size_t* strings_len, size_t* len) {
+    prv_tape_measure(root, tokens_len, strings_len);
+    if (*tokens_len >= LWJSON_TAPE_NONE || *strings_len >= LWJSON_TAPE_NONE) {
+        return lwjsonERRMEM;
+    }
+    *len = sizeof(lwjson_tape_hdr_t) + *tokens_len * sizeof(lwjson_tape_token_t) + *strings_len;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Store header and token tree to tape memory
+ * \param[in]       root: Top token
+ * \param[out]      mem: Tape memory, aligned to `8` bytes
+ * \param[in]       tokens_len: Number of tokens
+ * \param[in]       strings_len: Length of string area
+ */
+static void
+prv_tape_build(const lwjson_token_t* root, uint8_t* mem, size_t tokens_len, size_t strings_len) {
+    lwjson_tape_hdr_t* hdr = (lwjson_tape_hdr_t*)mem;
+
+    hdr->magic = LWJSON_TAPE_MAGIC;
+    hdr->version = LWJSON_TAPE_VERSION;
+    hdr->token_size = (uint16_t)sizeof(lwjson_tape_token_t);
+    hdr->tokens_len = (uint32_t)tokens_len;
+    hdr->strings_len = (uint32_t)strings_len;
+    prv_tape_write(root, (lwjson_tape_token_t*)(mem + sizeof(*hdr)),
+                   (char*)(mem + sizeof(*hdr) + tokens_len * sizeof(lwjson_tape_token_t)));
+}
+
+/**
+ * \brief           Export parsed JSON to memory as relocatable token tree
+ *
+ * Exported tape does not contain any pointers, it can be copied to shared memory
+ * and opened with \ref lwjson_tape_open by other processes, at any address.
+ * Call with `NULL` buffer to get required length first.
+ *
+ * \param[in]       doc: Parsed document to export
+ * \param[out]      buf: Buffer for tape, aligned to `8` bytes. Set to `NULL` to get length only
+ * \param[in]       buf_len: Length of buffer
+ * \param[out]      len: Length of tape
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM when buffer is too small or tree is too large
+ *                      for the tape, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_tape_export(const lwjson_doc_t* doc, void* buf, size_t buf_len, size_t* len) {
+    size_t tokens_len, strings_len;
+    lwjsonr_t res;
+
+    if (doc == NULL || doc->root == NULL || len == NULL) {
+        return lwjsonERR;
+    }
+    if ((res = prv_tape_len(doc->root, &tokens_len, &strings_len, len)) != lwjsonOK) {
+        return res;
+    }
+    if (buf != NULL) {
+        if (buf_len < *len) {
+            return lwjsonERRMEM;
+        }
+        prv_tape_build(doc->root, buf, tokens_len, strings_len);
+    }
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Save parsed JSON to file as relocatable token tree
+ *
+ * Names and string values are copied to tape, so that input text is not needed to use the tape.
+ * Tape is written from the beginning of the file, with `mmap`, and file is truncated to the tape length.
+ * Numbers are stored as 64-bit integer and double, tape can be read on systems with the same byte order.
+ *
+ * \param[in]       doc: Parsed document to save
+ * \param[in]       fd: File descriptor, opened for reading and writing
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM when tree is too large for the tape,
+ *                      member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_tape_save(const lwjson_doc_t* doc, int fd) {
+    size_t tokens_len, strings_len, len;
+    lwjsonr_t res;
+    uint8_t* mem;
+
+    if (doc == NULL || doc->root == NULL || fd < 0) {
+        return lwjsonERR;
+    }
+    if ((res = prv_tape_len(doc->root, &tokens_len, &strings_len, &len)) != lwjsonOK) {
+        return res;
+    }
+    if (ftruncate(fd, (off_t)len) != 0) {
+        return lwjsonERR;
+    }
+    if ((mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        return lwjsonERR;
+    }
+    prv_tape_build(doc->root, mem, tokens_len, strings_len);
+    munmap(mem, len);
+    return lwjsonOK;
+}
+
+#if defined(__linux__) || __DOXYGEN__
+
+/**
+ * \brief           Save parsed JSON to new sealed shared memory file
+ *
+ * Tape is saved to anonymous memory file, which is then sealed against any modification.
+ * File descriptor can be inherited by forked processes or passed over unix socket,
+ * every process then maps the same memory with \ref lwjson_tape_load.
+ *
+ * \note            Available on Linux only
+ * \param[in]       doc: Parsed document to save
+ * \param[in]       name: Name of memory file, used for debugging only
+ * \param[out]      fd: File descriptor of memory file, to be closed by application
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_tape_share(const lwjson_doc_t* doc, const char* name, int* fd) {
+    lwjsonr_t res;
+    int mfd;
+
+    if (doc == NULL || name == NULL || fd == NULL) {
+        return lwjsonERR;
+    }
+    if ((mfd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING)) < 0) {
+        return lwjsonERR;
+    }
+    if ((res = lwjson_tape_save(doc, mfd)) == lwjsonOK
+        && fcntl(mfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        res = lwjsonERR;
+    }
+    if (res != lwjsonOK) {
+        close(mfd);
+        return res;
+    }
+    *fd = mfd;
+    return lwjsonOK;
+}
+
+#endif /* defined(__linux__) || __DOXYGEN__ */
+
+/**
+ * \brief           Open tape stored in memory
+ *
+ * Only header is checked, so that opening time does not depend on tape size.
+ * Token links and string offsets are checked by tape accessors when they are used,
+ * links are not checked for loops and tape must come from trusted source.
+ *
+ * \param[out]      tape: Tape view to setup
+ * \param[in]       data: Tape data, aligned to `8` bytes. It must stay valid while tape is used
+ * \param[in]       len: Length of tape data
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRJSON when data is not valid tape,
+ *                      member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_tape_open(lwjson_tape_t* tape, const void* data, size_t len) {
+    const lwjson_tape_hdr_t* hdr = data;
+
+    if (tape == NULL || data == NULL) {
+        return lwjsonERR;
+    }
+    memset(tape, 0x00, sizeof(*tape));
+    if (len < sizeof(*hdr) || hdr->magic != LWJSON_TAPE_MAGIC || hdr->version != LWJSON_TAPE_VERSION
+        || hdr->token_size != sizeof(lwjson_tape_token_t)
+        || (len - sizeof(*hdr)) / sizeof(lwjson_tape_token_t) < hdr->tokens_len
+        || len - sizeof(*hdr) - hdr->tokens_len * sizeof(lwjson_tape_token_t) < hdr->strings_len) {
+        return lwjsonERRJSON;
+    }
+    tape->tokens = (const lwjson_tape_token_t*)((const uint8_t*)data + sizeof(*hdr));
+    tape->tokens_len = hdr->tokens_len;
+    tape->strings = (const char*)&tape->tokens[tape->tokens_len];
+    tape->strings_len = hdr->strings_len;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Load tape saved with \ref lwjson_tape_save
+ *
+ * File is mapped to memory read-only, there is no parsing and tokens are read from the file on first use.
+ * Tape must be closed with \ref lwjson_tape_close.
+ *
+ * \param[out]      tape: Tape view to setup
+ * \param[in]       fd: File descriptor, opened for reading. It may be closed after this function returns
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRJSON when file is not valid tape,
+ *                      member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_tape_load(lwjson_tape_t* tape, int fd) {
+    struct stat st;
+    lwjsonr_t res;
+    void* mem;
+
+    if (tape == NULL || fd < 0) {
+        return lwjsonERR;
+    }
+    memset(tape, 0x00, sizeof(*tape));
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(lwjson_tape_hdr_t)) {
+        return lwjsonERR;
+    }
+    if ((mem = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        return lwjsonERR;
+    }
+    if ((res = lwjson_tape_open(tape, mem, (size_t)st.st_size)) != lwjsonOK) {
+        munmap(mem, (size_t)st.st_size);
+        return res;
+    }
+    tape->map = mem;
+    tape->map_len = (size_t)st.st_size;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Close tape and unmap memory mapped by \ref lwjson_tape_load
+ * \param[in,out]   tape: Tape to close
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_tape_close(lwjson_tape_t* tape) {
+    if (tape == NULL) {
+        return lwjsonERR;
+    }
+    if (tape->map != NULL) {
+        munmap(tape->map, tape->map_len);
+    }
+    memset(tape, 0x00, sizeof(*tape));
+    return lwjsonOK;
+}
+
+#endif /* LWJSON_CFG_TAPE || __DOXYGEN__ */
@@ -0,0 +1,748 @@
+/**
+ * \file            lwjson_writer.c
+ * \brief           JSON writer with bounded output buffer
+ */
+
+/*
+ * Copyright (c) 2020 Tilen MAJERLE
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwJSON - Lightweight JSON format parser.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ * Version:         $_version_$
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lwjson/lwjson.h"
+
+/* Word-at-a-time helpers to check 8 characters at once */
+#define PRV_ONES                    ((uint64_t)0x0101010101010101ULL)
+#define PRV_HIGHS                   ((uint64_t)0x8080808080808080ULL)
+#define PRV_HAS_ZERO(x)             (((x) - PRV_ONES) & ~(x) & PRV_HIGHS)
+#define PRV_HAS_VALUE(x, c)         PRV_HAS_ZERO((x) ^ (PRV_ONES * (uint8_t)(c)))
+#define PRV_HAS_LESS(x, c)          (((x) - PRV_ONES * (uint8_t)(c)) & ~(x) & PRV_HIGHS)
+
+/* Bit of nesting level in writer level bit arrays */
+#define PRV_LEVEL_GET(bits, lvl)    (((bits)[(lvl) >> 5] >> ((lvl) & 0x1F)) & 0x01)
+#define PRV_LEVEL_SET(bits, lvl)    ((bits)[(lvl) >> 5] |= (uint32_t)1 << ((lvl) & 0x1F))
+#define PRV_LEVEL_CLR(bits, lvl)    ((bits)[(lvl) >> 5] &= ~((uint32_t)1 << ((lvl) & 0x1F)))
+
+/**
+ * \brief           Two-digit pairs for integer formatting
+ */
+static const char
+prv_digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * \brief           Set writer error, when there was no error before
+ * \param[in,out]   w: Writer instance
+ * \param[in]       res: Error to set
+ * \return          First error of writer
+ */
+static lwjsonr_t
+prv_error(lwjson_writer_t* w, lwjsonr_t res) {
+    if (w->err == lwjsonOK) {
+        w->err = res;
+    }
+    return w->err;
+}
+
+/**
+ * \brief           Write data to output buffer, flush when buffer is full
+ * \param[in,out]   w: Writer instance
+ * \param[in]       data: Data to write
+ * \param[in]       len: Length of data in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_write(lwjson_writer_t* w, const void* data, size_t len) {
+    const char* d = data;
+
+    if (w->err != lwjsonOK) {
+        return w->err;
+    }
+    while (len > 0) {
+        size_t chunk;
+
+        if (w->len == w->cap) {
+            if ((w->err = lwjson_writer_flush(w)) != lwjsonOK) {
+                return w->err;
+            }
+            if (w->len == w->cap) {
+                return prv_error(w, lwjsonERRMEM);
+            }
+        }
+        chunk = w->cap - w->len;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(&w->buf[w->len], d, chunk);
+        w->len += chunk;
+        d += chunk;
+        len -= chunk;
+    }
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Write single character to output buffer
+ * \param[in,out]   w: Writer instance
+ * \param[in]       ch: Character to write
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_write_char(lwjson_writer_t* w, char ch) {
+    if (w->err == lwjsonOK && w->len < w->cap) {
+        w->buf[w->len++] = ch;
+        return lwjsonOK;
+    }
+    return prv_write(w, &ch, 1);
+}
+
+/**
+ * \brief           Write separator before new value, if needed
+ * \param[in,out]   w: Writer instance
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_begin_value(lwjson_writer_t* w) {
+    if (w->after_key) {
+        w->after_key = 0;
+        return w->err;
+    }
+    if (w->depth == 0) {
+        return w->err;
+    }
+    if (PRV_LEVEL_GET(w->has_items, w->depth - 1)) {
+        return prv_write_char(w, ',');
+    }
+    PRV_LEVEL_SET(w->has_items, w->depth - 1);
+    return w->err;
+}
+
+/**
+ * \brief           Write string with quotes and escape sequences
+ * \param[in,out]   w: Writer instance
+ * \param[in]       str: String to write
+ * \param[in]       len: Length of string in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_write_escaped(lwjson_writer_t* w, const char* str, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    size_t i = 0, start = 0;
+
+    prv_write_char(w, '"');
+    while (i < len) {
+        /* Skip 8 characters at once when none of them needs escaping */
+        for (; i + 8 <= len; i += 8) {
+            uint64_t v;
+            memcpy(&v, &str[i], sizeof(v));
+            if (PRV_HAS_LESS(v, 0x20) | PRV_HAS_VALUE(v, '"') | PRV_HAS_VALUE(v, '\\')) {
+                break;
+            }
+        }
+        /* Find and write escape sequence, then get back to word checks */
+        for (; i < len; ++i) {
+            unsigned char ch = (unsigned char)str[i];
+            char esc[6] = {'\\', 0, '0', '0', 0, 0};
+            size_t esc_len = 2;
+
+            if (ch >= 0x20 && ch != '"' && ch != '\\') {
+                continue;
+            }
+            switch (ch) {
+                case '"': esc[1] = '"'; break;
+                case '\\': esc[1] = '\\'; break;
+                case '\b': esc[1] = 'b'; break;
+                case '\f': esc[1] = 'f'; break;
+                case '\n': esc[1] = 'n'; break;
+                case '\r': esc[1] = 'r'; break;
+                case '\t': esc[1] = 't'; break;
+                default:
+                    esc[1] = 'u';
+                    esc[4] = hex[ch >> 4];
+                    esc[5] = hex[ch & 0x0F];
+                    esc_len = 6;
+                    break;
+            }
+            prv_write(w, &str[start], i - start);
+            prv_write(w, esc, esc_len);
+            start = ++i;
+            break;
+        }
+    }
+    prv_write(w, &str[start], len - start);
+    return prv_write_char(w, '"');
+}
+
+/**
+ * \brief           Format integer to decimal text
+ * \param[in]       num: Number to format
+ * \param[out]      buf: Output buffer
+ * \param[in]       buf_len: Length of buffer, at least `21` bytes
+ * \return          Pointer to first character in `buf`, number ends at `buf_len` position
+ */
+static char*
+prv_format_int(lwjson_int_t num, char* buf, size_t buf_len) {
+    char* p = &buf[buf_len];
+    unsigned long long u = num < 0 ? 0ULL - (unsigned long long)num : (unsigned long long)num;
+
+    while (u >= 100) {
+        size_t idx = (size_t)(u % 100) * 2;
+        u /= 100;
+        *--p = prv_digit_pairs[idx + 1];
+        *--p = prv_digit_pairs[idx];
+    }
+    if (u >= 10) {
+        *--p = prv_digit_pairs[u * 2 + 1];
+        *--p = prv_digit_pairs[u * 2];
+    } else {
+        *--p = (char)('0' + u);
+    }
+    if (num < 0) {
+        *--p = '-';
+    }
+    return p;
+}
+
+/**
+ * \brief           Initialize writer instance
+ * \param[out]      w: Writer instance
+ * \param[in]       buf: Output buffer
+ * \param[in]       cap: Size of output buffer in units of bytes
+ * \param[in]       flush_fn: Function called when buffer is full or on \ref lwjson_writer_flush.
+ *                      Set to `NULL` to write to `buf` only
+ * \param[in]       arg: Custom user argument, available as `w->arg` in flush function
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_init(lwjson_writer_t* w, char* buf, size_t cap, lwjson_writer_flush_fn flush_fn, void* arg) {
+    if (w == NULL || buf == NULL || cap == 0) {
+        return lwjsonERR;
+    }
+    memset(w, 0x00, sizeof(*w));
+    w->buf = buf;
+    w->cap = cap;
+    w->flush_fn = flush_fn;
+    w->arg = arg;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Pass buffered data to flush function and empty the buffer
+ * \param[in,out]   w: Writer instance
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise.
+ *                      When writer has no flush function, data stay in the buffer and \ref lwjsonOK is returned.
+ *                      Error of flush function is kept as writer error and stops all later writes
+ */
+lwjsonr_t
+lwjson_writer_flush(lwjson_writer_t* w) {
+    lwjsonr_t res;
+
+    if (w->flush_fn == NULL || w->len == 0) {
+        return lwjsonOK;
+    }
+    if ((res = w->flush_fn(w, w->buf, w->len)) == lwjsonOK) {
+        w->len = 0;
+    } else {
+        prv_error(w, res);
+    }
+    return res;
+}
+
+/**
+ * \brief           Start new object
+ * \param[in,out]   w: Writer instance
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_begin_object(lwjson_writer_t* w) {
+    if (w->depth >= LWJSON_WRITER_MAX_DEPTH) {
+        return prv_error(w, lwjsonERRMEM);
+    }
+    prv_begin_value(w);
+    ++w->depth;
+    PRV_LEVEL_CLR(w->has_items, w->depth - 1);
+    PRV_LEVEL_CLR(w->is_array, w->depth - 1);
+    return prv_write_char(w, '{');
+}
+
+/**
+ * \brief           Start new array
+ * \param[in,out]   w: Writer instance
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_begin_array(lwjson_writer_t* w) {
+    if (w->depth >= LWJSON_WRITER_MAX_DEPTH) {
+        return prv_error(w, lwjsonERRMEM);
+    }
+    prv_begin_value(w);
+    ++w->depth;
+    PRV_LEVEL_CLR(w->has_items, w->depth - 1);
+    PRV_LEVEL_SET(w->is_array, w->depth - 1);
+    return prv_write_char(w, '[');
+}
+
+/**
+ * \brief           End last started object or array
+ * \param[in,out]   w: Writer instance
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_end(lwjson_writer_t* w) {
+    if (w->depth == 0 || w->after_key) {
+        return prv_error(w, lwjsonERR);
+    }
+    --w->depth;
+    return prv_write_char(w, PRV_LEVEL_GET(w->is_array, w->depth) ? ']' : '}');
+}
+
+/**
+ * \brief           Write object key, next write call provides its value
+ * \param[in,out]   w: Writer instance
+ * \param[in]       key: Key string, escape sequences are added when needed
+ * \param[in]       len: Length of key in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_key(lwjson_writer_t* w, const char* key, size_t len) {
+    if (w->depth == 0 || w->after_key || PRV_LEVEL_GET(w->is_array, w->depth - 1)) {
+        return prv_error(w, lwjsonERR);
+    }
+    prv_begin_value(w);
+    prv_write_escaped(w, key, len);
+    prv_write_char(w, ':');
+    w->after_key = 1;
+    return w->err;
+}
+
+/**
+ * \brief           Write object key that is already escaped, such as token name from parsed JSON
+ * \param[in,out]   w: Writer instance
+ * \param[in]       key: Key string without quotes, written as-is
+ * \param[in]       len: Length of key in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_key_raw(lwjson_writer_t* w, const char* key, size_t len) {
+    if (w->depth == 0 || w->after_key || PRV_LEVEL_GET(w->is_array, w->depth - 1)) {
+        return prv_error(w, lwjsonERR);
+    }
+    prv_begin_value(w);
+    prv_write_char(w, '"');
+    prv_write(w, key, len);
+    prv_write(w, "\":", 2);
+    w->after_key = 1;
+    return w->err;
+}
+
+/**
+ * \brief           Write string value
+ * \param[in,out]   w: Writer instance
+ * \param[in]       str: String, escape sequences are added when needed
+ * \param[in]       len: Length of string in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_string(lwjson_writer_t* w, const char* str, size_t len) {
+    prv_begin_value(w);
+    return prv_write_escaped(w, str, len);
+}
+
+/**
+ * \brief           Write integer value
+ * \param[in,out]   w: Writer instance
+ * \param[in]       num: Number to write
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_int(lwjson_writer_t* w, lwjson_int_t num) {
+    char buf[24], *p;
+
+    prv_begin_value(w);
+    p = prv_format_int(num, buf, sizeof(buf));
+    return prv_write(w, p, (size_t)(&buf[sizeof(buf)] - p));
+}
+
+/**
+ * \brief           Write real value with shortest text that parses back to the same value
+ * \param[in,out]   w: Writer instance
+ * \param[in]       num: Number to write. `NaN` and infinity are not valid JSON
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_real(lwjson_writer_t* w, lwjson_real_t num) {
+    char buf[32];
+    int len = 0;
+
+    if (num != num || num - num != 0) {         /* NaN or infinity */
+        return prv_error(w, lwjsonERR);
+    }
+    prv_begin_value(w);
+
+    /* Integral values are written with integer formatting */
+    if (num > -1e15 && num < 1e15 && (lwjson_real_t)(long long)num == num) {
+        char* p = prv_format_int((lwjson_int_t)num, buf, sizeof(buf) - 2);
+        buf[sizeof(buf) - 2] = '.';
+        buf[sizeof(buf) - 1] = '0';
+        return prv_write(w, p, (size_t)(&buf[sizeof(buf)] - p));
+    }
+
+    /*
+     * Any text with up to FLT_DIG/DBL_DIG digits round-trips,
+     * so first precision that gives back the same value is the shortest one
+     */
+    for (int prec = sizeof(lwjson_real_t) == sizeof(float) ? 6 : 15; prec <= 17; ++prec) {
+        len = snprintf(buf, sizeof(buf), "%.*g", prec, (double)num);
+        if (sizeof(lwjson_real_t) == sizeof(float) ? (strtof(buf, NULL) == (float)num) : (strtod(buf, NULL) == (double)num)) {
+            break;
+        }
+    }
+    if (len <= 0 || (size_t)len >= sizeof(buf)) {
+        return prv_error(w, lwjsonERR);
+    }
+    /* Keep number real when parsed back */
+    if (strpbrk(buf, ".eE") == NULL && (size_t)len + 2 < sizeof(buf)) {
+        buf[len++] = '.';
+        buf[len++] = '0';
+    }
+    return prv_write(w, buf, (size_t)len);
+}
+
+/**
+ * \brief           Write boolean value
+ * \param[in,out]   w: Writer instance
+ * \param[in]       val: Set to `0` for `false`, any other value for `true`
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_bool(lwjson_writer_t* w, uint8_t val) {
+    prv_begin_value(w);
+    return val ? prv_write(w, "true", 4) : prv_write(w, "false", 5);
+}
+
+/**
+ * \brief           Write `null` value
+ * \param[in,out]   w: Writer instance
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_null(lwjson_writer_t* w) {
+    prv_begin_value(w);
+    return prv_write(w, "null", 4);
+}
+
+/**
+ * \brief           Write already formatted JSON value as-is
+ * \param[in,out]   w: Writer instance
+ * \param[in]       json: Valid JSON value text
+ * \param[in]       len: Length of text in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_raw(lwjson_writer_t* w, const char* json, size_t len) {
+    prv_begin_value(w);
+    return prv_write(w, json, len);
+}
+
+/**
+ * \brief           Write bytes to output with no separators or formatting
+ * \param[in,out]   w: Writer instance
+ * \param[in]       data: Data to write
+ * \param[in]       len: Length of data in units of bytes
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_bytes(lwjson_writer_t* w, const void* data, size_t len) {
+    return prv_write(w, data, len);
+}
+
+/**
+ * \brief           Write token subtree as compact JSON
+ *
+ * Token name is not written, object members are written with their names.
+ * String values and names are copied from input as-is, escape sequences are not modified.
+ * With \ref LWJSON_CFG_TOKEN_SPAN enabled, numbers are copied from input too.
+ *
+ * Subtree nested deeper than \ref LWJSON_CFG_WRITER_MAX_DEPTH is not written and \ref lwjsonERRMEM is returned.
+ *
+ * \param[in,out]   w: Writer instance
+ * \param[in]       token: Token to write
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_writer_token(lwjson_writer_t* w, const lwjson_token_t* token) {
+    switch (token->type) {
+        case LWJSON_TYPE_OBJECT:
+        case LWJSON_TYPE_ARRAY:
+            if (token->type == LWJSON_TYPE_OBJECT) {
+                lwjson_writer_begin_object(w);
+            } else {
+                lwjson_writer_begin_array(w);
+            }
+            for (const lwjson_token_t* t = token->u.first_child; t != NULL && w->err == lwjsonOK; t = t->next) {
+                if (token->type == LWJSON_TYPE_OBJECT) {
+                    lwjson_writer_key_raw(w, t->token_name, t->token_name_len);
+                }
+                lwjson_writer_token(w, t);
+            }
+            return lwjson_writer_end(w);
+        case LWJSON_TYPE_STRING:
+            prv_begin_value(w);
+            prv_write_char(w, '"');
+            prv_write(w, token->u.str.token_value, token->u.str.token_value_len);
+            return prv_write_char(w, '"');
+        case LWJSON_TYPE_NUM_INT:
+        case LWJSON_TYPE_NUM_REAL:
+#if LWJSON_CFG_TOKEN_SPAN
+            /* Original number text is reused, CBOR and MessagePack numbers have none */
+            if (token->token_raw != NULL) {
+                return lwjson_writer_raw(w, token->token_raw, token->token_raw_len);
+            }
+#endif /* LWJSON_CFG_TOKEN_SPAN */
+            return token->type == LWJSON_TYPE_NUM_INT ? lwjson_writer_int(w, token->u.num_int) : lwjson_writer_real(w, token->u.num_real);
+        case LWJSON_TYPE_TRUE:
+        case LWJSON_TYPE_FALSE:
+            return lwjson_writer_bool(w, token->type == LWJSON_TYPE_TRUE);
+        case LWJSON_TYPE_NULL:
+            return lwjson_writer_null(w);
+        default:
+            return prv_error(w, lwjsonERR);
+    }
+}
+
+/**
+ * \brief           Serialize token subtree of parsed JSON to compact JSON text
+ * \note            Function is thread-safe, document is not modified
+ * \param[in]       doc: Parsed document
+ * \param[in]       token: Token to serialize. Set to `NULL` to serialize complete document
+ * \param[out]      out: Output buffer, `NULL` terminated on success
+ * \param[in]       cap: Size of output buffer in units of bytes, including `NULL` termination
+ * \param[out]      len: Pointer to output variable with text length, excluding `NULL` termination.
+ *                      Set to `NULL` if not used
+ * \return          \ref lwjsonOK on success, \ref lwjsonERRMEM if output does not fit to buffer
+ *                      or is nested deeper than \ref LWJSON_CFG_WRITER_MAX_DEPTH, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_serialize(const lwjson_doc_t* doc, const lwjson_token_t* token, char* out, size_t cap, size_t* len) {
+    lwjson_writer_t w;
+    lwjsonr_t res;
+
+    if (doc == NULL || doc->root == NULL || out == NULL || cap == 0) {
+        return lwjsonERR;
+    }
+    if (token == NULL) {
+        token = doc->root;
+    }
+    if (cap < 2 || (res = lwjson_writer_init(&w, out, cap - 1, NULL, NULL)) != lwjsonOK) {
+        return lwjsonERRMEM;
+    }
+    if ((res = lwjson_writer_token(&w, token)) == lwjsonOK) {
+        out[w.len] = '\0';
+        if (len != NULL) {
+            *len = w.len;
+        }
+    }
+    return res;
+}
+
+/**
+ * \brief           Find end of JSON string
+ * \param[in]       s: Pointer to opening quote character
+ * \param[in]       end: End of input text
+ * \return          Pointer to character after closing quote, `NULL` if string is not terminated
+ */
+static const char*
+prv_string_end(const char* s, const char* end) {
+    for (++s; s < end;) {
+        const char* q = memchr(s, '"', (size_t)(end - s));
+        const char* b;
+
+        if (q == NULL) {
+            break;
+        }
+        /* Quote is escaped when preceded by odd number of backslashes */
+        for (b = q; b > s && b[-1] == '\\'; --b) {}
+        if (((q - b) & 0x01) == 0) {
+            return q + 1;
+        }
+        s = q + 1;
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Check if character is blank as per RFC4627
+ * \param[in]       ch: Character to check
+ * \return          `1` if blank, `0` otherwise
+ */
+static uint8_t
+prv_is_blank(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '\f';
+}
+
+/**
+ * \brief           Remove all blank characters outside strings from JSON text
+ *
+ * Text is processed in single pass and no tokens are created.
+ * Input is not validated, except that all strings must be terminated.
+ *
+ * \param[in]       in: Input JSON text
+ * \param[in]       len: Length of input text in units of bytes
+ * \param[out]      out: Output buffer with at least `len` bytes. It may be the same as `in` for in-place operation
+ * \param[out]      out_len: Pointer to output variable with length of minified text
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_minify(const char* in, size_t len, char* out, size_t* out_len) {
+    const char* s = in, *end = in + len;
+    char* o = out;
+
+    if (in == NULL || out == NULL || out_len == NULL) {
+        return lwjsonERR;
+    }
+    while (s < end) {
+        const char* run = s;
+
+        if (*s == '"') {
+            if ((s = prv_string_end(s, end)) == NULL) {
+                return lwjsonERRJSON;
+            }
+        } else if (prv_is_blank(*s)) {
+            for (++s; s < end && prv_is_blank(*s); ++s) {}
+            continue;
+        } else {
+            for (++s; s < end && *s != '"' && !prv_is_blank(*s); ++s) {}
+        }
+        if (o != run) {
+            memmove(o, run, (size_t)(s - run));
+        }
+        o += s - run;
+    }
+    *out_len = (size_t)(o - out);
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Write new line and indentation
+ * \param[in,out]   w: Writer instance
+ * \param[in]       cnt: Number of spaces to write
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+static lwjsonr_t
+prv_write_indent(lwjson_writer_t* w, size_t cnt) {
+    static const char spaces[] = "                                ";
+
+    prv_write_char(w, '\n');
+    for (; cnt > sizeof(spaces) - 1; cnt -= sizeof(spaces) - 1) {
+        prv_write(w, spaces, sizeof(spaces) - 1);
+    }
+    return prv_write(w, spaces, cnt);
+}
+
+/**
+ * \brief           Format JSON text with new lines and indentation
+ *
+ * Text is processed in single pass and no tokens are created.
+ * Empty objects and arrays are written as `{}` and `[]`.
+ * Input is not validated, except that all strings must be terminated.
+ *
+ * \param[in]       in: Input JSON text
+ * \param[in]       len: Length of input text in units of bytes
+ * \param[in,out]   w: Writer instance to write formatted text to
+ * \param[in]       indent: Number of spaces per nesting level
+ * \return          \ref lwjsonOK on success, member of \ref lwjsonr_t otherwise
+ */
+lwjsonr_t
+lwjson_prettify(const char* in, size_t len, lwjson_writer_t* w, size_t indent) {
+    const char* s = in, *end = in + len;
+    size_t depth = 0;
+
+    if (in == NULL || w == NULL) {
+        return lwjsonERR;
+    }
+    while (s < end && w->err == lwjsonOK) {
+        const char* run = s;
+
+        switch (*s) {
+            case '{':
+            case '[': {
+                const char* n;
+
+                /* Keep empty containers on one line */
+                for (n = s + 1; n < end && prv_is_blank(*n); ++n) {}
+                if (n < end && *n == (*s == '{' ? '}' : ']')) {
+                    prv_write_char(w, *s);
+                    prv_write_char(w, *n);
+                    s = n + 1;
+                } else {
+                    prv_write_char(w, *s++);
+                    prv_write_indent(w, ++depth * indent);
+                }
+                break;
+            }
+            case '}':
+            case ']':
+                depth -= depth > 0;
+                prv_write_indent(w, depth * indent);
+                prv_write_char(w, *s++);
+                break;
+            case ',':
+                prv_write_char(w, *s++);
+                prv_write_indent(w, depth * indent);
+                break;
+            case ':':
+                prv_write(w, ": ", 2);
+                ++s;
+                break;
+            case '"':
+                if ((s = prv_string_end(s, end)) == NULL) {
+                    return lwjsonERRJSON;
+                }
+                prv_write(w, run, (size_t)(s - run));
+                break;
+            default:
+                if (prv_is_blank(*s)) {
+                    ++s;
+                } else {
+                    for (++s; s < end && strchr("{}[],:\" \t\r\n\f", *s) == NULL; ++s) {}
+                    prv_write(w, run, (size_t)(s - run));
+                }
+                break;
+        }
+    }
+    return w->err;
+}
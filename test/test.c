@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "lwjson/lwjson.h"
 
 /**
@@ -111,6 +113,7 @@ paths_types[] = {
 /* LwJSON instance and tokens */
 static lwjson_token_t tokens[4096];
 static lwjson_t lwjson;
+static lwjson_doc_t doc;
 
 static void
 test_token_count(size_t exp_token_count, const char* json_str) {
@@ -162,6 +165,1673 @@ test_json_data_types(void) {
     }
 }
 
+static void
+test_array_to(void) {
+    const lwjson_token_t* t;
+    int64_t i64[4];
+    double f64[4];
+    float f32[4];
+    size_t len;
+
+    printf("...\r\nParsing numeric arrays..\r\n");
+    if (lwjson_parse(&lwjson, "{\"i\":[1,-2,3],\"r\":[1.5,2,-3.25],\"m\":[1,\"s\",3],\"b\":[1,2,3,4,5]}") != lwjsonOK) {
+        printf("Could not parse numeric arrays..\r\n");
+        return;
+    }
+    t = lwjson_find(&lwjson, "i");
+    if (lwjson_array_to_i64(t, i64, LWJSON_ARRAYSIZE(i64), &len) == lwjsonOK
+        && len == 3 && i64[0] == 1 && i64[1] == -2 && i64[2] == 3) {
+        printf("Array to i64 test passed..\r\n");
+    } else {
+        printf("Array to i64 test failed..\r\n");
+    }
+    t = lwjson_find(&lwjson, "r");
+    if (lwjson_array_to_f64(t, f64, LWJSON_ARRAYSIZE(f64), &len) == lwjsonOK
+        && len == 3 && f64[0] == 1.5 && f64[1] == 2 && f64[2] == -3.25
+        && lwjson_array_to_f32(t, f32, LWJSON_ARRAYSIZE(f32), &len) == lwjsonOK
+        && len == 3 && f32[0] == 1.5f && f32[1] == 2.0f && f32[2] == -3.25f) {
+        printf("Array to real test passed..\r\n");
+    } else {
+        printf("Array to real test failed..\r\n");
+    }
+    if (lwjson_array_to_i64(lwjson_find(&lwjson, "m"), i64, LWJSON_ARRAYSIZE(i64), &len) == lwjsonERR && len == 1
+        && lwjson_array_to_i64(lwjson_find(&lwjson, "r"), i64, LWJSON_ARRAYSIZE(i64), &len) == lwjsonERR && len == 0
+        && lwjson_array_to_i64(lwjson_find(&lwjson, "b"), i64, LWJSON_ARRAYSIZE(i64), &len) == lwjsonERRMEM && len == 4) {
+        printf("Array to type error test passed..\r\n");
+    } else {
+        printf("Array to type error test failed..\r\n");
+    }
+}
+
+/**
+ * \brief           Structures for binding test
+ */
+typedef struct {
+    int32_t x;
+    int32_t y;
+} test_point_t;
+
+typedef struct {
+    int64_t id;
+    double temp;
+    uint8_t on;
+    char name[8];
+    test_point_t pos;
+    int16_t arr[3];
+    test_point_t pts[2];
+} test_bind_t;
+
+static const lwjson_binding_t
+bind_point[] = {
+    LWJSON_BIND(test_point_t, x, "x", LWJSON_BIND_INT, NULL),
+    LWJSON_BIND(test_point_t, y, "y", LWJSON_BIND_INT, NULL),
+    LWJSON_BIND_END,
+};
+static const lwjson_binding_t bind_arr_elem = LWJSON_BIND_ELEM(int16_t, LWJSON_BIND_INT, NULL);
+static const lwjson_binding_t bind_pts_elem = LWJSON_BIND_ELEM(test_point_t, LWJSON_BIND_OBJECT, bind_point);
+static const lwjson_binding_t
+bind_test[] = {
+    LWJSON_BIND(test_bind_t, id, "id", LWJSON_BIND_INT, NULL),
+    LWJSON_BIND(test_bind_t, temp, "temp", LWJSON_BIND_REAL, NULL),
+    LWJSON_BIND(test_bind_t, on, "on", LWJSON_BIND_BOOL, NULL),
+    LWJSON_BIND(test_bind_t, name, "name", LWJSON_BIND_STRING, NULL),
+    LWJSON_BIND(test_bind_t, pos, "pos", LWJSON_BIND_OBJECT, bind_point),
+    LWJSON_BIND(test_bind_t, arr, "arr", LWJSON_BIND_ARRAY, &bind_arr_elem),
+    LWJSON_BIND(test_bind_t, pts, "pts", LWJSON_BIND_ARRAY, &bind_pts_elem),
+    LWJSON_BIND_END,
+};
+
+static void
+test_bind(void) {
+    test_bind_t b = {0};
+
+    printf("...\r\nBinding JSON to structure..\r\n");
+    if (lwjson_parse(&lwjson, "{\"id\":7,\"temp\":21.5,\"on\":true,\"skip\":[1],\"name\":\"dev\","
+                              "\"pos\":{\"x\":1,\"y\":-2},\"arr\":[4,5],\"pts\":[{\"x\":3},{\"y\":4}]}") != lwjsonOK) {
+        printf("Could not parse JSON for binding..\r\n");
+        return;
+    }
+    if (lwjson_get_doc(&lwjson, &doc) == lwjsonOK && lwjson_bind(&doc, bind_test, &b) == lwjsonOK
+        && b.id == 7 && b.temp == 21.5 && b.on == 1 && strcmp(b.name, "dev") == 0
+        && b.pos.x == 1 && b.pos.y == -2 && b.arr[0] == 4 && b.arr[1] == 5 && b.arr[2] == 0
+        && b.pts[0].x == 3 && b.pts[0].y == 0 && b.pts[1].x == 0 && b.pts[1].y == 4) {
+        printf("Bind test passed..\r\n");
+    } else {
+        printf("Bind test failed..\r\n");
+    }
+    if (lwjson_parse(&lwjson, "{\"id\":\"7\"}") == lwjsonOK && lwjson_get_doc(&lwjson, &doc) == lwjsonOK
+        && lwjson_bind(&doc, bind_test, &b) == lwjsonERR
+        && lwjson_parse(&lwjson, "{\"name\":\"too long name\"}") == lwjsonOK && lwjson_get_doc(&lwjson, &doc) == lwjsonOK
+        && lwjson_bind(&doc, bind_test, &b) == lwjsonERRMEM
+        && lwjson_parse(&lwjson, "{\"arr\":[32767,-32768,32768]}") == lwjsonOK && lwjson_get_doc(&lwjson, &doc) == lwjsonOK
+        && lwjson_bind(&doc, bind_test, &b) == lwjsonERRMEM && b.arr[0] == 32767 && b.arr[1] == -32768 && b.arr[2] == 0
+        && (sizeof(lwjson_int_t) < sizeof(int64_t)
+            || (lwjson_parse(&lwjson, "{\"pos\":{\"x\":4294967296}}") == lwjsonOK && lwjson_get_doc(&lwjson, &doc) == lwjsonOK
+                && lwjson_bind(&doc, bind_test, &b) == lwjsonERRMEM && b.pos.x == 1))) {
+        printf("Bind error test passed..\r\n");
+    } else {
+        printf("Bind error test failed..\r\n");
+    }
+}
+
+/**
+ * \brief           Collect flushed output, fail when more than `limit` bytes are flushed
+ */
+typedef struct {
+    char out[64];
+    size_t len;
+    size_t limit;
+} test_writer_out_t;
+
+static lwjsonr_t
+test_writer_collect(lwjson_writer_t* w, const char* data, size_t len) {
+    test_writer_out_t* o = w->arg;
+
+    if (o->len + len > o->limit) {
+        return lwjsonERR;
+    }
+    memcpy(&o->out[o->len], data, len);
+    o->len += len;
+    return lwjsonOK;
+}
+
+static void
+test_writer(void) {
+    lwjson_writer_t w;
+    char buf[256];
+    const char* exp = "{\"s\":\"a\\\"b\\\\c\\n0123456789\\u0001\",\"i\":[0,-1,1234567890,-9223372036854775807],"
+                      "\"r\":[0.5,-2.0,0.1],\"b\":true,\"n\":null,\"o\":{}}";
+
+    printf("...\r\nWriting JSON..\r\n");
+    lwjson_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    lwjson_writer_begin_object(&w);
+    lwjson_writer_key(&w, "s", 1);
+    lwjson_writer_string(&w, "a\"b\\c\n0123456789\x01", 17);
+    lwjson_writer_key(&w, "i", 1);
+    lwjson_writer_begin_array(&w);
+    lwjson_writer_int(&w, 0);
+    lwjson_writer_int(&w, -1);
+    lwjson_writer_int(&w, 1234567890);
+    lwjson_writer_int(&w, -9223372036854775807LL);
+    lwjson_writer_end(&w);
+    lwjson_writer_key(&w, "r", 1);
+    lwjson_writer_begin_array(&w);
+    lwjson_writer_real(&w, 0.5f);
+    lwjson_writer_real(&w, -2.0f);
+    lwjson_writer_real(&w, 0.1f);
+    lwjson_writer_end(&w);
+    lwjson_writer_key(&w, "b", 1);
+    lwjson_writer_bool(&w, 1);
+    lwjson_writer_key(&w, "n", 1);
+    lwjson_writer_null(&w);
+    lwjson_writer_key(&w, "o", 1);
+    lwjson_writer_begin_object(&w);
+    lwjson_writer_end(&w);
+    if (lwjson_writer_end(&w) == lwjsonOK && w.len == strlen(exp) && strncmp(buf, exp, w.len) == 0) {
+        printf("Writer test passed..\r\n");
+    } else {
+        printf("Writer test failed..\r\n");
+    }
+
+    /* Output larger than buffer without flush function */
+    lwjson_writer_init(&w, buf, 4, NULL, NULL);
+    if (lwjson_writer_string(&w, "abcd", 4) == lwjsonERRMEM) {
+        printf("Writer memory test passed..\r\n");
+    } else {
+        printf("Writer memory test failed..\r\n");
+    }
+
+    /* Small buffer is flushed many times, error of flush function stops writer */
+    {
+        test_writer_out_t o = {.len = 0, .limit = sizeof(o.out)};
+        const char* fexp = "{\"key\":[\"value\",123456]}";
+
+        lwjson_writer_init(&w, buf, 5, test_writer_collect, &o);
+        lwjson_writer_begin_object(&w);
+        lwjson_writer_key(&w, "key", 3);
+        lwjson_writer_begin_array(&w);
+        lwjson_writer_string(&w, "value", 5);
+        lwjson_writer_int(&w, 123456);
+        lwjson_writer_end(&w);
+        lwjson_writer_end(&w);
+        if (lwjson_writer_flush(&w) == lwjsonOK && w.err == lwjsonOK && o.len == strlen(fexp)
+            && strncmp(o.out, fexp, o.len) == 0) {
+            printf("Writer flush test passed..\r\n");
+        } else {
+            printf("Writer flush test failed..\r\n");
+        }
+
+        o.len = 0;
+        o.limit = 10;
+        lwjson_writer_init(&w, buf, 5, test_writer_collect, &o);
+        lwjson_writer_begin_object(&w);
+        lwjson_writer_key(&w, "key", 3);
+        lwjson_writer_string(&w, "value", 5);
+        lwjson_writer_end(&w);
+        if (lwjson_writer_flush(&w) == lwjsonERR && w.err == lwjsonERR && o.len <= 10
+            && lwjson_writer_null(&w) == lwjsonERR) {
+            printf("Writer flush error test passed..\r\n");
+        } else {
+            printf("Writer flush error test failed..\r\n");
+        }
+
+        /* Error of final flush only */
+        o.len = 0;
+        o.limit = 3;
+        lwjson_writer_init(&w, buf, sizeof(buf), test_writer_collect, &o);
+        lwjson_writer_begin_array(&w);
+        lwjson_writer_int(&w, 12345);
+        lwjson_writer_end(&w);
+        if (w.err == lwjsonOK && lwjson_writer_flush(&w) == lwjsonERR && w.err == lwjsonERR) {
+            printf("Writer final flush error test passed..\r\n");
+        } else {
+            printf("Writer final flush error test failed..\r\n");
+        }
+    }
+}
+
+static void
+test_serialize(void) {
+    char buf[128];
+    size_t len;
+
+    printf("...\r\nSerializing parsed JSON..\r\n");
+    if (lwjson_parse(&lwjson, "{ \"a\" : [ 1, -2.5, \"x\\\"y\" ],\r\n \"b\": { \"c\": true, \"d\": null, \"e\": {} } }") != lwjsonOK) {
+        printf("Could not parse JSON for serialization..\r\n");
+        return;
+    }
+    lwjson_get_doc(&lwjson, &doc);
+    if (lwjson_serialize(&doc, NULL, buf, sizeof(buf), &len) == lwjsonOK
+        && strcmp(buf, "{\"a\":[1,-2.5,\"x\\\"y\"],\"b\":{\"c\":true,\"d\":null,\"e\":{}}}") == 0 && len == strlen(buf)
+        && lwjson_serialize(&doc, lwjson_doc_find(&doc, "b"), buf, sizeof(buf), &len) == lwjsonOK
+        && strcmp(buf, "{\"c\":true,\"d\":null,\"e\":{}}") == 0
+        && lwjson_serialize(&doc, NULL, buf, 10, &len) == lwjsonERRMEM) {
+        printf("Serialize test passed..\r\n");
+    } else {
+        printf("Serialize test failed..\r\n");
+    }
+    if (lwjson_serialize(&doc, NULL, buf, 1, &len) == lwjsonERRMEM) {
+        printf("Serialize small buffer test passed..\r\n");
+    } else {
+        printf("Serialize small buffer test failed..\r\n");
+    }
+
+    /* Nesting up to writer limit, parser accepts deeper documents */
+    {
+        static char deep[2 * (LWJSON_WRITER_MAX_DEPTH + 1) + 1], out[sizeof(deep)];
+        uint8_t ok = 1;
+
+        for (size_t depth = LWJSON_WRITER_MAX_DEPTH; depth <= LWJSON_WRITER_MAX_DEPTH + 1; ++depth) {
+            memset(deep, '[', depth);
+            memset(&deep[depth], ']', depth);
+            deep[2 * depth] = '\0';
+            if (lwjson_parse(&lwjson, deep) != lwjsonOK) {
+                ok = 0;
+                break;
+            }
+            lwjson_get_doc(&lwjson, &doc);
+            if (depth <= LWJSON_WRITER_MAX_DEPTH) {
+                ok &= lwjson_serialize(&doc, NULL, out, sizeof(out), &len) == lwjsonOK && strcmp(out, deep) == 0;
+            } else {
+                ok &= lwjson_serialize(&doc, NULL, out, sizeof(out), &len) == lwjsonERRMEM;
+            }
+        }
+        if (ok) {
+            printf("Serialize nesting limit test passed..\r\n");
+        } else {
+            printf("Serialize nesting limit test failed..\r\n");
+        }
+    }
+}
+
+#if LWJSON_CFG_TOKEN_SPAN
+static void
+test_token_span(void) {
+    const char* json = "{\"a\": [1, 2.50e1 , {\"b\":\"s\"} ] , \"c\" : \"x\\\"y\"  ,\"d\":true}";
+    const lwjson_token_t* t;
+    const char* raw;
+    size_t len;
+    char buf[64];
+
+    printf("...\r\nChecking token source spans..\r\n");
+    if (lwjson_parse(&lwjson, json) != lwjsonOK) {
+        printf("Could not parse JSON for spans..\r\n");
+        return;
+    }
+    if ((raw = lwjson_get_raw(lwjson_get_first_token(&lwjson), &len)) == json && len == strlen(json)
+        && (raw = lwjson_get_raw(lwjson_find(&lwjson, "a"), &len)) != NULL && strncmp(raw, "[1, 2.50e1 , {\"b\":\"s\"} ]", len) == 0 && len == 24
+        && (t = lwjson_find(&lwjson, "a")) != NULL && (raw = lwjson_get_raw(t->u.first_child->next, &len)) != NULL
+        && len == 6 && strncmp(raw, "2.50e1", len) == 0
+        && (raw = lwjson_get_raw(lwjson_find(&lwjson, "c"), &len)) != NULL && len == 6 && strncmp(raw, "\"x\\\"y\"", len) == 0
+        && (raw = lwjson_get_raw(lwjson_find(&lwjson, "d"), &len)) != NULL && len == 4 && strncmp(raw, "true", len) == 0
+        && lwjson_get_doc(&lwjson, &doc) == lwjsonOK && lwjson_serialize(&doc, t, buf, sizeof(buf), &len) == lwjsonOK && strcmp(buf, "[1,2.50e1,{\"b\":\"s\"}]") == 0) {
+        printf("Token span test passed..\r\n");
+    } else {
+        printf("Token span test failed..\r\n");
+    }
+}
+
+/**
+ * \brief           Apply patch to input and compare output
+ * \param[in]       json: Input JSON
+ * \param[in]       ops: Operations, one character per operation:
+ *                      `s` sets value to `9`, `r` removes token, `i` inserts `"n":0` or `0`
+ * \param[in]       paths: Paths for operations, empty string for top token
+ * \param[in]       exp: Expected output
+ */
+static void
+test_patch_one(const char* json, const char* ops, const char** paths, const char* exp) {
+    lwjson_patch_entry_t entries[8];
+    lwjson_patch_t patch;
+    lwjson_writer_t w;
+    char buf[128];
+
+    if (lwjson_parse(&lwjson, json) != lwjsonOK) {
+        printf("Could not parse JSON for patch..\r\n");
+        return;
+    }
+    lwjson_patch_init(&patch, &lwjson, entries, LWJSON_ARRAYSIZE(entries));
+    for (size_t i = 0; ops[i] != '\0'; ++i) {
+        const lwjson_token_t* t = paths[i][0] == '\0' ? lwjson_get_first_token(&lwjson) : lwjson_find(&lwjson, paths[i]);
+        if (ops[i] == 's') {
+            lwjson_patch_set(&patch, t, "9", 1);
+        } else if (ops[i] == 'r') {
+            lwjson_patch_remove(&patch, t);
+        } else {
+            lwjson_patch_insert(&patch, t, t->type == LWJSON_TYPE_OBJECT ? "n" : NULL, 1, "0", 1);
+        }
+    }
+    lwjson_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    if (lwjson_patch_emit(&patch, &w) == lwjsonOK && w.len == strlen(exp) && strncmp(buf, exp, w.len) == 0) {
+        printf("Patch test passed..\r\n");
+    } else {
+        printf("Patch test failed: \"%.*s\"..\r\n", (int)w.len, buf);
+    }
+}
+
+/**
+ * \brief           Patch long array with entries added in reverse order
+ */
+static void
+test_patch_wide(void) {
+    static lwjson_patch_entry_t entries[1024];
+    static char json[4096], exp[4096], out[4096];
+    static const lwjson_token_t* tokens_arr[1000];
+    const lwjson_token_t* t;
+    size_t len = 0, exp_len = 0;
+    lwjson_patch_t patch;
+    lwjson_writer_t w;
+
+    /* Remove odd and last elements, replace every 100th one, insert before third one and append two */
+    for (unsigned i = 0; i < 1000; ++i) {
+        len += (size_t)sprintf(&json[len], "%c%u", i > 0 ? ',' : '[', i);
+        if (i == 2) {
+            exp_len += (size_t)sprintf(&exp[exp_len], ",7");
+        }
+        if (i % 2 == 0 && i < 990) {
+            exp_len += (size_t)sprintf(&exp[exp_len], i % 100 ? ",%u" : ",-1", i);
+        }
+    }
+    sprintf(&json[len], "]");
+    sprintf(&exp[exp_len], ",1000,1001]");
+    exp[0] = '[';
+    lwjson_parse(&lwjson, json);
+    lwjson_patch_init(&patch, &lwjson, entries, LWJSON_ARRAYSIZE(entries));
+    lwjson_patch_insert(&patch, lwjson_get_first_token(&lwjson), NULL, 0, "1000", 4);
+    for (t = lwjson_get_first_token(&lwjson)->u.first_child, len = 0; t != NULL; t = t->next) {
+        tokens_arr[len++] = t;
+    }
+    for (unsigned i = 1000; i-- > 0;) {
+        t = tokens_arr[i];
+        if (i % 2 == 1 || i >= 990) {
+            lwjson_patch_remove(&patch, t);
+        } else if (i % 100 == 0) {
+            lwjson_patch_set(&patch, t, "-1", 2);
+        } else if (i == 2) {
+            lwjson_patch_insert_before(&patch, t, NULL, 0, "7", 1);
+        }
+    }
+    lwjson_patch_insert(&patch, lwjson_get_first_token(&lwjson), NULL, 0, "1001", 4);
+    lwjson_writer_init(&w, out, sizeof(out), NULL, NULL);
+    if (lwjson_patch_emit(&patch, &w) == lwjsonOK && w.len == strlen(exp) && strncmp(out, exp, w.len) == 0) {
+        printf("Patch wide test passed..\r\n");
+    } else {
+        printf("Patch wide test failed: \"%.*s\"..\r\n", (int)w.len, out);
+    }
+}
+
+static void
+test_patch(void) {
+    printf("...\r\nPatching parsed JSON..\r\n");
+    test_patch_one("{\"a\": 1, \"b\": [1, 2, 3], \"c\": {\"d\": true}}", "s", (const char*[]){"b"},
+                   "{\"a\": 1, \"b\": 9, \"c\": {\"d\": true}}");
+    test_patch_one("{\"a\": 1, \"b\": 2, \"c\": 3}", "r", (const char*[]){"b"}, "{\"a\": 1, \"c\": 3}");
+    test_patch_one("{\"a\": 1, \"b\": 2, \"c\": 3}", "r", (const char*[]){"c"}, "{\"a\": 1, \"b\": 2}");
+    test_patch_one("{\"a\": 1, \"b\": 2, \"c\": 3}", "rr", (const char*[]){"b", "c"}, "{\"a\": 1}");
+    test_patch_one("{\"a\": 1, \"b\": 2, \"c\": 3}", "rrr", (const char*[]){"a", "b", "c"}, "{}");
+    test_patch_one("{\"a\": 1, \"b\": 2}", "rsi", (const char*[]){"a", "a", ""}, "{\"b\": 2,\"n\":0}");
+    test_patch_one("{\"a\": [], \"b\": {\"c\": 1}}", "iir", (const char*[]){"a", "a", "b.c"}, "{\"a\": [0,0], \"b\": {}}");
+    test_patch_one("{\"a\": {\"x\": 1}}", "si", (const char*[]){"a", "a"}, "{\"a\": 9}");
+
+    /* Modification of removed array element, both start at the same position */
+    {
+        lwjson_patch_entry_t entries[2];
+        lwjson_patch_t patch;
+        lwjson_writer_t w;
+        char buf[32];
+
+        lwjson_parse(&lwjson, "[1, 2]");
+        lwjson_patch_init(&patch, &lwjson, entries, LWJSON_ARRAYSIZE(entries));
+        lwjson_patch_set(&patch, lwjson_get_first_token(&lwjson)->u.first_child, "5", 1);
+        lwjson_patch_remove(&patch, lwjson_get_first_token(&lwjson)->u.first_child);
+        lwjson_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+        if (lwjson_patch_emit(&patch, &w) == lwjsonOK && w.len == 3 && strncmp(buf, "[2]", 3) == 0) {
+            printf("Patch test passed..\r\n");
+        } else {
+            printf("Patch test failed: \"%.*s\"..\r\n", (int)w.len, buf);
+        }
+    }    test_patch_wide();
+}
+
+/**
+ * \brief           Apply RFC 6902 operations and compare emitted output
+ * \param[in]       json: Target JSON text
+ * \param[in]       ops: JSON patch text
+ * \param[in]       exp: Expected output, `NULL` if apply must fail
+ */
+static void
+test_json_patch_one(const char* json, const char* ops, const char* exp) {
+    static lwjson_token_t ops_tokens[64], scratch_tokens[64];
+    const lwjson_token_t* root;
+    lwjson_t lw_ops, scratch;
+    lwjson_doc_t ops_doc;
+    lwjson_writer_t w;
+    lwjsonr_t res;
+    char buf[128], work[256];
+
+    lwjson_init(&lw_ops, ops_tokens, LWJSON_ARRAYSIZE(ops_tokens));
+    lwjson_init(&scratch, scratch_tokens, LWJSON_ARRAYSIZE(scratch_tokens));
+    lwjson_parse(&lwjson, json);
+    lwjson_parse(&lw_ops, ops);
+    lwjson_get_doc(&lw_ops, &ops_doc);
+    lwjson_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    res = lwjson_json_patch_apply(&lwjson, &ops_doc, &scratch, work, sizeof(work), &w);
+    root = lwjson_get_first_token(&lwjson);
+    if (w.err != lwjsonOK) {
+        res = w.err;
+    }
+    if (root->token_raw == json && (exp == NULL ? res != lwjsonOK
+                    : (res == lwjsonOK && w.len == strlen(exp) && strncmp(buf, exp, w.len) == 0))) {
+        printf("JSON patch test passed..\r\n");
+    } else {
+        printf("JSON patch test failed: \"%s\" with \"%s\"..\r\n", json, ops);
+    }
+}
+
+static void
+test_json_patch(void) {
+    printf("...\r\nApplying JSON patch..\r\n");
+    test_json_patch_one("{\"a\": 1, \"b\": 2}", "[{\"op\":\"replace\",\"path\":\"/a\",\"value\":[3]}]",
+                        "{\"a\": [3], \"b\": 2}");
+    test_json_patch_one("{\"a\": 1, \"b\": 2}", "[{\"op\":\"remove\",\"path\":\"/a\"}]", "{\"b\": 2}");
+    test_json_patch_one("{\"a\": 1}", "[{\"op\":\"add\",\"path\":\"/c\",\"value\":true}]",
+                        "{\"a\": 1,\"c\":true}");
+    test_json_patch_one("{\"a\": [1, 2]}", "[{\"op\":\"add\",\"path\":\"/a/1\",\"value\":5}]",
+                        "{\"a\": [1, 5,2]}");
+    test_json_patch_one("{\"a\": [1, 2]}", "[{\"op\":\"add\",\"path\":\"/a/-\",\"value\":5}]",
+                        "{\"a\": [1, 2,5]}");
+    test_json_patch_one("{\"a/b\": 1, \"c\": {}}", "[{\"op\":\"move\",\"from\":\"/a~1b\",\"path\":\"/c/d\"}]",
+                        "{\"c\": {\"d\":1}}");
+    test_json_patch_one("{\"a\": {\"x\": 1.0}, \"b\": 1}",
+                        "[{\"op\":\"test\",\"path\":\"/a\",\"value\":{\"x\":1}},{\"op\":\"copy\",\"from\":\"/a\",\"path\":\"/b\"}]",
+                        "{\"a\": {\"x\": 1.0}, \"b\": {\"x\": 1.0}}");
+    test_json_patch_one("{\"a\": 1}", "[{\"op\":\"test\",\"path\":\"/a\",\"value\":2}]", NULL);
+    test_json_patch_one("{\"a\": 1}", "[{\"op\":\"remove\",\"path\":\"/b\"}]", NULL);
+    test_json_patch_one("{\"a\": 1}", "[{\"op\":\"swap\",\"path\":\"/a\"}]", NULL);
+
+    /* Every operation sees result of previous ones */
+    test_json_patch_one("{\"a\":[1,2,3]}",
+                        "[{\"op\":\"remove\",\"path\":\"/a/0\"},{\"op\":\"remove\",\"path\":\"/a/0\"}]",
+                        "{\"a\":[3]}");
+    test_json_patch_one("{\"x\":1}",
+                        "[{\"op\":\"replace\",\"path\":\"/x\",\"value\":2},{\"op\":\"replace\",\"path\":\"/x\",\"value\":3}]",
+                        "{\"x\":3}");
+    test_json_patch_one("{}",
+                        "[{\"op\":\"add\",\"path\":\"/a\",\"value\":{}},{\"op\":\"add\",\"path\":\"/a/b\",\"value\":1}]",
+                        "{\"a\":{\"b\":1}}");
+    test_json_patch_one("{\"x\":1}",
+                        "[{\"op\":\"replace\",\"path\":\"/x\",\"value\":2},{\"op\":\"test\",\"path\":\"/x\",\"value\":2}]",
+                        "{\"x\":2}");
+    test_json_patch_one("{\"x\":1}",
+                        "[{\"op\":\"replace\",\"path\":\"/x\",\"value\":2},{\"op\":\"test\",\"path\":\"/x\",\"value\":1}]",
+                        NULL);
+    test_json_patch_one("{\"a\":[1],\"b\":2}",
+                        "[{\"op\":\"move\",\"from\":\"/b\",\"path\":\"/a/0\"},{\"op\":\"copy\",\"from\":\"/a\",\"path\":\"/b\"}]",
+                        "{\"a\":[2,1],\"b\":[2,1]}");
+    test_json_patch_one("{\"a\":{\"b\":{}}}", "[{\"op\":\"move\",\"from\":\"/a\",\"path\":\"/a/b/c\"}]", NULL);
+
+    /* Move target is resolved after source is removed */
+    test_json_patch_one("{\"a\":[1,2,3]}", "[{\"op\":\"move\",\"from\":\"/a/0\",\"path\":\"/a/2\"}]",
+                        "{\"a\":[2,3,1]}");
+    test_json_patch_one("{\"a\":[1,2,3]}", "[{\"op\":\"move\",\"from\":\"/a/0\",\"path\":\"/a/1\"}]",
+                        "{\"a\":[2,1,3]}");
+    test_json_patch_one("{\"a\":[1,2,3]}", "[{\"op\":\"move\",\"from\":\"/a/1\",\"path\":\"/a/1\"}]",
+                        "{\"a\":[1,2,3]}");
+    test_json_patch_one("{\"a\":[1,2,3]}", "[{\"op\":\"move\",\"from\":\"/a/2\",\"path\":\"/a/0\"}]",
+                        "{\"a\":[3,1,2]}");
+    test_json_patch_one("{\"a\":[1,2,3]}", "[{\"op\":\"move\",\"from\":\"/a/0\",\"path\":\"/a/-\"}]",
+                        "{\"a\":[2,3,1]}");
+    test_json_patch_one("{\"a\":[1,2,3]}", "[{\"op\":\"move\",\"from\":\"/a/0\",\"path\":\"/a/3\"}]", NULL);
+
+    /* Operations on unrelated values share one pass, dependent ones start new pass */
+    test_json_patch_one("{\"a\":[1],\"b\":{\"c\":2}}",
+                        "[{\"op\":\"add\",\"path\":\"/a/-\",\"value\":2},{\"op\":\"add\",\"path\":\"/a/-\",\"value\":3},"
+                        "{\"op\":\"remove\",\"path\":\"/b/c\"},{\"op\":\"add\",\"path\":\"/b/c\",\"value\":4},"
+                        "{\"op\":\"remove\",\"path\":\"/a/0\"}]",
+                        "{\"a\":[2,3],\"b\":{\"c\":4}}");
+    test_json_patch_one("{\"a\":{\"b\":{}},\"ab\":1}", "[{\"op\":\"move\",\"from\":\"/a\",\"path\":\"/ab\"}]",
+                        "{\"ab\":{\"b\":{}}}");
+    test_json_patch_one("{\"a\":1}", "[{\"op\":\"add\",\"path\":\"/b\",\"value\":\"0123456789012345678901234567890123456789"
+                        "01234567890123456789012345678901234567890123456789012345678901234567890123456789\"}]", NULL);
+}
+#endif /* LWJSON_CFG_TOKEN_SPAN */
+
+/**
+ * \brief           Apply merge patch and compare written output
+ * \param[in]       json: Target JSON text
+ * \param[in]       patch: Merge patch JSON text
+ * \param[in]       exp: Expected compact output
+ */
+static void
+test_merge_patch_one(const char* json, const char* patch, const char* exp) {
+    static lwjson_token_t patch_tokens[32];
+    lwjson_t lw_patch;
+    lwjson_doc_t patch_doc;
+    lwjson_writer_t w;
+    char buf[128];
+
+    lwjson_init(&lw_patch, patch_tokens, LWJSON_ARRAYSIZE(patch_tokens));
+    lwjson_parse(&lwjson, json);
+    lwjson_parse(&lw_patch, patch);
+    lwjson_get_doc(&lwjson, &doc);
+    lwjson_get_doc(&lw_patch, &patch_doc);
+    lwjson_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    if (lwjson_merge_patch(&doc, &patch_doc, &w) == lwjsonOK && w.len == strlen(exp)
+        && strncmp(buf, exp, w.len) == 0) {
+        printf("Merge patch test passed..\r\n");
+    } else {
+        printf("Merge patch test failed: \"%.*s\"..\r\n", (int)w.len, buf);
+    }
+}
+
+/**
+ * \brief           Get separator to write before next member of JSON text being built
+ */
+static const char*
+test_sep(const char* text, size_t len) {
+    return text[len - 1] == '{' || text[len - 1] == ',' ? "" : ",";
+}
+
+/**
+ * \brief           Merge objects wider than the smallest hash table, nested in each other
+ *
+ * Target has members `k0` to `k39` on top and in object `o`. Patch sets every member
+ * with index divisible by `3` to `-1` when it is even and removes it when it is odd.
+ */
+static void
+test_merge_patch_wide(void) {
+    static lwjson_token_t patch_tokens[256];
+    static char json[1024], patch[1024], exp[1024], buf[1024];
+    size_t json_len = 0, patch_len = 0, exp_len = 0;
+    lwjson_t lw_patch;
+    lwjson_doc_t patch_doc;
+    lwjson_writer_t w;
+
+    for (size_t lvl = 0; lvl < 2; ++lvl) {
+        const char* open = lvl == 0 ? "{\"o\":{" : "},";
+
+        json_len += (size_t)sprintf(&json[json_len], "%s", open);
+        patch_len += (size_t)sprintf(&patch[patch_len], "%s", open);
+        exp_len += (size_t)sprintf(&exp[exp_len], "%s", open);
+        for (unsigned i = 0; i < 40; ++i) {
+            json_len += (size_t)sprintf(&json[json_len], "%s\"k%u\":%u", test_sep(json, json_len), i, i);
+            if (i % 3 == 0) {
+                patch_len += (size_t)sprintf(&patch[patch_len], "%s\"k%u\":%s", test_sep(patch, patch_len), i,
+                                             i % 2 ? "null" : "-1");
+            }
+            if (i % 6 != 3) {
+                exp_len += (size_t)sprintf(&exp[exp_len], "%s\"k%u\":%d", test_sep(exp, exp_len), i,
+                                           i % 3 == 0 ? -1 : (int)i);
+            }
+        }
+    }
+    sprintf(&json[json_len], "}");
+    sprintf(&patch[patch_len], ",\"n\":1}");
+    sprintf(&exp[exp_len], ",\"n\":1}");
+
+    lwjson_init(&lw_patch, patch_tokens, LWJSON_ARRAYSIZE(patch_tokens));
+    lwjson_parse(&lwjson, json);
+    lwjson_parse(&lw_patch, patch);
+    lwjson_get_doc(&lwjson, &doc);
+    lwjson_get_doc(&lw_patch, &patch_doc);
+    lwjson_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    if (lwjson_merge_patch(&doc, &patch_doc, &w) == lwjsonOK && w.len == strlen(exp) && strncmp(buf, exp, w.len) == 0) {
+        printf("Merge patch wide test passed..\r\n");
+    } else {
+        printf("Merge patch wide test failed: \"%.*s\"..\r\n", (int)w.len, buf);
+    }
+}
+
+static void
+test_merge_patch(void) {
+    printf("...\r\nApplying JSON merge patch..\r\n");
+    test_merge_patch_one("{\"a\":\"b\"}", "{\"a\":\"c\"}", "{\"a\":\"c\"}");
+    test_merge_patch_one("{\"a\":\"b\"}", "{\"b\":\"c\"}", "{\"a\":\"b\",\"b\":\"c\"}");
+    test_merge_patch_one("{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}", "{\"b\":\"c\"}");
+    test_merge_patch_one("{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}", "{\"a\":[1]}");
+    test_merge_patch_one("[1,2]", "{\"a\":\"b\",\"c\":null}", "{\"a\":\"b\"}");
+    test_merge_patch_one("{\"e\":null}", "{\"a\":1}", "{\"e\":null,\"a\":1}");
+    test_merge_patch_one("{\"a\":{\"b\":1,\"c\":2}}", "{\"a\":{\"b\":{\"d\":null,\"x\":3},\"c\":null}}",
+                         "{\"a\":{\"b\":{\"x\":3}}}");
+    test_merge_patch_one("{}", "{\"a\":{\"bb\":{\"c\":null}}}", "{\"a\":{\"bb\":{}}}");
+    test_merge_patch_wide();
+}
+
+static void
+test_minify_prettify(void) {
+    const char* json = "{ \"a\" : [ 1 , 2 ],\r\n\t\"b \\\" c\\\\\" : { },\"d\":{\"e\":null}}";
+    const char* pretty = "{\n  \"a\": [\n    1,\n    2\n  ],\n  \"b \\\" c\\\\\": {},\n  \"d\": {\n    \"e\": null\n  }\n}";
+    char buf[128];
+    size_t len;
+    lwjson_writer_t w;
+
+    printf("...\r\nMinify and prettify JSON text..\r\n");
+    strcpy(buf, json);
+    if (lwjson_minify(buf, strlen(buf), buf, &len) == lwjsonOK
+        && len == 40 && strncmp(buf, "{\"a\":[1,2],\"b \\\" c\\\\\":{},\"d\":{\"e\":null}}", len) == 0
+        && lwjson_minify("{\"a\":\"b}", 8, buf, &len) == lwjsonERRJSON) {
+        printf("Minify test passed..\r\n");
+    } else {
+        printf("Minify test failed..\r\n");
+    }
+    lwjson_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    if (lwjson_prettify(json, strlen(json), &w, 2) == lwjsonOK
+        && w.len == strlen(pretty) && strncmp(buf, pretty, w.len) == 0) {
+        printf("Prettify test passed..\r\n");
+    } else {
+        printf("Prettify test failed..\r\n");
+    }
+}
+
+/**
+ * \brief           Collect differences as text, one `op path` per line
+ */
+static lwjsonr_t
+test_diff_collect(lwjson_diff_op_t op, const char* path, size_t path_len, const lwjson_token_t* a,
+                  const lwjson_token_t* b, void* arg) {
+    char* out = arg;
+    size_t len = strlen(out);
+
+    (void)a;
+    (void)b;
+    sprintf(&out[len], "%c%.*s;", op == LWJSON_DIFF_ADDED ? '+' : op == LWJSON_DIFF_REMOVED ? '-' : '~', (int)path_len, path);
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Diff two JSON texts and compare reported paths and written patch
+ * \param[in]       json_a: First JSON text
+ * \param[in]       json_b: Second JSON text
+ * \param[in]       exp: Expected differences, see \ref test_diff_collect
+ * \param[in]       exp_patch: Expected JSON patch
+ */
+static void
+test_diff_one(const char* json_a, const char* json_b, const char* exp, const char* exp_patch) {
+    static lwjson_token_t b_tokens[32];
+    lwjson_t lw_b;
+    lwjson_doc_t doc_b;
+    lwjson_writer_t w;
+    char buf[256], out[128] = "";
+
+    lwjson_init(&lw_b, b_tokens, LWJSON_ARRAYSIZE(b_tokens));
+    lwjson_parse(&lwjson, json_a);
+    lwjson_parse(&lw_b, json_b);
+    lwjson_get_doc(&lwjson, &doc);
+    lwjson_get_doc(&lw_b, &doc_b);
+    lwjson_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    if (lwjson_diff(&doc, &doc_b, test_diff_collect, out) == lwjsonOK && strcmp(out, exp) == 0
+        && lwjson_diff_write_patch(&doc, &doc_b, &w) == lwjsonOK && w.len == strlen(exp_patch)
+        && strncmp(buf, exp_patch, w.len) == 0) {
+        printf("Diff test passed..\r\n");
+    } else {
+        printf("Diff test failed: \"%s\", \"%.*s\"..\r\n", out, (int)w.len, buf);
+    }
+}
+
+/**
+ * \brief           Count differences reported by diff
+ */
+static lwjsonr_t
+test_diff_count(lwjson_diff_op_t op, const char* path, size_t path_len, const lwjson_token_t* a,
+                const lwjson_token_t* b, void* arg) {
+    (void)op;
+    (void)path;
+    (void)path_len;
+    (void)a;
+    (void)b;
+    ++*(size_t*)arg;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Check that removed elements are reported with descending indexes down to `1`
+ */
+static lwjsonr_t
+test_diff_descending(lwjson_diff_op_t op, const char* path, size_t path_len, const lwjson_token_t* a,
+                     const lwjson_token_t* b, void* arg) {
+    char idx[8];
+    long* next = arg;
+
+    (void)b;
+    if (op != LWJSON_DIFF_REMOVED || path_len < 2 || path_len > sizeof(idx)) {
+        return lwjsonERR;
+    }
+    sprintf(idx, "%.*s", (int)(path_len - 1), &path[1]); /* Path is not zero terminated */
+    if (strtol(idx, NULL, 10) != *next || a->u.num_int != *next) {
+        return lwjsonERR;
+    }
+    --*next;
+    return lwjsonOK;
+}
+
+/**
+ * \brief           Diff long arrays and objects wider than the smallest hash table
+ */
+static void
+test_diff_wide(void) {
+    static lwjson_token_t b_tokens[256];
+    static char json_a[4096], json_b[1024];
+    size_t len_a = 0, len_b = 0, diffs = 0;
+    long next = 999;
+    lwjson_t lw_b;
+    lwjson_doc_t doc_b;
+
+    /* 1000 elements to 1 */
+    len_a = (size_t)sprintf(json_a, "[0");
+    for (unsigned i = 1; i < 1000; ++i) {
+        len_a += (size_t)sprintf(&json_a[len_a], ",%u", i);
+    }
+    sprintf(&json_a[len_a], "]");
+    lwjson_init(&lw_b, b_tokens, LWJSON_ARRAYSIZE(b_tokens));
+    lwjson_parse(&lwjson, json_a);
+    lwjson_parse(&lw_b, "[0]");
+    lwjson_get_doc(&lwjson, &doc);
+    lwjson_get_doc(&lw_b, &doc_b);
+    if (lwjson_diff(&doc, &doc_b, test_diff_descending, &next) == lwjsonOK && next == 0) {
+        printf("Diff trailing removal test passed..\r\n");
+    } else {
+        printf("Diff trailing removal test failed at %ld..\r\n", next);
+    }
+
+    /* 40 members, every fourth one changed in second document */
+    len_a = len_b = 1;
+    json_a[0] = json_b[0] = '{';
+    for (unsigned i = 0; i < 40; ++i) {
+        len_a += (size_t)sprintf(&json_a[len_a], "%s\"k%u\":%u", i > 0 ? "," : "", i, i);
+        len_b += (size_t)sprintf(&json_b[len_b], "%s\"k%u\":%u", i > 0 ? "," : "", 39 - i, i % 4 ? 39 - i : 0);
+    }
+    sprintf(&json_a[len_a], "}");
+    sprintf(&json_b[len_b], "}");
+    lwjson_parse(&lwjson, json_a);
+    lwjson_parse(&lw_b, json_b);
+    lwjson_get_doc(&lwjson, &doc);
+    lwjson_get_doc(&lw_b, &doc_b);
+    if (lwjson_diff(&doc, &doc_b, test_diff_count, &diffs) == lwjsonOK && diffs == 10) {
+        printf("Diff wide object test passed..\r\n");
+    } else {
+        printf("Diff wide object test failed with %u differences..\r\n", (unsigned)diffs);
+    }
+}
+
+static void
+test_diff(void) {
+    printf("...\r\nDiff of parsed JSON..\r\n");
+    test_diff_one("{\"a\":1,\"b\":[1,2]}", "{\"a\":1.0,\"b\":[1,2]}", "", "[]");
+    test_diff_one("{\"a\":1,\"b\":2}", "{\"b\":3,\"c\":true}", "-/a;~/b;+/c;",
+                  "[{\"op\":\"remove\",\"path\":\"/a\"},{\"op\":\"replace\",\"path\":\"/b\",\"value\":3},"
+                  "{\"op\":\"add\",\"path\":\"/c\",\"value\":true}]");
+    test_diff_one("{\"a/b\":{\"c~\":[1,2,3]}}", "{\"a/b\":{\"c~\":[1]}}", "-/a~1b/c~0/2;-/a~1b/c~0/1;",
+                  "[{\"op\":\"remove\",\"path\":\"/a~1b/c~0/2\"},{\"op\":\"remove\",\"path\":\"/a~1b/c~0/1\"}]");
+    test_diff_one("{\"a\":[1]}", "{\"a\":[1,{\"x\":null}]}", "+/a/1;",
+                  "[{\"op\":\"add\",\"path\":\"/a/1\",\"value\":{\"x\":null}}]");
+    test_diff_one("{\"a\":[1]}", "[1]", "~;", "[{\"op\":\"replace\",\"path\":\"\",\"value\":[1]}]");
+    test_diff_one("{\"a\\/b\":1,\"\\u0041\":2,\"q\\\"\":3}", "{\"a\\/b\":2}", "~/a~1b;-/A;-/q\";",
+                  "[{\"op\":\"replace\",\"path\":\"/a~1b\",\"value\":2},{\"op\":\"remove\",\"path\":\"/A\"},"
+                  "{\"op\":\"remove\",\"path\":\"/q\\\"\"}]");
+    test_diff_wide();
+}
+
+/**
+ * \brief           Check binary output against expected bytes
+ */
+static uint8_t
+test_binary_check(const char* out, size_t len, const char* expected, size_t expected_len) {
+    return len == expected_len && memcmp(out, expected, len) == 0;
+}
+
+static void
+test_binary(void) {
+    const char* json = "{\"a\":1,\"b\":[true,null,-2,300,-1000],\"c\":\"x\\ny\\u00e9\\ud83d\\ude00\",\"d\":1.5,\"e\":{}}";
+    static const char cbor[] = "\xA5\x61\x61\x01\x61\x62\x85\xF5\xF6\x21\x19\x01\x2C\x39\x03\xE7"
+                               "\x61\x63\x69x\ny\xC3\xA9\xF0\x9F\x98\x80\x61\x64\xFA\x3F\xC0\x00\x00\x61\x65\xA0";
+    static const char cbor_stream[] = "\xBF\x61\x61\x01\x61\x62\x9F\xF5\xF6\x21\x19\x01\x2C\x39\x03\xE7\xFF"
+                                      "\x61\x63\x69x\ny\xC3\xA9\xF0\x9F\x98\x80\x61\x64\xFA\x3F\xC0\x00\x00\x61\x65\xBF\xFF\xFF";
+    static const char msgpack[] = "\x85\xA1\x61\x01\xA1\x62\x95\xC3\xC0\xFE\xCD\x01\x2C\xD1\xFC\x18"
+                                  "\xA1\x63\xA9x\ny\xC3\xA9\xF0\x9F\x98\x80\xA1\x64\xCA\x3F\xC0\x00\x00\xA1\x65\x80";
+    char out[128];
+    lwjson_writer_t w;
+    size_t len = 0, pre_len = 0;
+    uint8_t ok = 1;
+
+    printf("...\r\nEncoding CBOR and MessagePack..\r\n");
+    if (lwjson_parse(&lwjson, json) != lwjsonOK || lwjson_get_doc(&lwjson, &doc) != lwjsonOK) {
+        printf("Binary encoding test failed..\r\n");
+        return;
+    }
+    lwjson_writer_init(&w, out, sizeof(out), NULL, NULL);
+    ok = ok && lwjson_to_cbor(&doc, NULL, NULL, &pre_len) == lwjsonOK && lwjson_to_cbor(&doc, NULL, &w, &len) == lwjsonOK
+         && len == pre_len && test_binary_check(out, w.len, cbor, sizeof(cbor) - 1);
+    lwjson_writer_init(&w, out, sizeof(out), NULL, NULL);
+    ok = ok && lwjson_to_msgpack(&doc, NULL, NULL, &pre_len) == lwjsonOK
+         && lwjson_to_msgpack(&doc, NULL, &w, &len) == lwjsonOK && len == pre_len
+         && test_binary_check(out, w.len, msgpack, sizeof(msgpack) - 1);
+    lwjson_writer_init(&w, out, sizeof(out), NULL, NULL);
+    ok = ok && lwjson_json_to_cbor(json, strlen(json), &w) == lwjsonOK
+         && test_binary_check(out, w.len, cbor_stream, sizeof(cbor_stream) - 1);
+    lwjson_writer_init(&w, out, sizeof(out), NULL, NULL);
+    ok = ok && lwjson_json_to_cbor("[1.25e2, -0, 18446744073709551616]", 34, &w) == lwjsonOK
+         && test_binary_check(out, w.len, "\x9F\xFA\x42\xFA\x00\x00\x00\xFA\x5F\x80\x00\x00\xFF", 13);
+    lwjson_writer_init(&w, out, sizeof(out), NULL, NULL);
+    ok = ok && lwjson_json_to_cbor("[1,{\"a\":2]}", 11, &w) == lwjsonERRJSON;
+    lwjson_writer_init(&w, out, sizeof(out), NULL, NULL);
+    ok = ok && lwjson_json_to_cbor("[\"ab\\\"]", 7, &w) == lwjsonERRJSON;
+    lwjson_writer_init(&w, out, sizeof(out), NULL, NULL);
+    ok = ok && lwjson_json_to_cbor("[tru]", 5, &w) == lwjsonERRJSON;
+
+    /* Double precision number out of single precision range */
+    lwjson_writer_init(&w, out, sizeof(out), NULL, NULL);
+    ok = ok && lwjson_json_to_cbor("[1e300,-1e300]", 14, &w) == lwjsonOK
+         && test_binary_check(out, w.len, "\x9F\xFB\x7E\x37\xE4\x3C\x88\x00\x75\x9C\xFB\xFE\x37\xE4\x3C\x88\x00\x75\x9C\xFF",
+                              20);
+
+    /* Nesting up to writer limit */
+    {
+        static char deep[2 * (LWJSON_WRITER_MAX_DEPTH + 1)], deep_out[sizeof(deep)];
+
+        memset(deep, '[', LWJSON_WRITER_MAX_DEPTH + 1);
+        memset(&deep[LWJSON_WRITER_MAX_DEPTH + 1], ']', LWJSON_WRITER_MAX_DEPTH + 1);
+        lwjson_writer_init(&w, deep_out, sizeof(deep_out), NULL, NULL);
+        ok = ok && lwjson_json_to_cbor(deep, sizeof(deep), &w) == lwjsonERRMEM;
+        lwjson_writer_init(&w, deep_out, sizeof(deep_out), NULL, NULL);
+        ok = ok && lwjson_json_to_cbor(&deep[1], sizeof(deep) - 2, &w) == lwjsonOK
+             && w.len == 2 * LWJSON_WRITER_MAX_DEPTH;
+    }
+    if (ok) {
+        printf("Binary encoding test passed..\r\n");
+    } else {
+        printf("Binary encoding test failed..\r\n");
+    }
+}
+
+/**
+ * \brief           Strings with quotes, backslashes and control characters must survive
+ *                  JSON to binary to JSON round trip, in names and in values
+ */
+static uint8_t
+test_binary_escaped(void) {
+    const char* json = "{\"q\\\"k\":\"v\\\"1\",\"b\\\\s\":[\"x\\\\y\",\"\\n\\t\\u001f\"],\"plain\":\"\\\"\\\\\"}";
+    static lwjson_token_t btokens[16];
+    static char bin[128], bin2[128], esc[64], out[128];
+    lwjson_writer_t w;
+    lwjson_doc_t bdoc;
+    lwjson_t blw;
+    size_t len = 0, bin_len = 0, diffs = 0;
+    uint8_t ok;
+
+    lwjson_init(&blw, btokens, LWJSON_ARRAYSIZE(btokens));
+    ok = lwjson_parse(&lwjson, json) == lwjsonOK && lwjson_get_doc(&lwjson, &doc) == lwjsonOK;
+    for (size_t i = 0; i < 2 && ok; ++i) {
+        lwjson_writer_init(&w, bin, sizeof(bin), NULL, NULL);
+        if (i == 0) {
+            ok = lwjson_to_cbor(&doc, NULL, &w, &bin_len) == lwjsonOK
+                 && lwjson_parse_cbor(&blw, bin, bin_len, NULL, 0) == lwjsonERRMEM
+                 && lwjson_parse_cbor(&blw, bin, bin_len, esc, 8) == lwjsonERRMEM
+                 && lwjson_parse_cbor(&blw, bin, bin_len, esc, sizeof(esc)) == lwjsonOK;
+        } else {
+            ok = lwjson_to_msgpack(&doc, NULL, &w, &bin_len) == lwjsonOK
+                 && lwjson_parse_msgpack(&blw, bin, bin_len, esc, sizeof(esc)) == lwjsonOK;
+        }
+
+        /* Same tokens as text, same text from writer and same binary output again */
+        ok = ok && lwjson_get_doc(&blw, &bdoc) == lwjsonOK && lwjson_diff(&doc, &bdoc, test_diff_count, &diffs) == lwjsonOK
+             && diffs == 0 && lwjson_serialize(&bdoc, NULL, out, sizeof(out), &len) == lwjsonOK && len == strlen(json)
+             && strncmp(out, json, len) == 0;
+        lwjson_writer_init(&w, bin2, sizeof(bin2), NULL, NULL);
+        ok = ok && (i == 0 ? lwjson_to_cbor : lwjson_to_msgpack)(&bdoc, NULL, &w, NULL) == lwjsonOK
+             && test_binary_check(bin2, w.len, bin, bin_len);
+        ok = ok && lwjson_find(&blw, "q\\\"k") != NULL;
+    }
+    return ok;
+}
+
+static void
+test_binary_parse(void) {
+    const char* json = "{\"a\":1,\"b\":[true,false,null,-2,300,-100000,[],{}],\"c\":\"text\",\"d\":1.5,\"e\":{\"f\":[0.1]}}";
+    static lwjson_token_t btokens[64];
+    static char out[256];
+    lwjson_doc_t bdoc;
+    lwjson_writer_t w;
+    lwjson_t blw;
+    size_t diffs = 0, len = 0;
+    uint8_t ok = 1;
+#if LWJSON_CFG_TOKEN_SPAN
+    lwjson_patch_entry_t entries[1];
+    lwjson_patch_t patch;
+#endif /* LWJSON_CFG_TOKEN_SPAN */
+
+    printf("...\r\nParsing CBOR and MessagePack..\r\n");
+    lwjson_init(&blw, btokens, LWJSON_ARRAYSIZE(btokens));
+    if (lwjson_parse(&lwjson, json) != lwjsonOK || lwjson_get_doc(&lwjson, &doc) != lwjsonOK) {
+        printf("Binary parse test failed..\r\n");
+        return;
+    }
+
+    /* Encoded document must decode to the same tokens */
+    for (size_t i = 0; i < 3 && ok; ++i) {
+        lwjson_writer_init(&w, out, sizeof(out), NULL, NULL);
+        if (i == 0) {
+            ok = lwjson_to_cbor(&doc, NULL, &w, NULL) == lwjsonOK && lwjson_parse_cbor(&blw, out, w.len, NULL, 0) == lwjsonOK;
+        } else if (i == 1) {
+            ok = lwjson_json_to_cbor(json, strlen(json), &w) == lwjsonOK && lwjson_parse_cbor(&blw, out, w.len, NULL, 0) == lwjsonOK;
+        } else {
+            ok = lwjson_to_msgpack(&doc, NULL, &w, NULL) == lwjsonOK && lwjson_parse_msgpack(&blw, out, w.len, NULL, 0) == lwjsonOK;
+        }
+        ok = ok && lwjson_get_doc(&blw, &bdoc) == lwjsonOK && lwjson_diff(&doc, &bdoc, test_diff_count, &diffs) == lwjsonOK
+             && diffs == 0 && lwjson_get_tokens_used(&blw) == lwjson_get_tokens_used(&lwjson);
+        ok = ok && (i < 2 ? lwjson_parse_cbor : lwjson_parse_msgpack)(&blw, out, w.len - 1, NULL, 0) == lwjsonERRJSON;
+    }
+
+    /* Binary input has no text span, numbers are written from their values */
+    ok = ok && lwjson_parse(&lwjson, "{\"x\":12345,\"y\":1.5}") == lwjsonOK && lwjson_get_doc(&lwjson, &doc) == lwjsonOK;
+    lwjson_writer_init(&w, out, 128, NULL, NULL);
+    ok = ok && lwjson_to_cbor(&doc, NULL, &w, NULL) == lwjsonOK && lwjson_parse_cbor(&blw, out, w.len, NULL, 0) == lwjsonOK
+         && lwjson_get_doc(&blw, &bdoc) == lwjsonOK && lwjson_serialize(&bdoc, NULL, &out[128], 128, &len) == lwjsonOK
+         && strcmp(&out[128], "{\"x\":12345,\"y\":1.5}") == 0;
+#if LWJSON_CFG_TOKEN_SPAN
+    ok = ok && lwjson_get_raw(bdoc.root, NULL) == NULL && lwjson_patch_init(&patch, &blw, entries, 1) == lwjsonERR;
+#endif /* LWJSON_CFG_TOKEN_SPAN */
+
+    /* Half float, tag, undefined and large integers */
+    ok = ok && lwjson_parse_cbor(&blw, "\xA2\x61h\xF9\x3E\x00\x61t\x83\xC1\x1A\x00\x01\x00\x00\xF7\x1B\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF", 25, NULL, 0) == lwjsonOK
+         && lwjson_find(&blw, "h")->u.num_real == 1.5 && lwjson_find(&blw, "t")->u.first_child->u.num_int == 65536
+         && lwjson_find(&blw, "t")->u.first_child->next->type == LWJSON_TYPE_NULL
+         && lwjson_find(&blw, "t")->u.first_child->next->next->type == LWJSON_TYPE_NUM_REAL;
+    ok = ok && lwjson_parse_msgpack(&blw, "\x93\xD0\x80\xD1\xFF\x7F\xC4\x02\x00\x01", 10, out, sizeof(out)) == lwjsonOK
+         && blw.first_token.u.first_child->u.num_int == -128 && blw.first_token.u.first_child->next->u.num_int == -129
+         && blw.first_token.u.first_child->next->next->u.str.token_value_len == 12
+         && !strncmp(blw.first_token.u.first_child->next->next->u.str.token_value, "\\u0000\\u0001", 12);
+
+    /* Invalid input */
+    ok = ok && lwjson_parse_cbor(&blw, "\xA1\x01\x02", 3, NULL, 0) == lwjsonERRJSON         /* Integer key */
+         && lwjson_parse_cbor(&blw, "\x01", 1, NULL, 0) == lwjsonERRJSON                    /* Top item is not container */
+         && lwjson_parse_cbor(&blw, "\x9F\x7F\x61\x61\xFF\xFF", 6, NULL, 0) == lwjsonERRJSON  /* Chunked string */
+         && lwjson_parse_cbor(&blw, "\x80\x00", 2, NULL, 0) == lwjsonERR                  /* Data after top item */
+         && lwjson_parse_msgpack(&blw, "\x91\xD4\x01\x00", 4, NULL, 0) == lwjsonERRJSON;     /* Extension type */
+    lwjson_init(&blw, btokens, 2);
+    ok = ok && lwjson_parse_msgpack(&blw, "\x93\x01\x02\x03", 4, NULL, 0) == lwjsonERRMEM;
+    ok = ok && test_binary_escaped();
+    if (ok) {
+        printf("Binary parse test passed..\r\n");
+    } else {
+        printf("Binary parse test failed..\r\n");
+    }
+}
+
+/**
+ * \brief           Count records and sum of `id` members, parse errors are counted as negative
+ */
+static lwjsonr_t
+test_ndjson_count(lwjsonr_t res, const lwjson_doc_t* d, const char* rec, size_t rec_len, void* arg) {
+    long* cnt = arg;
+    const lwjson_token_t* t;
+
+    (void)rec;
+    (void)rec_len;
+    if (res != lwjsonOK) {
+        cnt[1] -= 1000;
+    } else if ((t = lwjson_doc_find(d, "id")) != NULL && t->type == LWJSON_TYPE_NUM_INT) {
+        ++cnt[0];
+        cnt[1] += (long)t->u.num_int;
+    }
+    return lwjsonOK;
+}
+
+#if LWJSON_CFG_PARALLEL_THREADS
+static uint8_t test_ndjson_seen[2000];
+
+/**
+ * \brief           Mark record with `id` member as seen, called from many threads
+ */
+static lwjsonr_t
+test_ndjson_mark(lwjsonr_t res, const lwjson_doc_t* d, const char* rec, size_t rec_len, void* arg) {
+    const lwjson_token_t* t;
+
+    (void)rec;
+    (void)rec_len;
+    (void)arg;
+    if (res == lwjsonOK && (t = lwjson_doc_find(d, "id")) != NULL && t->type == LWJSON_TYPE_NUM_INT
+        && t->u.num_int >= 0 && t->u.num_int < (lwjson_int_t)sizeof(test_ndjson_seen)) {
+        ++test_ndjson_seen[t->u.num_int];
+    }
+    return lwjsonOK;
+}
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+
+static void
+test_ndjson(void) {
+    const char* nd = "{\"id\":1}\n\n  \r\n[1]\r\n{\"id\":2,\"s\":\"a\\nb\"}\n{\"id\":\n{\"id\":4}";
+    long cnt[2] = {0, 0};
+
+    printf("...\r\nParsing newline delimited JSON..\r\n");
+    if (lwjson_parse_ex(&lwjson, "[1,2]xyz", 5) == lwjsonOK && lwjson_parse_ex(&lwjson, "{\"a\":1}", 6) == lwjsonERRJSON
+        && lwjson_parse_ex(&lwjson, "{\"a\":tru", 8) == lwjsonERRJSON) {
+        printf("Parse with length test passed..\r\n");
+    } else {
+        printf("Parse with length test failed..\r\n");
+    }
+    if (lwjson_ndjson_parse(&lwjson, nd, strlen(nd), test_ndjson_count, cnt) == lwjsonOK
+        && cnt[0] == 3 && cnt[1] == 1 + 2 + 4 - 1000) {
+        printf("NDJSON test passed..\r\n");
+    } else {
+        printf("NDJSON test failed: %ld, %ld..\r\n", cnt[0], cnt[1]);
+    }
+    {
+        lwjson_lines_t it;
+        lwjsonr_t res;
+        long sum = 0;
+
+        /* Malformed record is reported first, then skipped */
+        lwjson_lines_init(&it, nd, strlen(nd), 0);
+        while ((res = lwjson_lines_next(&it, &lwjson)) == lwjsonOK) {}
+        if (res == lwjsonERRJSON && it.line == 6 && it.rec_len == 6
+            && lwjson_lines_next(&it, &lwjson) == lwjsonOK && lwjson_find(&lwjson, "id")->u.num_int == 4
+            && lwjson_lines_next(&it, &lwjson) == lwjsonEND) {
+            lwjson_lines_init(&it, nd, strlen(nd), 1);
+            while (lwjson_lines_next(&it, &lwjson) == lwjsonOK) {
+                const lwjson_token_t* t = lwjson_find(&lwjson, "id");
+
+                sum += t != NULL ? (long)t->u.num_int : 100;
+            }
+        }
+        if (sum == 1 + 100 + 2 + 4 && it.errors == 1 && it.line == 7) {
+            printf("NDJSON lines iterator test passed..\r\n");
+        } else {
+            printf("NDJSON lines iterator test failed..\r\n");
+        }
+    }
+    {
+        const char* seq = "{\"a\":[1,{\"b\":\"}]\\\"\"}]}[2]\"s\\\\\"12 true\x1E{\"c\":\x1E\"x\x1E\n\x1E{\"id\":9}\n";
+        const char* expected[] = {"{\"a\":[1,{\"b\":\"}]\\\"\"}]}", "[2]", "\"s\\\\\"", "12", "true", "{\"c\":", "\"x", "{\"id\":9}"};
+        const lwjsonr_t expected_res[] = {lwjsonOK, lwjsonOK, lwjsonOK, lwjsonOK, lwjsonOK, lwjsonERRJSON, lwjsonERRJSON, lwjsonOK};
+        lwjson_split_t sp;
+        const char* val;
+        size_t val_len, cnt = 0;
+        lwjsonr_t res;
+        uint8_t ok = 1;
+
+        lwjson_split_init(&sp, seq, strlen(seq));
+        while ((res = lwjson_split_next(&sp, &val, &val_len)) != lwjsonEND && cnt < LWJSON_ARRAYSIZE(expected)) {
+            if (res != expected_res[cnt] || val_len != strlen(expected[cnt])
+                || strncmp(val, expected[cnt], val_len) != 0
+                || (res == lwjsonOK && (*val == '{' || *val == '[')
+                    && lwjson_parse_ex(&lwjson, val, val_len) != lwjsonOK)) {
+                ok = 0;
+            }
+            ++cnt;
+        }
+        if (ok && res == lwjsonEND && cnt == LWJSON_ARRAYSIZE(expected)) {
+            printf("JSON sequence split test passed..\r\n");
+        } else {
+            printf("JSON sequence split test failed..\r\n");
+        }
+    }
+#if LWJSON_CFG_PARALLEL_THREADS
+    {
+        static char buf[2000 * 24];
+        size_t len = 0, missing = 0;
+
+        for (size_t i = 0; i < LWJSON_ARRAYSIZE(test_ndjson_seen); ++i) {
+            len += (size_t)sprintf(&buf[len], "{\"id\":%u,\"v\":[1,2]}\n", (unsigned)i);
+        }
+        memset(test_ndjson_seen, 0x00, sizeof(test_ndjson_seen));
+        if (lwjson_ndjson_parse_parallel(buf, len, 4, test_ndjson_mark, NULL) == lwjsonOK) {
+            for (size_t i = 0; i < LWJSON_ARRAYSIZE(test_ndjson_seen); ++i) {
+                missing += test_ndjson_seen[i] != 1;
+            }
+        }
+        if (missing == 0 && test_ndjson_seen[0] == 1) {
+            printf("Parallel NDJSON test passed..\r\n");
+        } else {
+            printf("Parallel NDJSON test failed..\r\n");
+        }
+    }
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+}
+
+#if LWJSON_CFG_PARALLEL_THREADS
+/**
+ * \brief           Parse large array with multiple threads and compare with single thread result
+ * \param[in]       nested: Set to `1` to have nested arrays of objects, where split candidates fail
+ */
+static void
+test_parse_parallel_one(uint8_t nested) {
+    static char buf[400 * 1024];
+    static lwjson_token_t ptokens[16384], stokens[10240];
+    lwjson_t plw, slw;
+    lwjson_doc_t pdoc, sdoc;
+    const lwjson_token_t* t;
+    size_t len = 1, cnt = 0, diffs = 0;
+
+    buf[0] = '[';
+    for (size_t i = 0; i < 1200; ++i) {
+        len += (size_t)sprintf(&buf[len], "%s {\"id\":%u,\"s\":\"%0200u\",\"a\":%s}", i > 0 ? "," : "", (unsigned)i,
+                               (unsigned)i, nested ? "[{\"b\":1} ,{\"b\":\"},{\"}]" : "[1,2,3,4]");
+    }
+    len += (size_t)sprintf(&buf[len], "]\n");
+    lwjson_init(&plw, ptokens, LWJSON_ARRAYSIZE(ptokens));
+    lwjson_init(&slw, stokens, LWJSON_ARRAYSIZE(stokens));
+    if (lwjson_parse_parallel(&plw, buf, len, 4) == lwjsonOK && lwjson_parse_ex(&slw, buf, len) == lwjsonOK
+        && lwjson_get_doc(&plw, &pdoc) == lwjsonOK && lwjson_get_doc(&slw, &sdoc) == lwjsonOK
+        && lwjson_diff(&pdoc, &sdoc, test_diff_count, &diffs) == lwjsonOK && diffs == 0
+        && lwjson_get_tokens_used(&plw) == lwjson_get_tokens_used(&slw)) {
+        for (t = pdoc.root->u.first_child; t != NULL && t->parent == pdoc.root; t = t->next, ++cnt) {}
+    }
+    if (cnt == 1200 && lwjson_parse_parallel(&plw, buf, len - 3, 4) != lwjsonOK) {
+        printf("Parallel parse test passed..\r\n");
+    } else {
+        printf("Parallel parse test failed..\r\n");
+    }
+}
+
+/**
+ * \brief           Parse array with `},{` inside strings, split candidates must be outside of strings
+ */
+static void
+test_parse_parallel_strings(void) {
+    static char buf[400 * 1024];
+    static lwjson_token_t ptokens[16384];
+    lwjson_t plw;
+    const lwjson_token_t* t, *last = NULL;
+    size_t len = 1, cnt = 0;
+
+    buf[0] = '[';
+    for (size_t i = 0; i < 1200; ++i) {
+        len += (size_t)sprintf(&buf[len], "%s{\"id\":%u,\"s\":\"", i > 0 ? "," : "", (unsigned)i);
+        for (size_t k = 0; k < 30; ++k) {
+            len += (size_t)sprintf(&buf[len], "\\\"},{\\\"");
+        }
+        len += (size_t)sprintf(&buf[len], "\",\"t\":\"\\\\\"}");
+    }
+    len += (size_t)sprintf(&buf[len], "]");
+    lwjson_init(&plw, ptokens, LWJSON_ARRAYSIZE(ptokens));
+    if (lwjson_parse_parallel(&plw, buf, len, 4) == lwjsonOK) {
+        for (t = lwjson_get_first_token(&plw)->u.first_child; t != NULL; last = t, t = t->next, ++cnt) {}
+    }
+
+    /* Without fallback to single thread, last element is in token slice of the last part */
+    if (cnt == 1200 && last >= &ptokens[LWJSON_ARRAYSIZE(ptokens) * 3 / 4]) {
+        printf("Parallel parse strings test passed..\r\n");
+    } else {
+        printf("Parallel parse strings test failed..\r\n");
+    }
+}
+
+static void
+test_parse_parallel(void) {
+    printf("...\r\nParsing large array with multiple threads..\r\n");
+    test_parse_parallel_one(0);
+    test_parse_parallel_one(1);
+    test_parse_parallel_strings();
+}
+
+static void
+test_parse_pipelined(void) {
+    static char buf[300 * 1024];
+    static lwjson_token_t ptokens[8192], stokens[8192];
+    lwjson_t plw, slw;
+    lwjson_doc_t pdoc, sdoc;
+    size_t len = 1, diffs = 0;
+
+    printf("...\r\nParsing with pipelined string scanner..\r\n");
+    buf[0] = '{';
+    for (size_t i = 0; i < 2000; ++i) {
+        len += (size_t)sprintf(&buf[len], "%s\"k%u\":{\"s\":\"%0100u\\\"\\\\\",\"e\":\"\"}", i > 0 ? "," : "", (unsigned)i, (unsigned)i);
+    }
+    len += (size_t)sprintf(&buf[len], "}");
+    lwjson_init(&plw, ptokens, LWJSON_ARRAYSIZE(ptokens));
+    lwjson_init(&slw, stokens, LWJSON_ARRAYSIZE(stokens));
+    if (lwjson_parse_pipelined(&plw, buf, len) == lwjsonOK && lwjson_parse_ex(&slw, buf, len) == lwjsonOK
+        && lwjson_get_doc(&plw, &pdoc) == lwjsonOK && lwjson_get_doc(&slw, &sdoc) == lwjsonOK
+        && lwjson_diff(&pdoc, &sdoc, test_diff_count, &diffs) == lwjsonOK && diffs == 0
+        && lwjson_doc_find(&pdoc, "k1999.s")->u.str.token_value_len == 104
+        && lwjson_parse_pipelined(&plw, buf, len - 1) == lwjsonERRJSON) {
+        buf[len / 2] = '"';                     /* Breaks pairing of quotes */
+        if (lwjson_parse_pipelined(&plw, buf, len) != lwjsonOK) {
+            printf("Pipelined parse test passed..\r\n");
+            return;
+        }
+    }
+    printf("Pipelined parse test failed..\r\n");
+}
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+
+#if LWJSON_CFG_POOL
+static lwjson_pool_t pool;
+static lwjson_pool_item_t pool_items[4];
+static lwjson_token_t pool_tokens[4 * 16];
+
+#if LWJSON_CFG_PARALLEL_THREADS
+#include <pthread.h>
+
+/**
+ * \brief           Acquire, parse and release parser instances from many threads
+ */
+static void*
+test_pool_thread(void* arg) {
+    size_t* errors = arg;
+
+    for (size_t i = 0; i < 20000; ++i) {
+        lwjson_t* lw = lwjson_pool_acquire(&pool);
+        if (lw == NULL) {
+            continue;                           /* All instances in use by other threads */
+        }
+        if (lwjson_parse(lw, "{\"a\":[1,2,3]}") != lwjsonOK || lwjson_get_tokens_used(lw) != 5
+            || lwjson_find(lw, "a")->u.first_child->next->u.num_int != 2) {
+            ++*errors;
+        }
+        lwjson_pool_release(&pool, lw);
+    }
+    lwjson_pool_flush(&pool);
+    return NULL;
+}
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+
+static void
+test_pool(void) {
+    lwjson_t* lw[5];
+    size_t errors = 0;
+
+    printf("...\r\nParser instance pool..\r\n");
+    lwjson_pool_init(&pool, pool_items, LWJSON_ARRAYSIZE(pool_items), pool_tokens, 16);
+    for (size_t i = 0; i < LWJSON_ARRAYSIZE(lw); ++i) {
+        lw[i] = lwjson_pool_acquire(&pool);
+    }
+    if (lw[0] != NULL && lw[3] != NULL && lw[4] == NULL && ((uintptr_t)lw[1] % LWJSON_CFG_CACHE_LINE) == 0
+        && lwjson_parse(lw[0], "{\"a\":1}") == lwjsonOK && lwjson_pool_release(&pool, lw[0]) == lwjsonOK
+        && !lw[0]->flags.parsed && lw[0]->tokens[0].token_name == NULL
+        && lwjson_pool_acquire(&pool) == lw[0] && lwjson_pool_release(&pool, &lwjson) == lwjsonERR) {
+        printf("Pool test passed..\r\n");
+    } else {
+        printf("Pool test failed..\r\n");
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        lwjson_pool_release(&pool, lw[i]);
+    }
+    lwjson_pool_flush(&pool);
+#if LWJSON_CFG_PARALLEL_THREADS
+    {
+        pthread_t threads[6];
+        size_t thread_errors[6] = {0};
+
+        for (size_t i = 0; i < LWJSON_ARRAYSIZE(threads); ++i) {
+            pthread_create(&threads[i], NULL, test_pool_thread, &thread_errors[i]);
+        }
+        for (size_t i = 0; i < LWJSON_ARRAYSIZE(threads); ++i) {
+            pthread_join(threads[i], NULL);
+            errors += thread_errors[i];
+        }
+    }
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+    for (size_t i = 0; i < LWJSON_ARRAYSIZE(lw); ++i) {
+        lw[i] = lwjson_pool_acquire(&pool);
+    }
+    if (errors == 0 && lw[3] != NULL && lw[4] == NULL) {
+        printf("Pool reuse test passed..\r\n");
+    } else {
+        printf("Pool reuse test failed..\r\n");
+    }
+}
+#endif /* LWJSON_CFG_POOL */
+
+#if LWJSON_CFG_PARALLEL_THREADS || LWJSON_CFG_TAPE || LWJSON_CFG_ZLIB
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static char test_tmp_dir[256];
+
+/**
+ * \brief           Get path of file in temporary directory of this test run
+ *
+ * Directory is created in `TMPDIR`, or `/tmp` when not set, on first use and removed by \ref test_tmp_cleanup.
+ * Tests remove their own files.
+ *
+ * \param[out]      buf: Output path buffer
+ * \param[in]       buf_len: Size of buffer
+ * \param[in]       name: File name
+ * \return          `buf`
+ */
+static const char*
+test_tmp_path(char* buf, size_t buf_len, const char* name) {
+    if (test_tmp_dir[0] == '\0') {
+        const char* tmp = getenv("TMPDIR");
+
+        snprintf(test_tmp_dir, sizeof(test_tmp_dir), "%s/lwjson_test_%ld", tmp != NULL && tmp[0] != '\0' ? tmp : "/tmp",
+                 (long)getpid());
+        mkdir(test_tmp_dir, 0700);
+    }
+    snprintf(buf, buf_len, "%s/%s", test_tmp_dir, name);
+    return buf;
+}
+
+/**
+ * \brief           Remove temporary directory of this test run
+ */
+static void
+test_tmp_cleanup(void) {
+    if (test_tmp_dir[0] != '\0') {
+        rmdir(test_tmp_dir);
+        test_tmp_dir[0] = '\0';
+    }
+}
+#endif /* LWJSON_CFG_PARALLEL_THREADS || LWJSON_CFG_TAPE || LWJSON_CFG_ZLIB */
+
+#if LWJSON_CFG_TAPE
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * \brief           Count differences between tape token and parsed token, including children
+ */
+static size_t
+test_tape_diff(const lwjson_tape_t* tape, const lwjson_tape_token_t* tt, const lwjson_token_t* t) {
+    const lwjson_tape_token_t* tc;
+    const lwjson_token_t* c;
+    const char* str;
+    size_t len, diffs = 0;
+
+    if (tt == NULL || t == NULL || tt->type != (uint32_t)t->type) {
+        return 1;
+    }
+    str = lwjson_tape_get_name(tape, tt, &len);
+    if ((str == NULL) != (t->token_name == NULL)
+        || (str != NULL && (len != t->token_name_len || strncmp(str, t->token_name, len) != 0))) {
+        return 1;
+    }
+    switch (t->type) {
+        case LWJSON_TYPE_STRING:
+            str = lwjson_tape_get_val_string(tape, tt, &len);
+            return str == NULL || len != t->u.str.token_value_len || strncmp(str, t->u.str.token_value, len) != 0;
+        case LWJSON_TYPE_NUM_INT: return tt->u.num_int != (int64_t)t->u.num_int;
+        case LWJSON_TYPE_NUM_REAL: return tt->u.num_real != (double)t->u.num_real;
+        case LWJSON_TYPE_OBJECT:
+        case LWJSON_TYPE_ARRAY:
+            for (tc = lwjson_tape_get_first_child(tape, tt), c = t->u.first_child; c != NULL || tc != NULL;
+                 tc = lwjson_tape_get_next(tape, tc), c = c != NULL ? c->next : NULL) {
+                diffs += test_tape_diff(tape, tc, c);
+                if (tc == NULL || c == NULL || lwjson_tape_get_token(tape, tc->parent) != tt) {
+                    return diffs + 1;
+                }
+            }
+            return diffs;
+        default: return 0;
+    }
+}
+
+static void
+test_tape(void) {
+    char path_buf[320];
+    const char* path = test_tmp_path(path_buf, sizeof(path_buf), "lwjson_tape.bin");
+    lwjson_tape_t tape;
+    uint8_t ok = 0;
+    int fd;
+
+    printf("...\r\nSaving and loading token tree tape..\r\n");
+    if (lwjson_parse(&lwjson, json_complete) != lwjsonOK || lwjson_get_doc(&lwjson, &doc) != lwjsonOK
+        || (fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600)) < 0) {
+        printf("Tape test failed..\r\n");
+        return;
+    }
+    if (lwjson_tape_save(&doc, fd) == lwjsonOK) {
+        close(fd);
+
+        /* Input text and tokens are not needed after tape is saved */
+        lwjson_parse(&lwjson, "[1]");
+        if ((fd = open(path, O_RDONLY)) >= 0 && lwjson_tape_load(&tape, fd) == lwjsonOK) {
+            close(fd);
+            lwjson_parse(&lwjson, json_complete);
+            ok = tape.tokens_len == lwjson_get_tokens_used(&lwjson)
+                 && test_tape_diff(&tape, lwjson_tape_get_first_token(&tape), lwjson_get_first_token(&lwjson)) == 0;
+            lwjson_tape_close(&tape);
+        }
+        ok = ok && lwjson_tape_open(&tape, "LWJT", 4) == lwjsonERRJSON;
+    }
+    unlink(path);
+    if (ok) {
+        printf("Tape test passed..\r\n");
+    } else {
+        printf("Tape test failed..\r\n");
+    }
+}
+
+static void
+test_tape_shared(void) {
+    static uint64_t mem[1024];
+    const lwjson_tape_token_t* tt;
+    size_t len = 0, errors = 0;
+    lwjson_tape_t tape;
+    int fd, status;
+    pid_t pid;
+
+    printf("...\r\nSharing token tree tape..\r\n");
+    if (lwjson_parse(&lwjson, json_complete) != lwjsonOK || lwjson_get_doc(&lwjson, &doc) != lwjsonOK
+        || lwjson_tape_export(&doc, NULL, 0, &len) != lwjsonOK || len > sizeof(mem)
+        || lwjson_tape_export(&doc, mem, len - 1, &len) != lwjsonERRMEM
+        || lwjson_tape_export(&doc, mem, sizeof(mem), &len) != lwjsonOK
+        || lwjson_tape_open(&tape, mem, len) != lwjsonOK) {
+        printf("Tape export test failed..\r\n");
+        return;
+    }
+
+    /* Find on tape must give the same results as on token tree */
+    for (size_t i = 0; i < LWJSON_ARRAYSIZE(paths_types); ++i) {
+        const lwjson_token_t* t = lwjson_find(&lwjson, paths_types[i].path);
+
+        tt = lwjson_tape_find(&tape, paths_types[i].path);
+        errors += tt == NULL || t == NULL || test_tape_diff(&tape, tt, t) != 0;
+    }
+    errors += lwjson_tape_find(&tape, "int.num4") != NULL || lwjson_tape_find(&tape, "#") != NULL;
+    if (lwjson_parse(&lwjson, "{\"a\":[{\"k\":1},{\"k\":2,\"m\":[{\"x\":3}]}]}") != lwjsonOK
+        || lwjson_get_doc(&lwjson, &doc) != lwjsonOK || lwjson_tape_export(&doc, mem, sizeof(mem), &len) != lwjsonOK
+        || lwjson_tape_open(&tape, mem, len) != lwjsonOK) {
+        ++errors;
+    }
+    if (errors == 0) {
+        /* Relative search and typed accessors */
+        const lwjson_tape_token_t* arr = lwjson_tape_find(&tape, "a");
+
+        errors += lwjson_tape_get_val_int(lwjson_tape_find_ex(&tape, arr, "#.m.#.x")) != 3
+                  || lwjson_tape_find_ex(&tape, lwjson_tape_get_first_child(&tape, arr), "k") != lwjson_tape_find(&tape, "a.#.k")
+                  || lwjson_tape_find_ex(&tape, arr, "k") != NULL || lwjson_tape_find_ex(&tape, NULL, "a") != NULL
+                  || lwjson_tape_get_val_int(arr) != 0 || lwjson_tape_get_val_real(lwjson_tape_find(&tape, "a.#.k")) != 0;
+    }
+    if (errors == 0 && (tt = lwjson_tape_find(&tape, "a.#.m.#.x")) != NULL && lwjson_tape_get_val_int(tt) == 3) {
+        printf("Tape find test passed..\r\n");
+    } else {
+        printf("Tape find test failed..\r\n");
+    }
+
+    /* Other process maps the same memory */
+    lwjson_parse(&lwjson, json_complete);
+    lwjson_get_doc(&lwjson, &doc);
+    if (lwjson_tape_share(&doc, "lwjson_test", &fd) != lwjsonOK) {
+        printf("Tape share test failed..\r\n");
+        return;
+    }
+    if ((pid = fork()) == 0) {
+        uint8_t ok = lwjson_tape_load(&tape, fd) == lwjsonOK && (tt = lwjson_tape_find(&tape, "int.num2")) != NULL
+                     && tt->u.num_int == -1234;
+        _exit(ok ? 0 : 1);
+    }
+    if (pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0
+        && write(fd, "x", 1) < 0) {
+        printf("Tape share test passed..\r\n");
+    } else {
+        printf("Tape share test failed..\r\n");
+    }
+    close(fd);
+}
+#endif /* LWJSON_CFG_TAPE */
+
+#if LWJSON_CFG_PARALLEL_THREADS
+/**
+ * \brief           Store result and `id` member of every file, called from many threads
+ */
+static lwjsonr_t
+test_batch_files_store(size_t index, lwjsonr_t res, const lwjson_doc_t* d, void* arg) {
+    long* out = arg;
+    const lwjson_token_t* t;
+
+    if (res != lwjsonOK) {
+        out[index] = -(long)res;
+    } else if ((t = lwjson_doc_find(d, "id")) != NULL && t->type == LWJSON_TYPE_NUM_INT) {
+        out[index] = (long)t->u.num_int;
+    }
+    return lwjsonOK;
+}
+
+static void
+test_batch_files(void) {
+    static const char* names[] = {"lwjson_batch_0.json", "lwjson_batch_1.json", "lwjson_batch_2.json",
+                                  "lwjson_batch_3.json", "lwjson_batch_4.json", "lwjson_batch_missing.json"};
+    char path_buf[LWJSON_ARRAYSIZE(names)][320];
+    const char* paths[LWJSON_ARRAYSIZE(names)];
+    long out[LWJSON_ARRAYSIZE(paths)] = {0};
+    uint8_t ok = 1;
+
+    printf("...\r\nParsing batch of files..\r\n");
+    for (size_t i = 0; i < LWJSON_ARRAYSIZE(names); ++i) {
+        paths[i] = test_tmp_path(path_buf[i], sizeof(path_buf[i]), names[i]);
+    }
+    for (size_t i = 0; i + 1 < LWJSON_ARRAYSIZE(paths); ++i) {
+        FILE* f = fopen(paths[i], "wb");
+
+        if (f == NULL) {
+            printf("Batch files test failed: cannot create %s..\r\n", paths[i]);
+            return;
+        }
+        if (i == 3) {
+            fprintf(f, "{\"id\":");
+        } else {
+            fprintf(f, "{\"id\":%u,\"list\":[1,2,3],\"s\":\"text\"}\n", (unsigned)(i + 10));
+        }
+        fclose(f);
+    }
+    if (lwjson_batch_files(paths, LWJSON_ARRAYSIZE(paths), 3, test_batch_files_store, out) != lwjsonOK) {
+        ok = 0;
+    }
+    for (size_t i = 0; i + 1 < LWJSON_ARRAYSIZE(paths); ++i) {
+        remove(paths[i]);
+        if (out[i] != (i == 3 ? -(long)lwjsonERRJSON : (long)(i + 10))) {
+            ok = 0;
+        }
+    }
+    if (ok && out[5] == -(long)lwjsonERR) {
+        printf("Batch files test passed..\r\n");
+    } else {
+        printf("Batch files test failed..\r\n");
+    }
+}
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+
+#if LWJSON_CFG_ZLIB
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+/**
+ * \brief           Parse gzip compressed newline delimited JSON from file
+ * \param[in]       path: File path
+ * \param[out]      cnt: Record count and sum of `id` members
+ * \return          Parse result
+ */
+static lwjsonr_t
+test_gz_ndjson_file(const char* path, long* cnt) {
+    lwjsonr_t res;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return lwjsonERR;
+    }
+    cnt[0] = cnt[1] = 0;
+    res = lwjson_gz_ndjson_parse(&lwjson, fd, test_ndjson_count, cnt);
+    close(fd);
+    return res;
+}
+
+static void
+test_gz_ndjson(void) {
+    char path_buf[320];
+    const char* path = test_tmp_path(path_buf, sizeof(path_buf), "lwjson_gz_test.json.gz");
+    long cnt[2], sum = 0;
+    unsigned recs = 0;
+    gzFile gz;
+
+    printf("...\r\nParsing gzip compressed newline delimited JSON..\r\n");
+
+    /* Records of different lengths cross window ends, input ends without newline */
+    if ((gz = gzopen(path, "wb")) == NULL) {
+        printf("Gzip NDJSON test failed: cannot create %s..\r\n", path);
+        return;
+    }
+    for (unsigned i = 0; i < 20000; ++i) {
+        gzprintf(gz, "%s{\"id\":%u,\"s\":\"%.*s\",\"list\":[1,2,3]}", i > 0 ? "\n" : "", i, (int)(i % 97),
+                 "0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789");
+        sum += (long)i;
+        ++recs;
+        if (i % 1000 == 0) {
+            gzprintf(gz, "\n\r\n{\"id\":");
+            sum -= 1000;
+        }
+    }
+    gzclose(gz);
+    if (test_gz_ndjson_file(path, cnt) == lwjsonOK && cnt[0] == (long)recs && cnt[1] == sum) {
+        printf("Gzip NDJSON test passed..\r\n");
+    } else {
+        printf("Gzip NDJSON test failed..\r\n");
+    }
+
+    /* Same input cut in half, records before the cut are parsed and error is returned */
+    {
+        static char half[1 << 20];
+        size_t half_len = 0;
+        FILE* f;
+
+        if ((f = fopen(path, "rb")) != NULL) {
+            half_len = fread(half, 1, sizeof(half), f) / 2;
+            fclose(f);
+        }
+        if ((f = fopen(path, "wb")) != NULL) {
+            fwrite(half, 1, half_len, f);
+            fclose(f);
+        }
+        if (half_len > 0 && test_gz_ndjson_file(path, cnt) == lwjsonERR && cnt[0] > 0 && cnt[0] < (long)recs) {
+            printf("Gzip NDJSON truncated input test passed..\r\n");
+        } else {
+            printf("Gzip NDJSON truncated input test failed..\r\n");
+        }
+    }
+
+    /* Record that does not fit into window */
+    if ((gz = gzopen(path, "wb")) != NULL) {
+        gzprintf(gz, "{\"id\":1}\n{\"s\":\"");
+        for (size_t i = 0; i < 2 * LWJSON_CFG_INFLATE_WINDOW; ++i) {
+            gzputc(gz, 'a');
+        }
+        gzprintf(gz, "\"}\n{\"id\":2}\n");
+        gzclose(gz);
+    }
+    if (test_gz_ndjson_file(path, cnt) == lwjsonERRMEM && cnt[0] == 1) {
+        printf("Gzip NDJSON long record test passed..\r\n");
+    } else {
+        printf("Gzip NDJSON long record test failed..\r\n");
+    }
+
+    /* Uncompressed input is parsed as it is */
+    if ((gz = gzopen(path, "wbT")) != NULL) {
+        gzprintf(gz, "{\"id\":5}\n{\"id\":6}\n");
+        gzclose(gz);
+    }
+    if (test_gz_ndjson_file(path, cnt) == lwjsonOK && cnt[0] == 2 && cnt[1] == 11) {
+        printf("Gzip NDJSON uncompressed test passed..\r\n");
+    } else {
+        printf("Gzip NDJSON uncompressed test failed..\r\n");
+    }
+    remove(path);
+}
+#endif /* LWJSON_CFG_ZLIB */
+
 void
 test_run(void) {
     /* Init LwJSON */
@@ -179,6 +1849,7 @@ test_run(void) {
     test_parse(lwjsonOK, "{\"k\":null}");
     test_parse(lwjsonOK, "{\"k\":\"Stringgg\"}");
     test_parse(lwjsonOK, "{\"k\":\"Stri\\\"nggg with quote inside\"}");
+    test_parse(lwjsonOK, "{\"k\":\"Escaped backslash at the end\\\\\"}");
     test_parse(lwjsonOK, "{\"k\":{\"b\":1E5,\t\r\n\"c\":1.3E5\r\n}\r\n}");
 
     /* Run JSON tests to fail */
@@ -191,6 +1862,8 @@ test_run(void) {
     test_parse(lwjsonERRJSON, "{\"k\"1}");      /* Missing separator */
     test_parse(lwjsonERRJSON, "{k:1}");         /* Property name must be string */
     test_parse(lwjsonERRJSON, "{k:0.}");        /* Wrong number format */
+    test_parse(lwjsonERRJSON, "{\"k\":{}");      /* Top object not closed */
+    test_parse(lwjsonERRJSON, "[1, 2");         /* Top array not closed */
 
     /* Run token count tests */
     test_token_count(2, "{\"k\":1}");
@@ -205,4 +1878,49 @@ test_run(void) {
 
     /* Parse input text and compare against expected data types */
     test_json_data_types();
+
+    /* Bulk extraction of numeric arrays */
+    test_array_to();
+
+    /* Bind JSON to structures */
+    test_bind();
+
+    /* JSON writer */
+    test_writer();
+    test_serialize();
+    test_minify_prettify();
+
+    /* Binary formats */
+    test_binary();
+    test_binary_parse();
+
+    /* Patching */
+    test_merge_patch();
+    test_diff();
+
+    /* Newline delimited JSON */
+    test_ndjson();
+#if LWJSON_CFG_PARALLEL_THREADS
+    test_parse_parallel();
+    test_parse_pipelined();
+    test_batch_files();
+#endif /* LWJSON_CFG_PARALLEL_THREADS */
+#if LWJSON_CFG_ZLIB
+    test_gz_ndjson();
+#endif /* LWJSON_CFG_ZLIB */
+#if LWJSON_CFG_POOL
+    test_pool();
+#endif /* LWJSON_CFG_POOL */
+#if LWJSON_CFG_TAPE
+    test_tape();
+    test_tape_shared();
+#endif /* LWJSON_CFG_TAPE */
+#if LWJSON_CFG_TOKEN_SPAN
+    test_token_span();
+    test_patch();
+    test_json_patch();
+#endif /* LWJSON_CFG_TOKEN_SPAN */
+#if LWJSON_CFG_PARALLEL_THREADS || LWJSON_CFG_TAPE || LWJSON_CFG_ZLIB
+    test_tmp_cleanup();
+#endif /* LWJSON_CFG_PARALLEL_THREADS || LWJSON_CFG_TAPE || LWJSON_CFG_ZLIB */
 }
\ No newline at end of file
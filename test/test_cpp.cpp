@@ -0,0 +1,188 @@
+/*
+ * Tests of C++ wrapper, built as separate test application for C++17 and C++20
+ *
+ * Every test prints its result, CTest marks run as failed when any line reports failure.
+ * C++20 build defines LWJSON_TEST_STATIC_PATH to require compile-time path tests.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include "lwjson/lwjson.hpp"
+
+#if LWJSON_TEST_STATIC_PATH && !LWJSON_CPP_STATIC_PATH
+#error "Compiler does not support class type template parameters, static path cannot be tested"
+#endif
+
+static_assert(std::is_same_v<std::iterator_traits<lwjson::token::iterator>::iterator_category, std::forward_iterator_tag>,
+              "Token iterator must be forward iterator");
+static_assert(sizeof(lwjson::token) == sizeof(const lwjson_token_t*), "Token view must be single pointer");
+static_assert(!std::is_copy_constructible_v<lwjson::document<4>>, "Document must not be copied");
+static_assert(lwjson::document<32>::capacity() == 32, "Capacity must be compile-time constant");
+
+static lwjson::document<64> doc;
+
+static const char* json = "{\"name\":\"sensor\",\"id\":42,\"scale\":1.5,\"on\":true,\"off\":false,\"none\":null,"
+                          "\"values\":[1,2,3],\"nested\":{\"list\":[{\"k\":\"a\"},{\"k\":\"b\",\"v\":7}]},\"empty\":[]}";
+
+/**
+ * \brief           Print test result
+ * \param[in]       name: Test name
+ * \param[in]       ok: Test result
+ */
+static void
+test_result(const char* name, bool ok) {
+    std::printf("%s test %s..\r\n", name, ok ? "passed" : "failed");
+}
+
+static void
+test_document() {
+    bool ok = doc.parse(json) == lwjsonOK && doc.parsed() && doc.root().is_object() && doc.tokens_used() == 19;
+
+    lwjson_doc_t d = doc.doc();
+    ok = ok && d.root == doc.root().get() && d.tokens_used == doc.tokens_used() && doc.get() != nullptr;
+    test_result("C++ document", ok);
+
+    /* Failed parsing leaves empty root */
+    lwjson::document<4> small;
+    test_result("C++ document error", small.parse(json) == lwjsonERRMEM && !small.parsed() && !small.root()
+                                          && !small["name"]);
+}
+
+static void
+test_token() {
+    bool ok = doc["name"].is_string() && doc["name"].str() == "sensor" && doc["name"].name() == "name"
+              && doc["id"].is_int() && doc["id"].get<int>() == 42 && doc["id"].get<long long>() == 42
+              && doc["scale"].is_real() && doc["scale"].get<double>() == 1.5 && doc["on"].is_bool()
+              && doc["on"].get<bool>() && doc["off"].is_bool() && !doc["off"].get<bool>() && doc["none"].is_null()
+              && doc["name"].get<std::string_view>() == "sensor" && doc["name"].type() == LWJSON_TYPE_STRING;
+
+    /* Missing members and type mismatches give empty values */
+    ok = ok && !doc["missing"] && doc["missing"].type() == LWJSON_TYPE_NULL && !doc["missing"].is_null()
+         && doc["missing"].str().empty() && doc["id"].str().empty() && doc["name"].get<int>() == 0
+         && !doc["values"][3] && !doc["name"][std::size_t(0)] && !doc["values"]["k"] && doc.root().name().empty();
+#if LWJSON_CFG_TOKEN_SPAN
+    ok = ok && doc["scale"].raw() == "1.5" && doc["values"].raw() == "[1,2,3]";
+#endif /* LWJSON_CFG_TOKEN_SPAN */
+    test_result("C++ token", ok);
+}
+
+static void
+test_iterator() {
+    lwjson::token values = doc["values"], list = doc.find("nested.list");
+    int sum = 0;
+
+    for (lwjson::token t : values) {
+        sum += t.get<int>();
+    }
+    bool ok = sum == 6 && values.size() == 3 && !values.empty() && doc["empty"].empty() && doc["empty"].size() == 0
+              && std::distance(values.begin(), values.end()) == 3 && values[1].get<int>() == 2
+              && doc["name"].begin() == doc["name"].end();
+
+    /* Standard algorithms work on children */
+    auto it = std::find_if(list.begin(), list.end(), [](lwjson::token t) { return t["k"].str() == "b"; });
+    ok = ok && it != list.end() && (*it)["v"].get<int>() == 7 && doc.find("nested.list.#.v").get<int>() == 7;
+
+    /* Object members are iterated in input order with names */
+    std::size_t members = 0;
+    for (lwjson::token t : doc.root()) {
+        ok = ok && !t.name().empty();
+        ++members;
+    }
+    ok = ok && members == 9 && doc.root().size() == 9;
+    lwjson::token::iterator i1 = values.begin(), i2 = i1++;
+    ok = ok && (*i2).get<int>() == 1 && (*i1).get<int>() == 2;
+    test_result("C++ iterator", ok);
+}
+
+#if LWJSON_CFG_TAPE
+static void
+test_tape() {
+    static std::uint64_t mem[512];
+    std::size_t len = 0;
+    lwjson::tape tape;
+
+    bool ok = !tape.opened() && !tape.root() && !tape.find("name");
+    lwjson_doc_t d = doc.doc();
+    if (lwjson_tape_export(&d, mem, sizeof(mem), &len) != lwjsonOK || tape.open(mem, len) != lwjsonOK) {
+        test_result("C++ tape", false);
+        return;
+    }
+
+    /* Tape views must give the same values as token views */
+    ok = ok && tape.opened() && tape.root().is_object() && tape.root().size() == doc.root().size()
+         && tape["name"].str() == "sensor" && tape["name"].name() == "name" && tape["id"].get<int>() == 42
+         && tape["scale"].get<double>() == 1.5 && tape["on"].get<bool>() && !tape["off"].get<bool>()
+         && tape["none"].is_null() && tape["values"][2].get<int>() == 3 && !tape["values"][3]
+         && tape["empty"].empty() && tape.find("nested.list.#.v").get<int>() == 7
+         && tape["nested"].find("list.#.k").str() == "a" && tape["nested"]["list"][1].find("v").get<int>() == 7
+         && !tape["nested"].find("name") && !tape["missing"] && tape["id"].str().empty();
+
+    int sum = 0;
+    for (lwjson::tape_token t : tape["values"]) {
+        sum += t.get<int>();
+    }
+    auto tl = tape.find("nested.list");
+    auto it = std::find_if(tl.begin(), tl.end(), [](lwjson::tape_token t) { return t["k"].str() == "b"; });
+    ok = ok && sum == 6 && it != tl.end() && (*it)["v"].get<int>() == 7;
+
+    tape.close();
+    ok = ok && !tape.opened() && !tape.find("name");
+    test_result("C++ tape", ok);
+}
+#endif /* LWJSON_CFG_TAPE */
+
+#if LWJSON_CPP_STATIC_PATH
+using path_any = lwjson::detail::static_path<"nested.list.#.v">;
+static_assert(path_any::count == 4 && path_any::valid, "Path must have 4 segments");
+static_assert(path_any::segments[2].any && !path_any::segments[3].any, "Only '#' segment matches any element");
+static_assert(path_any::segments[1].pos == 7 && path_any::segments[1].len == 4, "Segment must point to path string");
+static_assert(lwjson::detail::fixed_string("name").length() == 4, "Length must exclude termination");
+
+/**
+ * \brief           Compare compile-time lookup with \ref lwjson_find
+ * \tparam          P: Path literal
+ * \return          `true` when both lookups give the same token
+ */
+template<lwjson::detail::fixed_string P>
+static bool
+test_static_path_same() {
+    return doc.find<P>().get() == doc.find(P.data).get();
+}
+
+static void
+test_static_path() {
+    bool ok = doc.find<"name">().str() == "sensor" && doc.find<"nested.list.#.v">().get<int>() == 7
+              && doc.find<"nested.list.#.k">().str() == "a" && doc.find<"missing">().get() == nullptr
+              && doc.find<"name.k">().get() == nullptr && doc.find<"values.#.k">().get() == nullptr
+              && doc.find<"nested.#.k">().get() == nullptr;
+
+    /* Same results as run-time lookup, found and missing */
+    ok = ok && test_static_path_same<"id">() && test_static_path_same<"nested.list">()
+         && test_static_path_same<"nested.list.#.v">() && test_static_path_same<"nested.list.#.x">()
+         && test_static_path_same<"nested.x">() && test_static_path_same<"values.#.k">();
+
+    /* Relative to token and on empty view */
+    ok = ok && doc["nested"].find<"list.#.v">().get<int>() == 7 && doc["nested"]["list"][1].find<"k">().str() == "b"
+         && !lwjson::token().find<"name">() && !doc["values"].find<"name">();
+    test_result("C++ static path", ok);
+}
+#endif /* LWJSON_CPP_STATIC_PATH */
+
+int
+main() {
+    std::printf("...\r\nC++ wrapper..\r\n");
+    test_document();
+    test_token();
+    test_iterator();
+#if LWJSON_CFG_TAPE
+    test_tape();
+#endif /* LWJSON_CFG_TAPE */
+#if LWJSON_CPP_STATIC_PATH
+    test_static_path();
+#endif /* LWJSON_CPP_STATIC_PATH */
+    return 0;
+}